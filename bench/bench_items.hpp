@@ -0,0 +1,54 @@
+/*
+ * Item of XParam based lists, shared by benchmarks.
+ */
+#ifndef _PDN_BENCH_ITEMS_HPP_
+#define _PDN_BENCH_ITEMS_HPP_
+
+#ifdef	EXAMPLE_CODE
+#include <xparam.hpp>
+#else
+#include "pparam/xparam.hpp"
+#endif
+
+class Item;
+
+class ItemType : public pparam::XMixParam
+{
+public:
+	ItemType() : pparam::XMixParam("item") {}
+	Item *newT() throw (pparam::Exception);
+};
+
+class Item : public pparam::XMixParam
+{
+public:
+	typedef ItemType	Type;
+
+	Item() :
+		pparam::XMixParam("item"),
+		id("id", 0, -1),
+		name("name")
+	{
+		addParam(&id);
+		addParam(&name);
+	}
+	virtual void type(Type &_type) const
+	{
+	}
+	bool key(int &_key)
+	{
+		_key = id.get_value();
+
+		return true;
+	}
+
+	pparam::XIntParam<int>	id;
+	pparam::XTextParam	name;
+};
+
+inline Item *ItemType::newT() throw (pparam::Exception)
+{
+	return new Item;
+}
+
+#endif
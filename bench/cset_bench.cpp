@@ -0,0 +1,168 @@
+/*
+ * Throughput of concurrent readers/writers on XConcurrentSetParam against
+ * XListParam protected by an external rwlock.
+ *
+ * usage: cset_bench [threads] [elements] [write-percent] [seconds]
+ */
+#include <iostream>
+using std::cout;
+using std::endl;
+
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include <atomic>
+
+#ifdef	HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#ifdef	EXAMPLE_CODE
+#include <xparam.hpp>
+#include <xconcurrent.hpp>
+#else
+#include "pparam/xparam.hpp"
+#include "pparam/xconcurrent.hpp"
+#endif
+using namespace pparam;
+
+#include "bench_items.hpp"
+
+typedef XConcurrentSetParam<Item, int>	ConcurrentItems;
+typedef XListParam<Item, int>		ListItems;
+
+static int elements = 10000;
+static int writePercent = 10;
+static std::atomic<bool> stop(false);
+
+static ConcurrentItems *citems;
+static ListItems *litems;
+static pthread_rwlock_t llock;
+
+static unsigned next(unsigned &seed)
+{
+	seed = seed * 1103515245 + 12345;
+	return seed >> 8;
+}
+
+static void *concurrentWorker(void *arg)
+{
+	unsigned seed = (unsigned long)arg;
+	unsigned long ops = 0;
+	Item item;
+	XEpochDomain *domain = citems->get_domain();
+
+	while (!stop.load(std::memory_order_relaxed)) {
+		int key = next(seed) % elements;
+		if ((int)(next(seed) % 100) < writePercent) {
+			if (!citems->del(key)) {
+				item.id = key;
+				try {
+					citems->addT(item);
+				} catch (Exception &e) { }
+			}
+		} else {
+			XEpochDomain::Guard guard(domain);
+			Item *found = citems->find(key);
+			if (found && (found->id.get_value() != key)) abort();
+		}
+		++ ops;
+	}
+	return (void *)ops;
+}
+
+static void *listWorker(void *arg)
+{
+	unsigned seed = (unsigned long)arg;
+	unsigned long ops = 0;
+	Item item;
+
+	while (!stop.load(std::memory_order_relaxed)) {
+		int key = next(seed) % elements;
+		if ((int)(next(seed) % 100) < writePercent) {
+			pthread_rwlock_wrlock(&llock);
+			ListItems::iterator iter = litems->xdel_prepare(key);
+			if (iter != litems->end()) litems->xdel(iter);
+			else {
+				item.id = key;
+				try {
+					litems->addT(item);
+				} catch (Exception &e) { }
+			}
+			pthread_rwlock_unlock(&llock);
+		} else {
+			pthread_rwlock_rdlock(&llock);
+			ListItems::iterator iter = litems->find(key);
+			if ((iter != litems->end()) &&
+				(((Item *)*iter)->id.get_value() != key))
+				abort();
+			pthread_rwlock_unlock(&llock);
+		}
+		++ ops;
+	}
+	return (void *)ops;
+}
+
+static double run(const char *name, void *(*worker)(void *), int threads,
+							int seconds)
+{
+	pthread_t tids[threads];
+	struct timespec start, end;
+
+	stop = false;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int i = 0; i < threads; ++i)
+		pthread_create(&tids[i], NULL, worker, (void *)(long)(i + 1));
+	sleep(seconds);
+	stop = true;
+	unsigned long total = 0;
+	for (int i = 0; i < threads; ++i) {
+		void *ops;
+		pthread_join(tids[i], &ops);
+		total += (unsigned long)ops;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double secs = (end.tv_sec - start.tv_sec) +
+			(end.tv_nsec - start.tv_nsec) / 1e9;
+	double rate = total / secs;
+	cout << name << " threads=" << threads << " elements=" << elements
+		<< " write%=" << writePercent << " ops/s=" << (long)rate
+		<< endl;
+	return rate;
+}
+
+int main(int argc, char *argv[])
+{
+	int threads = (argc > 1) ? atoi(argv[1]) : 4;
+	int seconds = (argc > 4) ? atoi(argv[4]) : 2;
+	if (argc > 2) elements = atoi(argv[2]);
+	if (argc > 3) writePercent = atoi(argv[3]);
+
+	Item item;
+	citems = new ConcurrentItems("items", elements);
+	litems = new ListItems("items");
+	litems->enable_smap();
+	pthread_rwlock_init(&llock, NULL);
+	try {
+		for (int i = 0; i < elements; i += 2) {
+			item.id = i;
+			citems->addT(item);
+			litems->addT(item);
+		}
+	} catch (Exception &e) {
+		cout << e.what() << endl;
+		return -1;
+	}
+
+	double crate = run("xconcurrentsetparam", concurrentWorker,
+							threads, seconds);
+	double lrate = run("xlistparam+rwlock", listWorker, threads, seconds);
+	cout << "speedup=" << crate / lrate << endl;
+
+	delete citems;
+	delete litems;
+	pthread_rwlock_destroy(&llock);
+	return 0;
+}
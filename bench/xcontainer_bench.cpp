@@ -0,0 +1,781 @@
+/*
+ * Scan throughput, lookup latency and erase latency of XList, XListParam
+ * and XObjectList against std::list protected by a rwlock, with concurrent
+ * readers and writers.
+ *
+ * usage: xcontainer_bench [-c container] [-m mode] [-r readers]
+ *			[-w writers] [-n elements] [-s seconds] [-d] [-S] [-k]
+ *	-c: xlist, xlistparam, xobjectlist, xshardedlist, stdlist or all
+ *	    (default).
+ *	-m: scan, lookup, erase or all (default).
+ *	    scan: readers scan whole container, ops are visited elements.
+ *	    lookup: readers query random keys.
+ *	    erase: writers erase random keys (and add them back again).
+ *	    Writers churn container (erase + add) in all modes, just erase
+ *	    latency of writers would be measured in "erase" mode.
+ *	-d: free erased elements by XReclaimer, instead of waiting for
+ *	    readers in erase.
+ *	-S: stress mode, each thread randomly adds/erases his own keys,
+ *	    queries and scans the container, results would be verified at
+ *	    the end. Build with "configure --enable-tsan" to run it under
+ *	    ThreadSanitizer.
+ *	-k: objects of xobjectlist and xshardedlist have structural
+ *	    equivalency (XObject::has_structural_key), by default they
+ *	    don't and their structures aren't indexed.
+ *
+ * Each run would be reported by one line of "name=value" fields:
+ *	container=xlist mode=scan readers=4 writers=1 elements=1000
+ *		seconds=1.000 ops=... ops_per_sec=... avg_ns=... max_ns=...
+ * Stress runs report "ok=1" or "ok=0" (and exit with failure) instead of
+ * latencies, "-k" runs report "structkeys=1" too.
+ */
+#include <iostream>
+using std::cout;
+using std::endl;
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include <atomic>
+#include <list>
+#include <vector>
+#include <algorithm>
+
+#ifdef	HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#ifdef	EXAMPLE_CODE
+#include <xlist.hpp>
+#include <xparam.hpp>
+#include <xobject.hpp>
+#include <xreclaimer.hpp>
+#include <xshardedlist.hpp>
+#else
+#include "pparam/xlist.hpp"
+#include "pparam/xparam.hpp"
+#include "pparam/xobject.hpp"
+#include "pparam/xreclaimer.hpp"
+#include "pparam/xshardedlist.hpp"
+#endif
+using namespace pparam;
+
+#include "bench_items.hpp"
+
+class NodeKind
+{
+public:
+	enum Kind {
+		NODE,
+		KEYED,
+		MAX
+	};
+
+	static const string	typeString[MAX];
+};
+
+const string	NodeKind::typeString[NodeKind::MAX] = {
+					"node",
+					"keyed"
+					};
+
+class NodeType : public XMixParam
+{
+public:
+	typedef int	Literal;
+
+	NodeType(const string &objClass = "node") :
+		XMixParam(objClass),
+		kind("type", NodeKind::NODE)
+	{
+		addParam(&kind);
+	}
+	void set_type(Literal l)
+	{
+		kind = l;
+	}
+	Literal get_type() const
+	{
+		return kind.get_value();
+	}
+	XParam *getTypeParam()
+	{
+		return &kind;
+	}
+	string value() const
+	{
+		return kind.value();
+	}
+	XObject<NodeType> *newT();
+
+private:
+	XEnumParam<NodeKind>	kind;
+};
+
+class Node : public XObject<NodeType>
+{
+public:
+	Node() : XObject<NodeType>("node") {}
+
+protected:
+	void _add() {}
+	void _del() {}
+	void _mod(XObject<NodeType> *xo) {}
+};
+
+/**
+ * Node with structural equivalency, his key is his structural key.
+ */
+class KeyedNode : public Node
+{
+public:
+	KeyedNode()
+	{
+		set_type(NodeKind::KEYED);
+	}
+	void type(NodeType &t) const
+	{
+		t.set_type(NodeKind::KEYED);
+	}
+	bool has_structural_key() const
+	{
+		return true;
+	}
+	string structural_key() const
+	{
+		return get_key();
+	}
+};
+
+XObject<NodeType> *NodeType::newT()
+{
+	if (get_type() == NodeKind::KEYED) return new KeyedNode;
+	return new Node;
+}
+
+/**
+ * Object keys are uuids.
+ */
+static string keyString(int key)
+{
+	char str[40];
+	snprintf(str, sizeof(str), "00000000-0000-0000-0000-%012d", key);
+	return str;
+}
+
+/**
+ * Object lists add KeyedNodes instead of Nodes.
+ */
+static bool structKeys = false;
+
+static Node *newNode(int key)
+{
+	Node *node = structKeys ? new KeyedNode : new Node;
+	node->set_key(keyString(key));
+	node->set_name(keyString(key));
+	return node;
+}
+
+/**
+ * Common interface of benchmarked containers, elements are int keys.
+ */
+class Container
+{
+public:
+	virtual ~Container() {}
+	virtual const char *name() const = 0;
+	/**
+	 * Add "key", "key" shouldn't exist.
+	 */
+	virtual void add(int key) = 0;
+	/**
+	 * \return false: "key" doesn't exist.
+	 */
+	virtual bool erase(int key) = 0;
+	virtual bool lookup(int key) = 0;
+	/**
+	 * Visit all elements.
+	 * \return number of visited elements.
+	 */
+	virtual unsigned long scan() = 0;
+};
+
+class XListContainer : public Container
+{
+public:
+	XListContainer(XReclaimer *reclaimer)
+	{
+		if (reclaimer) list.set_reclaimer(reclaimer);
+	}
+	const char *name() const
+	{
+		return "xlist";
+	}
+	void add(int key)
+	{
+		list.push_back(key);
+	}
+	/* XList has no index, lookups are linear.
+	 */
+	bool erase(int key)
+	{
+		for (XList<int>::iterator iter = list.begin();
+					iter != list.end(); ++iter)
+			if (*iter == key) {
+				if (! list.xerase_prepare(iter)) return false;
+				list.xerase(iter);
+				return true;
+			}
+		return false;
+	}
+	bool lookup(int key)
+	{
+		for (XList<int>::iterator iter = list.begin();
+					iter != list.end(); ++iter)
+			if (*iter == key) return true;
+		return false;
+	}
+	unsigned long scan()
+	{
+		unsigned long visits = 0;
+		for (XList<int>::iterator iter = list.begin();
+					iter != list.end(); ++iter)
+			if (*iter >= 0) ++ visits;
+		return visits;
+	}
+
+private:
+	XList<int>	list;
+};
+
+/**
+ * XListParam with smap, smap is protected by "lock" the way XObjectList
+ * does; scans don't lock.
+ */
+class XListParamContainer : public Container
+{
+public:
+	typedef XListParam<Item, int>	Items;
+
+	XListParamContainer(XReclaimer *reclaimer) : items("items")
+	{
+		items.enable_smap();
+		if (reclaimer) items.set_reclaimer(reclaimer);
+		pthread_rwlock_init(&lock, NULL);
+	}
+	~XListParamContainer()
+	{
+		pthread_rwlock_destroy(&lock);
+	}
+	const char *name() const
+	{
+		return "xlistparam";
+	}
+	void add(int key)
+	{
+		Item item;
+		item.id = key;
+		pthread_rwlock_wrlock(&lock);
+		try {
+			items.addT(item);
+		} catch (Exception &e) {
+			cout << e.what() << endl;
+		}
+		pthread_rwlock_unlock(&lock);
+	}
+	bool erase(int key)
+	{
+		pthread_rwlock_wrlock(&lock);
+		Items::iterator iter = items.xdel_prepare(key);
+		pthread_rwlock_unlock(&lock);
+		if (iter == items.end()) return false;
+		items.xdel(iter);
+		return true;
+	}
+	bool lookup(int key)
+	{
+		pthread_rwlock_rdlock(&lock);
+		Items::iterator iter = items.find(key);
+		bool found = (iter != items.end()) &&
+				(((Item *)*iter)->id.get_value() == key);
+		pthread_rwlock_unlock(&lock);
+		return found;
+	}
+	unsigned long scan()
+	{
+		unsigned long visits = 0;
+		for (Items::iterator iter = items.begin();
+					iter != items.end(); ++iter)
+			if (*iter) ++ visits;
+		return visits;
+	}
+
+private:
+	Items			items;
+	pthread_rwlock_t	lock;
+};
+
+/**
+ * XObjectList allows one add()/one del() at a time, so writers are
+ * serialized by "wlock".
+ */
+class XObjectListContainer : public Container
+{
+public:
+	XObjectListContainer(XReclaimer *reclaimer) :
+		list("nodes", "xcontainer_bench")
+	{
+		if (reclaimer) list.set_reclaimer(reclaimer);
+		pthread_mutex_init(&wlock, NULL);
+	}
+	~XObjectListContainer()
+	{
+		pthread_mutex_destroy(&wlock);
+	}
+	const char *name() const
+	{
+		return "xobjectlist";
+	}
+	void add(int key)
+	{
+		Node *node = newNode(key);
+		pthread_mutex_lock(&wlock);
+		try {
+			list.add(node);
+		} catch (Exception &e) {
+			cout << e.what() << endl;
+		}
+		pthread_mutex_unlock(&wlock);
+		delete node;
+	}
+	bool erase(int key)
+	{
+		bool erased = true;
+		pthread_mutex_lock(&wlock);
+		try {
+			list.del(keyString(key));
+		} catch (Exception &e) {
+			erased = false;
+		}
+		pthread_mutex_unlock(&wlock);
+		return erased;
+	}
+	bool lookup(int key)
+	{
+		list.rdlock();
+		bool found = list.query(keyString(key)) != list.end();
+		list.unlock();
+		return found;
+	}
+	unsigned long scan()
+	{
+		unsigned long visits = 0;
+		for (Nodes::iterator iter = list.begin();
+					iter != list.end(); ++iter)
+			if (*iter) ++ visits;
+		return visits;
+	}
+
+private:
+	typedef XObjectList<NodeType>	Nodes;
+
+	Nodes			list;
+	pthread_mutex_t		wlock;
+};
+
+/**
+ * Writers of XShardedObjectList aren't serialized.
+ */
+class XShardedListContainer : public Container
+{
+public:
+	XShardedListContainer(XReclaimer *reclaimer) :
+		list("nodes", "xcontainer_bench")
+	{
+		if (reclaimer) list.set_reclaimer(reclaimer);
+	}
+	const char *name() const
+	{
+		return "xshardedlist";
+	}
+	void add(int key)
+	{
+		Node *node = newNode(key);
+		try {
+			list.add(node);
+		} catch (Exception &e) {
+			cout << e.what() << endl;
+		}
+		delete node;
+	}
+	bool erase(int key)
+	{
+		try {
+			list.del(keyString(key));
+		} catch (Exception &e) {
+			return false;
+		}
+		return true;
+	}
+	bool lookup(int key)
+	{
+		return list.query_lock(keyString(key)) != list.end();
+	}
+	unsigned long scan()
+	{
+		unsigned long visits = 0;
+		for (Nodes::iterator iter = list.begin();
+					iter != list.end(); ++iter)
+			if (*iter) ++ visits;
+		return visits;
+	}
+
+private:
+	typedef XShardedObjectList<NodeType>	Nodes;
+
+	Nodes	list;
+};
+
+class StdListContainer : public Container
+{
+public:
+	StdListContainer()
+	{
+		pthread_rwlock_init(&lock, NULL);
+	}
+	~StdListContainer()
+	{
+		pthread_rwlock_destroy(&lock);
+	}
+	const char *name() const
+	{
+		return "stdlist";
+	}
+	void add(int key)
+	{
+		pthread_rwlock_wrlock(&lock);
+		list.push_back(key);
+		pthread_rwlock_unlock(&lock);
+	}
+	bool erase(int key)
+	{
+		pthread_rwlock_wrlock(&lock);
+		std::list<int>::iterator iter =
+				std::find(list.begin(), list.end(), key);
+		bool found = iter != list.end();
+		if (found) list.erase(iter);
+		pthread_rwlock_unlock(&lock);
+		return found;
+	}
+	bool lookup(int key)
+	{
+		pthread_rwlock_rdlock(&lock);
+		bool found = std::find(list.begin(), list.end(), key) !=
+								list.end();
+		pthread_rwlock_unlock(&lock);
+		return found;
+	}
+	unsigned long scan()
+	{
+		unsigned long visits = 0;
+		pthread_rwlock_rdlock(&lock);
+		for (std::list<int>::iterator iter = list.begin();
+					iter != list.end(); ++iter)
+			if (*iter >= 0) ++ visits;
+		pthread_rwlock_unlock(&lock);
+		return visits;
+	}
+
+private:
+	std::list<int>		list;
+	pthread_rwlock_t	lock;
+};
+
+enum Mode {
+	SCAN,
+	LOOKUP,
+	ERASE,
+	STRESS
+};
+
+static const char *modeName[] = { "scan", "lookup", "erase", "stress" };
+
+static int elements = 1000;
+static std::atomic<bool> stop(false);
+
+/**
+ * State of one benchmark thread.
+ */
+struct Worker
+{
+	Container *container;
+	Mode mode;
+	/**
+	 * Thread "id" of "threads" owns keys: key % threads == id,
+	 * just owner adds/erases his keys.
+	 */
+	int id;
+	int threads;
+	unsigned seed;
+	pthread_t tid;
+
+	/**
+	 * Operations (visited elements in scans) and timed samples.
+	 */
+	unsigned long ops;
+	unsigned long samples;
+	unsigned long long sumNs;
+	unsigned long long maxNs;
+	/**
+	 * Stress results: owned keys present at the end, verification.
+	 */
+	unsigned long present;
+	bool ok;
+};
+
+static unsigned next(unsigned &seed)
+{
+	seed = seed * 1103515245 + 12345;
+	return seed >> 8;
+}
+
+static unsigned long long nsec()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void account(Worker *w, unsigned long long start, unsigned long ops)
+{
+	unsigned long long ns = nsec() - start;
+	w->ops += ops;
+	++ w->samples;
+	w->sumNs += ns;
+	if (ns > w->maxNs) w->maxNs = ns;
+}
+
+/**
+ * Random owned key of "w".
+ */
+static int ownKey(Worker *w)
+{
+	int slots = (elements - w->id + w->threads - 1) / w->threads;
+	return w->id + (int)(next(w->seed) % slots) * w->threads;
+}
+
+static void *reader(void *arg)
+{
+	Worker *w = (Worker *)arg;
+	while (!stop.load(std::memory_order_relaxed)) {
+		unsigned long long start = nsec();
+		if (w->mode == LOOKUP) {
+			w->container->lookup(next(w->seed) % elements);
+			account(w, start, 1);
+		} else account(w, start, w->container->scan());
+	}
+	return NULL;
+}
+
+static void *writer(void *arg)
+{
+	Worker *w = (Worker *)arg;
+	while (!stop.load(std::memory_order_relaxed)) {
+		int key = ownKey(w);
+		unsigned long long start = nsec();
+		bool erased = w->container->erase(key);
+		if (w->mode == ERASE) account(w, start, 1);
+		if (erased) w->container->add(key);
+	}
+	return NULL;
+}
+
+static void *stresser(void *arg)
+{
+	Worker *w = (Worker *)arg;
+	std::vector<bool> present(elements, true);
+
+	while (!stop.load(std::memory_order_relaxed)) {
+		int key = ownKey(w);
+		switch (next(w->seed) % 4) {
+		case 0:
+			/* Scans aren't snapshots: an element erased and
+			 * added again by others could be visited twice.
+			 */
+			w->container->scan();
+			break;
+		case 1:
+			if (w->container->lookup(key) != present[key])
+				w->ok = false;
+			break;
+		default:
+			if (present[key]) {
+				if (! w->container->erase(key)) w->ok = false;
+			} else w->container->add(key);
+			present[key] = !present[key];
+			break;
+		}
+		++ w->ops;
+	}
+	for (int key = w->id; key < elements; key += w->threads) {
+		if (w->container->lookup(key) != present[key]) w->ok = false;
+		if (present[key]) ++ w->present;
+	}
+	return NULL;
+}
+
+static bool run(Container *container, Mode mode, int readers, int writers,
+							int seconds)
+{
+	int threads = readers + writers;
+	std::vector<Worker> workers(threads);
+	struct timespec start, end;
+
+	for (int key = 0; key < elements; ++key) container->add(key);
+
+	stop = false;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int i = 0; i < threads; ++i) {
+		Worker &w = workers[i];
+		memset(&w, 0, sizeof(w));
+		w.container = container;
+		w.mode = mode;
+		w.seed = i + 1;
+		w.ok = true;
+		if (mode == STRESS) {
+			w.id = i;
+			w.threads = threads;
+			pthread_create(&w.tid, NULL, stresser, &w);
+		} else if (i < readers)
+			pthread_create(&w.tid, NULL, reader, &w);
+		else {
+			w.id = i - readers;
+			w.threads = writers;
+			pthread_create(&w.tid, NULL, writer, &w);
+		}
+	}
+	sleep(seconds);
+	stop = true;
+	for (int i = 0; i < threads; ++i) pthread_join(workers[i].tid, NULL);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double secs = (end.tv_sec - start.tv_sec) +
+			(end.tv_nsec - start.tv_nsec) / 1e9;
+
+	/* Readers for scan/lookup, writers for erase.
+	 */
+	int from = (mode == ERASE) ? readers : 0;
+	int to = (mode == ERASE || mode == STRESS) ? threads : readers;
+	unsigned long ops = 0, samples = 0, present = 0;
+	unsigned long long sumNs = 0, maxNs = 0;
+	bool ok = true;
+	for (int i = from; i < to; ++i) {
+		ops += workers[i].ops;
+		samples += workers[i].samples;
+		sumNs += workers[i].sumNs;
+		if (workers[i].maxNs > maxNs) maxNs = workers[i].maxNs;
+		present += workers[i].present;
+		ok = ok && workers[i].ok;
+	}
+
+	char line[512];
+	int len = snprintf(line, sizeof(line), "container=%s mode=%s "
+			"readers=%d writers=%d elements=%d seconds=%.3f "
+			"ops=%lu ops_per_sec=%.0f", container->name(),
+			modeName[mode], readers, writers, elements, secs,
+			ops, ops / secs);
+	if (structKeys)
+		len += snprintf(line + len, sizeof(line) - len,
+							" structkeys=1");
+	if (mode == STRESS) {
+		ok = ok && (container->scan() == present);
+		snprintf(line + len, sizeof(line) - len, " ok=%d", ok);
+	} else {
+		/* Latency of one whole scan in scan mode.
+		 */
+		snprintf(line + len, sizeof(line) - len,
+			" avg_ns=%.0f max_ns=%llu",
+			samples ? (double)sumNs / samples : 0.0, maxNs);
+	}
+	cout << line << endl;
+	return ok;
+}
+
+static Container *newContainer(const string &name, XReclaimer *reclaimer)
+{
+	if (name == "xlist") return new XListContainer(reclaimer);
+	if (name == "xlistparam") return new XListParamContainer(reclaimer);
+	if (name == "xobjectlist") return new XObjectListContainer(reclaimer);
+	if (name == "xshardedlist")
+		return new XShardedListContainer(reclaimer);
+	if (name == "stdlist") return new StdListContainer;
+	return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+	const char *containers[] = { "xlist", "xlistparam", "xobjectlist",
+					"xshardedlist", "stdlist" };
+	string container = "all", mode = "all";
+	int readers = 4, writers = 1, seconds = 1;
+	bool stress = false, deferred = false;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "c:m:r:w:n:s:dSk")) != -1) {
+		switch (opt) {
+		case 'c': container = optarg; break;
+		case 'm': mode = optarg; break;
+		case 'r': readers = atoi(optarg); break;
+		case 'w': writers = atoi(optarg); break;
+		case 'n': elements = atoi(optarg); break;
+		case 's': seconds = atoi(optarg); break;
+		case 'd': deferred = true; break;
+		case 'S': stress = true; break;
+		case 'k': structKeys = true; break;
+		default:
+			cout << "usage: " << argv[0] << " [-c container] "
+				"[-m mode] [-r readers] [-w writers] "
+				"[-n elements] [-s seconds] [-d] [-S] [-k]"
+				<< endl;
+			return -1;
+		}
+	}
+	if (elements < 1 || readers < 0 || writers < 0 ||
+					(readers + writers) < 1) {
+		cout << "invalid thread or element count" << endl;
+		return -1;
+	}
+
+	std::vector<Mode> modes;
+	if (stress) modes.push_back(STRESS);
+	else for (int m = SCAN; m <= ERASE; ++m)
+		if (mode == "all" || mode == modeName[m])
+			modes.push_back((Mode)m);
+
+	XReclaimer *reclaimer = deferred ? XReclaimer::global() : NULL;
+	bool ok = true;
+	int runs = 0;
+	for (unsigned c = 0; c < sizeof(containers) / sizeof(*containers);
+									++c) {
+		if (container != "all" && container != containers[c])
+			continue;
+		for (unsigned m = 0; m < modes.size(); ++m) {
+			/* Erase mode needs writers.
+			 */
+			int w = (modes[m] == ERASE && !writers) ? 1 : writers;
+			Container *cont = newContainer(containers[c],
+								reclaimer);
+			ok = run(cont, modes[m], readers, w, seconds) && ok;
+			delete cont;
+			++ runs;
+		}
+	}
+	if (!runs) {
+		cout << "unknown container or mode" << endl;
+		return -1;
+	}
+	return ok ? 0 : 1;
+}
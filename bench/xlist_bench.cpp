@@ -0,0 +1,144 @@
+/*
+ * Reader scaling of XList (per-node locks and usage counters) against
+ * XEpochList (epoch based reclamation), with one concurrent writer.
+ *
+ * usage: xlist_bench [max-threads] [elements] [seconds]
+ * Readers would be run by 1, 2, 4, ... max-threads threads.
+ */
+#include <iostream>
+using std::cout;
+using std::endl;
+
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include <atomic>
+
+#ifdef	HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#ifdef	EXAMPLE_CODE
+#include <xlist.hpp>
+#include <xepochlist.hpp>
+#else
+#include "pparam/xlist.hpp"
+#include "pparam/xepochlist.hpp"
+#endif
+using namespace pparam;
+
+static int elements = 1000;
+static std::atomic<bool> stop(false);
+static XList<long> *xlist;
+static XEpochList<long> *elist;
+
+static void *xlistReader(void *arg)
+{
+	unsigned long visits = 0;
+	long sum = 0;
+	while (!stop.load(std::memory_order_relaxed)) {
+		for (XList<long>::iterator iter = xlist->begin();
+					iter != xlist->end(); ++iter) {
+			sum += *iter;
+			++ visits;
+		}
+	}
+	if (sum == 1) cout << "";
+	return (void *)visits;
+}
+
+static void *xlistWriter(void *arg)
+{
+	long val = elements;
+	while (!stop.load(std::memory_order_relaxed)) {
+		XList<long>::iterator iter = xlist->begin();
+		if (xlist->xerase_prepare(iter)) xlist->xerase(iter);
+		xlist->push_back(val++);
+		usleep(100);
+	}
+	return NULL;
+}
+
+static void *elistReader(void *arg)
+{
+	unsigned long visits = 0;
+	long sum = 0;
+	XEpochDomain *domain = elist->get_domain();
+	while (!stop.load(std::memory_order_relaxed)) {
+		XEpochDomain::Guard guard(domain);
+		for (XEpochList<long>::iterator iter = elist->begin();
+					iter != elist->end(); ++iter) {
+			sum += *iter;
+			++ visits;
+		}
+	}
+	if (sum == 1) cout << "";
+	return (void *)visits;
+}
+
+static void *elistWriter(void *arg)
+{
+	long val = elements;
+	while (!stop.load(std::memory_order_relaxed)) {
+		XEpochList<long>::iterator iter = elist->begin();
+		if (elist->xerase_prepare(iter)) elist->xerase(iter);
+		elist->push_back(val++);
+		usleep(100);
+	}
+	return NULL;
+}
+
+static double run(const char *name, void *(*reader)(void *),
+			void *(*writer)(void *), int threads, int seconds)
+{
+	pthread_t tids[threads], wtid;
+	struct timespec start, end;
+
+	stop = false;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	pthread_create(&wtid, NULL, writer, NULL);
+	for (int i = 0; i < threads; ++i)
+		pthread_create(&tids[i], NULL, reader, NULL);
+	sleep(seconds);
+	stop = true;
+	unsigned long total = 0;
+	for (int i = 0; i < threads; ++i) {
+		void *visits;
+		pthread_join(tids[i], &visits);
+		total += (unsigned long)visits;
+	}
+	pthread_join(wtid, NULL);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double secs = (end.tv_sec - start.tv_sec) +
+			(end.tv_nsec - start.tv_nsec) / 1e9;
+	double rate = total / secs;
+	cout << name << " readers=" << threads << " elements=" << elements
+		<< " visits/s=" << (long)rate << endl;
+	return rate;
+}
+
+int main(int argc, char *argv[])
+{
+	int maxThreads = (argc > 1) ? atoi(argv[1]) : 64;
+	int seconds = (argc > 3) ? atoi(argv[3]) : 1;
+	if (argc > 2) elements = atoi(argv[2]);
+
+	xlist = new XList<long>;
+	elist = new XEpochList<long>;
+	for (long i = 0; i < elements; ++i) {
+		xlist->push_back(i);
+		elist->push_back(i);
+	}
+	for (int threads = 1; threads <= maxThreads; threads *= 2) {
+		double x = run("xlist", xlistReader, xlistWriter,
+							threads, seconds);
+		double e = run("xepochlist", elistReader, elistWriter,
+							threads, seconds);
+		cout << "readers=" << threads << " speedup=" << e / x << endl;
+	}
+	delete xlist;
+	delete elist;
+	return 0;
+}
@@ -0,0 +1,142 @@
+/*
+ * Stress of concurrent writers on XList: writers push_back, push_front
+ * and erase at both ends of list, while readers iterate list forward and
+ * backward. Build with "configure --enable-tsan" to run it under
+ * ThreadSanitizer.
+ *
+ * usage: xlist_stress [writers] [readers] [ops-per-writer] [reclaim]
+ *
+ * By default erased nodes would be freed by a reclaimer, so a run is
+ * clean under LeakSanitizer too. With "reclaim" of "0" erasers would
+ * destroy nodes themselves; that path never frees memory of nodes (the
+ * eraser's iterator still points to the node), so LeakSanitizer would
+ * report every node, nodes erased by "clear" at the end too.
+ *
+ * At the end, size of list, forward walk and backward walk would be
+ * compared with pushes minus erases, and sum of elements with sum of
+ * pushed minus erased values. Result would be reported by one line of
+ * "name=value" fields, "ok=0" runs exit with failure.
+ */
+#include <iostream>
+using std::cout;
+using std::endl;
+
+#include <stdlib.h>
+#include <pthread.h>
+
+#include <atomic>
+#include <vector>
+#include <algorithm>
+
+#ifdef	HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#ifdef	EXAMPLE_CODE
+#include <xlist.hpp>
+#include <xreclaimer.hpp>
+#else
+#include "pparam/xlist.hpp"
+#include "pparam/xreclaimer.hpp"
+#endif
+using namespace pparam;
+
+typedef XList<long>	List;
+
+static List *xlist;
+static long writers = 4;
+static long ops = 4000;
+static XReclaimer *reclaimer = NULL;
+static std::atomic<bool> stop(false);
+static std::atomic<long> pushed(0), erased(0);
+static std::atomic<long> pushedSum(0), erasedSum(0);
+
+static void *reader(void *arg)
+{
+	long sum = 0;
+	while (!stop.load(std::memory_order_relaxed)) {
+		for (List::iterator iter = xlist->begin();
+					iter != xlist->end(); ++iter)
+			sum += *iter;
+		for (List::iterator iter = --xlist->end();
+					iter != xlist->end(); --iter)
+			sum += *iter;
+	}
+	if (sum == 1) cout << "";
+	return NULL;
+}
+
+static void *writer(void *arg)
+{
+	long id = (long)arg;
+	for (long n = 0; n < ops; ++n) {
+		/* Values are unique between writers.
+		 */
+		long val = n * writers + id;
+		if (n & 1) xlist->push_back(val);
+		else xlist->push_front(val);
+		++ pushed;
+		pushedSum += val;
+		if (n % 3) continue;
+		List::iterator iter = (id & 1) ? xlist->begin() :
+							--xlist->end();
+		if (iter.on_element() && xlist->xerase_prepare(iter)) {
+			long v = *iter;
+			xlist->xerase(iter);
+			++ erased;
+			erasedSum += v;
+		}
+		/* Without reclaimer node has been destroyed, so iterator 
+		 * couldn't release him.
+		 */
+		if (reclaimer) iter.fini();
+		else iter.reset();
+	}
+	return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc > 1) writers = atol(argv[1]);
+	int readers = (argc > 2) ? atoi(argv[2]) : 3;
+	if (argc > 3) ops = atol(argv[3]);
+	if ((argc <= 4) || atoi(argv[4])) reclaimer = new XReclaimer;
+
+	xlist = new List;
+	xlist->set_reclaimer(reclaimer);
+	std::vector<pthread_t> rtids(readers), wtids(writers);
+	for (int i = 0; i < readers; ++i)
+		pthread_create(&rtids[i], NULL, reader, NULL);
+	for (long i = 0; i < writers; ++i)
+		pthread_create(&wtids[i], NULL, writer, (void *)i);
+	for (long i = 0; i < writers; ++i)
+		pthread_join(wtids[i], NULL);
+	stop = true;
+	for (int i = 0; i < readers; ++i)
+		pthread_join(rtids[i], NULL);
+
+	std::vector<long> forward, backward;
+	long sum = 0;
+	for (List::iterator iter = xlist->begin();
+				iter != xlist->end(); ++iter) {
+		forward.push_back(*iter);
+		sum += *iter;
+	}
+	for (List::iterator iter = --xlist->end();
+				iter != xlist->end(); --iter)
+		backward.push_back(*iter);
+	long expect = pushed - erased;
+	bool ok = ((long)xlist->size() == expect) &&
+		((long)forward.size() == expect) &&
+		(backward.size() == forward.size()) &&
+		std::equal(forward.begin(), forward.end(),
+						backward.rbegin()) &&
+		(sum == pushedSum - erasedSum);
+	cout << "writers=" << writers << " readers=" << readers
+		<< " pushed=" << pushed << " erased=" << erased
+		<< " size=" << xlist->size() << " reclaim=" 
+		<< (reclaimer != NULL) << " ok=" << ok << endl;
+	delete xlist;
+	delete reclaimer;
+	return ok ? 0 : 1;
+}
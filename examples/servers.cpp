@@ -9,9 +9,11 @@ using std::endl;
 #ifdef	EXAMPLE_CODE
 #include <sparam.hpp>
 #include <xparam.hpp>
+#include <xselector.hpp>
 #else
 #include "pparam/sparam.hpp"
 #include "pparam/xparam.hpp"
+#include "pparam/xselector.hpp"
 #endif
 using namespace pparam;
 
@@ -77,5 +79,11 @@ int main()
 
 	cout << servers.xml(false, 8, true);
 
+	/* Compile once, evaluate many times.
+	 */
+	XParamSelector cpuOf("server[ip=192.168.0.1/24]/cpu_usage");
+	XParam *cpu = cpuOf.first(&servers);
+	if (cpu) cout << "cpu usage of 192.168.0.1: " << cpu->value() << endl;
+
 	return 0;
 }
@@ -24,6 +24,8 @@
 
 #include "logs.hpp"
 
+#include <errno.h>
+
 #include <deque>
 #include <string>
 using std::string;
@@ -112,11 +114,19 @@ public:
 	}
 	void set_errno(Int _errno)
 	{
-		errno = _errno;
+		err = _errno;
 	}
 	Int get_errno() const
 	{
-		return errno;
+		return err;
+	}
+	/**
+	 * Did operation fail because its deadline passed?
+	 * \see XDeadline
+	 */
+	bool is_timedout() const
+	{
+		return err == ETIMEDOUT;
 	}
 	void set_description(const char *description)
 	{
@@ -26,6 +26,8 @@
 #include <openssl/md5.h>
 
 #include <stdio.h>
+#include <stdint.h>
+#include <string.h>
 #include <uuid/uuid.h>
 #include <string>
 #include <ctime>
@@ -35,6 +37,49 @@
 namespace pparam
 {
 
+/**
+ * \struct UUIDKey
+ * Binary form of uuid.
+ *
+ * Uuids would be compared and hashed in this form, without unparsing
+ * them to strings.
+ */
+struct UUIDKey
+{
+	UUIDKey() : hi(0), lo(0)
+	{ }
+	explicit UUIDKey(const uuid_t uuid)
+	{
+		memcpy(&hi, uuid, sizeof(hi));
+		memcpy(&lo, uuid + sizeof(hi), sizeof(lo));
+	}
+	/**
+	 * Parse textual uuid.
+	 * \return false: bad uuid.
+	 */
+	bool parse(const string &str);
+	bool operator == (const UUIDKey &k) const
+	{
+		return (hi == k.hi) && (lo == k.lo);
+	}
+	bool operator != (const UUIDKey &k) const
+	{
+		return (hi != k.hi) || (lo != k.lo);
+	}
+	struct Hash
+	{
+		size_t operator()(const UUIDKey &k) const
+		{
+			/* uuids are random enough.
+			 */
+			return (size_t)(k.hi ^ k.lo);
+		}
+	};
+
+	uint64_t hi;
+	uint64_t lo;
+};
+
 /**
  * \class UUIDParam
  * \author Hamid Jafarian(hamid.jafarian@pdnsoft.com)
@@ -59,6 +104,13 @@ public:
 	{
 		uuid_generate(uuid);
 	}
+	/**
+	 * Binary value of uuid.
+	 */
+	UUIDKey key() const
+	{
+		return UUIDKey(uuid);
+	}
 private:
 	uuid_t uuid;
 };
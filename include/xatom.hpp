@@ -0,0 +1,202 @@
+/**
+ * \file xatom.hpp
+ * Defines interned strings.
+ *
+ * Small vocabularies like names and roles of connections would be stored
+ * once, and compared by their addresses.
+ *
+ * Copyright 2014 PDNSoft Co. (www.pdnsoft.com)
+ * \author hamid jafarian (hamid.jafarian@pdnsoft.com)
+ *
+ * xatom is part of PParam.
+ *
+ * PParam is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PParam is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PParam.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _PDN_XATOM_HPP_
+#define _PDN_XATOM_HPP_
+
+#include <pthread.h>
+
+#include <atomic>
+#include <string>
+#include <unordered_map>
+
+namespace pparam
+{
+
+using std::string;
+
+/**
+ * \class XAtom
+ * Interned string.
+ *
+ * Equal strings would have one copy in the atom table, so atoms are
+ * compared by pointer and copied without allocation.
+ * \code
+ * 	XAtom a("parent"), b(string("parent"));
+ * 	if (a == b) ...			// pointer compare
+ * 	string s = "<role>" + a + "</role>";
+ * \endcode
+ * Atoms are counted, string of atom would be removed from the table
+ * when there isn't any XAtom of him; copies increase the count.
+ */
+class XAtom
+{
+public:
+	XAtom() : atom(none())
+	{ }
+	XAtom(const string &str) : atom(intern(str))
+	{ }
+	XAtom(const char *str) : atom(intern(str))
+	{ }
+	XAtom(const XAtom &a) : atom(a.atom)
+	{
+		hold(atom);
+	}
+	XAtom &operator = (const XAtom &a)
+	{
+		hold(a.atom);
+		release(atom);
+		atom = a.atom;
+		return *this;
+	}
+	XAtom &operator = (const string &str)
+	{
+		Atom *a = intern(str);
+		release(atom);
+		atom = a;
+		return *this;
+	}
+	XAtom &operator = (const char *str)
+	{
+		return *this = string(str);
+	}
+	~XAtom()
+	{
+		release(atom);
+	}
+	const string &str() const
+	{
+		return atom->first;
+	}
+	operator const string &() const
+	{
+		return atom->first;
+	}
+	bool empty() const
+	{
+		return atom->first.empty();
+	}
+	/**
+	 * Identity of the atom, equal strings have equal ids.
+	 */
+	const void *id() const
+	{
+		return atom;
+	}
+	/**
+	 * Number of strings in the atom table.
+	 */
+	static size_t count();
+
+private:
+	typedef std::unordered_map<string, std::atomic<unsigned long> >
+								Atoms;
+	/**
+	 * Entry of the atom table, string and number of his XAtoms.
+	 */
+	typedef Atoms::value_type Atom;
+
+	/**
+	 * Find (or insert) "str" in the atom table, and count the
+	 * returned atom.
+	 */
+	static Atom *intern(const string &str);
+	/**
+	 * Atom of the empty string, he isn't counted and wouldn't be
+	 * removed.
+	 */
+	static Atom *none();
+	static void init();
+	static void hold(Atom *a)
+	{
+		if (a != emptyAtom) ++ a->second;
+	}
+	/**
+	 * Uncount "a", the last XAtom of a string would remove him
+	 * under write lock of table, so intern() couldn't find him
+	 * meanwhile.
+	 */
+	static void release(Atom *a);
+
+	Atom *atom;
+
+	static Atoms *atoms;
+	static Atom *emptyAtom;
+	static pthread_rwlock_t lock;
+	static pthread_once_t once;
+};
+
+inline bool operator == (const XAtom &a, const XAtom &b)
+{
+	return a.id() == b.id();
+}
+inline bool operator != (const XAtom &a, const XAtom &b)
+{
+	return a.id() != b.id();
+}
+inline bool operator == (const XAtom &a, const string &b)
+{
+	return a.str() == b;
+}
+inline bool operator != (const XAtom &a, const string &b)
+{
+	return a.str() != b;
+}
+inline bool operator == (const string &a, const XAtom &b)
+{
+	return a == b.str();
+}
+inline bool operator != (const string &a, const XAtom &b)
+{
+	return a != b.str();
+}
+inline bool operator == (const XAtom &a, const char *b)
+{
+	return a.str() == b;
+}
+inline bool operator != (const XAtom &a, const char *b)
+{
+	return a.str() != b;
+}
+inline string operator + (const string &a, const XAtom &b)
+{
+	return a + b.str();
+}
+inline string operator + (const XAtom &a, const string &b)
+{
+	return a.str() + b;
+}
+inline string operator + (const char *a, const XAtom &b)
+{
+	return a + b.str();
+}
+inline string operator + (const XAtom &a, const char *b)
+{
+	return a.str() + b;
+}
+
+} // namespace pparam
+
+#endif // _PDN_XATOM_HPP_
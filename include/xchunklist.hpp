@@ -0,0 +1,724 @@
+/**
+ * \file xchunklist.hpp
+ * Defines unrolled list that manages concurrent access per chunk.
+ *
+ * Elements are kept in chunks of N slots, so scans touch one node per
+ * N elements, and steps in a chunk don't take any lock. Usage of
+ * elements would be recorded per chunk: erased elements would be
+ * destroyed when the last iteration leaves their chunk.
+ *
+ * Copyright 2014 PDNSoft Co. (www.pdnsoft.com)
+ * \author hamid jafarian (hamid.jafarian@pdnsoft.com)
+ *
+ * xchunklist is part of PParam.
+ *
+ * PParam is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PParam is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+#ifndef _PDN_XCHUNKLIST_HPP_
+#define _PDN_XCHUNKLIST_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sched.h>
+
+#include <new>
+#include <atomic>
+#include <iterator>
+#include <vector>
+#include <type_traits>
+
+#include "xlist.hpp"
+
+namespace pparam
+{
+
+template <typename T, unsigned N>
+class XChunkList;
+
+/**
+ * \class _XChunk_base
+ * Common part of a chunk in %XChunkList.
+ *
+ * Lock and usage number of _XListNode_base are used for the chunk;
+ * iterations would "access" the chunk they are in. Each slot of chunk is
+ * "live" (could be seen by iterations), "zombie" (erased, waiting for
+ * destruction) or free. Slots would be filled in order and never reused.
+ */
+class _XChunk_base : public _XListNode_base
+{
+public:
+	_XChunk_base() :
+		live(0),
+		zombie(0),
+		constructed(0),
+		used(0),
+		unlinked(false)
+	{ }
+
+	/**
+	 * Slots that iterations could see.
+	 */
+	std::atomic<uint64_t> live;
+	/**
+	 * Erased slots, waiting for destruction.
+	 */
+	std::atomic<uint64_t> zombie;
+	/**
+	 * Number of slots with data (live or zombie).
+	 */
+	std::atomic<unsigned> constructed;
+	/**
+	 * Number of filled slots, just used by writer.
+	 */
+	unsigned used;
+	/**
+	 * Chunk has been removed from list.
+	 */
+	std::atomic<bool> unlinked;
+
+protected:
+	enum {
+		/**
+		 * Chunk has new zombie slots.
+		 * Chunks aren't erased by "erasing", so bit of ERASING
+		 * is used.
+		 */
+		DIRTY = ERASING
+	};
+};
+
+/**
+ * \class XChunk
+ * Chunk of %XChunkList, containor of actual data.
+ */
+template <typename T, unsigned N>
+class XChunk : public _XChunk_base
+{
+public:
+	typedef void (*FT_disposeData)(T &data);
+
+	XChunk() : disposeData(NULL) {}
+
+	T *slot(unsigned i)
+	{
+		return reinterpret_cast<T *>(&slots[i]);
+	}
+	/**
+	 * New iteration in the chunk.
+	 */
+	void enter()
+	{
+		access();
+	}
+	/**
+	 * End of iteration in the chunk.
+	 *
+	 * Last iteration that leaves the chunk would destroy zombie slots,
+	 * and would free the chunk if he has been removed from list and
+	 * all of his slots destroyed. So chunk shouldn't be touched after
+	 * leave.
+	 */
+	void leave()
+	{
+		unsigned s = state.load();
+		while (1) {
+			if ((s >> USAGE_SHIFT) > 1) {
+				if (state.compare_exchange_weak(s, s - USAGE_ONE))
+					return;
+				continue;
+			}
+			/* This is the last iteration in the chunk.
+			 */
+			if (s & DIRTY) {
+				state.fetch_and(~DIRTY);
+				destroyZombies();
+				s = state.load();
+				continue;
+			}
+			bool last = unlinked.load() && (constructed.load() == 0);
+			if (last && (s & LOCKED)) {
+				/* Another iteration is stepping out of chunk.
+				 */
+				sched_yield();
+				s = state.load();
+				continue;
+			}
+			if (state.compare_exchange_weak(s, s - USAGE_ONE)) {
+				if (last) free();
+				return;
+			}
+		}
+	}
+	/**
+	 * Mark erased slot "i" to be destroyed by last iteration.
+	 * Caller should be in the chunk.
+	 */
+	void retire(unsigned i, FT_disposeData dispose)
+	{
+		disposeData.store(dispose);
+		zombie.fetch_or((uint64_t)1 << i);
+		state.fetch_or(DIRTY);
+	}
+	/**
+	 * Destroy data of zombie slots.
+	 */
+	void destroyZombies()
+	{
+		uint64_t m = zombie.exchange(0);
+		if (! m) return;
+		FT_disposeData dispose = disposeData.load();
+		unsigned n = 0;
+		for (unsigned i = 0; i < N; ++i) {
+			if (! (m & ((uint64_t)1 << i))) continue;
+			if (dispose) dispose(*slot(i));
+			slot(i)->~T();
+			++ n;
+		}
+		constructed -= n;
+	}
+
+private:
+	/**
+	 * Free removed chunk.
+	 * Pointers of removed chunk have pinned his neighbours, so they
+	 * would be released.
+	 */
+	void free()
+	{
+		XChunk *next = static_cast<XChunk *>(_M_next);
+		XChunk *prev = static_cast<XChunk *>(_M_prev);
+		delete this;
+		next->leave();
+		prev->leave();
+	}
+
+	/**
+	 * Function to free data of zombie slots.
+	 */
+	std::atomic<FT_disposeData> disposeData;
+	typename std::aligned_storage<sizeof(T),
+				std::alignment_of<T>::value>::type slots[N];
+};
+
+/**
+ * \class _XChunkListIterator_base
+ * Common part of iterators of %XChunkList.
+ *
+ * Iterator is a chunk and a slot in him; iterator would "enter" the
+ * chunk, steps in chunk don't lock anything, and steps between chunks
+ * would lock the chunk that is left, like of XList iterators.
+ */
+template <typename T, unsigned N>
+class _XChunkListIterator_base
+{
+	friend class XChunkList<T, N>;
+public:
+	typedef _XChunkListIterator_base<T, N>		_Base;
+	typedef XChunk<T, N>				_XChunk;
+
+	_XChunkListIterator_base() : chunk(NULL), idx(0), list_end(NULL) {}
+	_XChunkListIterator_base(_XChunk *_list_end) :
+		chunk(_list_end), idx(0), list_end(_list_end)
+	{ }
+	_XChunkListIterator_base(const _Base &xiter) :
+		chunk(xiter.chunk), idx(xiter.idx), list_end(xiter.list_end)
+	{
+		enter();
+	}
+	_Base &operator=(const _Base &rvalue)
+	{
+		_XChunk *old = chunk, *old_end = list_end;
+		chunk = rvalue.chunk;
+		idx = rvalue.idx;
+		list_end = rvalue.list_end;
+		/* Enter before leave, "old" may be same chunk.
+		 */
+		enter();
+		if (old && (old != old_end)) old->leave();
+		return *this;
+	}
+	/**
+	 * Finalize the iteration, leave current chunk.
+	 */
+	void fini()
+	{
+		leave();
+		chunk = list_end = NULL;
+		idx = 0;
+	}
+	/**
+	 * Same as of "fini", iterators of %XChunkList don't need reset
+	 * after deletion.
+	 */
+	void reset()
+	{
+		fini();
+	}
+	bool is_finied()
+	{
+		return chunk == NULL;
+	}
+	bool is_end()
+	{
+		return chunk == list_end;
+	}
+	bool on_element()
+	{
+		return chunk && (chunk != list_end);
+	}
+	bool on_node()
+	{
+		return on_element();
+	}
+	~_XChunkListIterator_base()
+	{
+		leave();
+	}
+
+protected:
+	void enter()
+	{
+		if (chunk && (chunk != list_end)) chunk->enter();
+	}
+	void leave()
+	{
+		if (chunk && (chunk != list_end)) chunk->leave();
+	}
+	/**
+	 * Go to next/prev chunk.
+	 */
+	void step(bool forward)
+	{
+		_XChunk *old = chunk;
+		old->lock();
+		chunk = static_cast<_XChunk *>(forward ?
+					old->_M_next : old->_M_prev);
+		if (chunk != list_end) chunk->enter();
+		old->unlock();
+		if (old != list_end) old->leave();
+	}
+	/**
+	 * Go to next live slot.
+	 */
+	void forward()
+	{
+		unsigned from = (chunk == list_end) ? N : idx + 1;
+		while (1) {
+			if (from < N) {
+				uint64_t m = chunk->live.load() &
+						(~(uint64_t)0 << from);
+				if (m) {
+					idx = __builtin_ctzll(m);
+					return;
+				}
+			}
+			step(true);
+			idx = from = 0;
+			if (chunk == list_end) return;
+		}
+	}
+	/**
+	 * Go to previous live slot.
+	 */
+	void backward()
+	{
+		int from = (chunk == list_end) ? -1 : (int)idx - 1;
+		while (1) {
+			if (from >= 0) {
+				uint64_t m = chunk->live.load() &
+						(((uint64_t)2 << from) - 1);
+				if (m) {
+					idx = 63 - __builtin_clzll(m);
+					return;
+				}
+			}
+			step(false);
+			idx = 0;
+			if (chunk == list_end) return;
+			from = N - 1;
+		}
+	}
+
+	_XChunk *chunk;
+	unsigned idx;
+	_XChunk *list_end;
+};
+
+/**
+ * \class XChunkListIterator
+ * Iterator of %XChunkList.
+ */
+template <typename T, unsigned N>
+class XChunkListIterator : public _XChunkListIterator_base<T, N>
+{
+public:
+	typedef XChunkListIterator<T, N>		_Self;
+	typedef _XChunkListIterator_base<T, N>		_Base;
+	typedef typename _Base::_XChunk			_XChunk;
+
+	typedef T					value_type;
+	typedef T*					pointer;
+	typedef T&					reference;
+	typedef std::bidirectional_iterator_tag		iterator_category;
+	typedef ptrdiff_t				difference_type;
+
+	XChunkListIterator() {}
+	explicit
+	XChunkListIterator(_XChunk *_list_end) : _Base(_list_end) {}
+
+	reference operator*() const
+	{
+		return *this->chunk->slot(this->idx);
+	}
+	pointer operator->() const
+	{
+		return this->chunk->slot(this->idx);
+	}
+	_Self &operator++()
+	{
+		this->forward();
+		return *this;
+	}
+	_Self operator++(int)
+	{
+		_Self __tmp = *this;
+		this->forward();
+		return __tmp;
+	}
+	_Self &operator--()
+	{
+		this->backward();
+		return *this;
+	}
+	_Self operator--(int)
+	{
+		_Self __tmp = *this;
+		this->backward();
+		return __tmp;
+	}
+	bool operator==(const _Self &rvalue) const
+	{
+		return (this->chunk == rvalue.chunk) &&
+					(this->idx == rvalue.idx);
+	}
+	bool operator!=(const _Self &rvalue) const
+	{
+		return ! (*this == rvalue);
+	}
+};
+
+/**
+ * \class XChunkListConstIterator
+ * Const iterator of %XChunkList.
+ */
+template <typename T, unsigned N>
+class XChunkListConstIterator : public _XChunkListIterator_base<T, N>
+{
+public:
+	typedef XChunkListConstIterator<T, N>		_Self;
+	typedef XChunkListIterator<T, N>		iterator;
+	typedef _XChunkListIterator_base<T, N>		_Base;
+	typedef typename _Base::_XChunk			_XChunk;
+
+	typedef T					value_type;
+	typedef const T*				pointer;
+	typedef const T&				reference;
+	typedef std::bidirectional_iterator_tag		iterator_category;
+	typedef ptrdiff_t				difference_type;
+
+	XChunkListConstIterator() {}
+	explicit
+	XChunkListConstIterator(_XChunk *_list_end) : _Base(_list_end) {}
+	XChunkListConstIterator(const iterator &xiter) : _Base(xiter) {}
+
+	reference operator*() const
+	{
+		return *this->chunk->slot(this->idx);
+	}
+	pointer operator->() const
+	{
+		return this->chunk->slot(this->idx);
+	}
+	_Self &operator++()
+	{
+		this->forward();
+		return *this;
+	}
+	_Self operator++(int)
+	{
+		_Self __tmp = *this;
+		this->forward();
+		return __tmp;
+	}
+	_Self &operator--()
+	{
+		this->backward();
+		return *this;
+	}
+	_Self operator--(int)
+	{
+		_Self __tmp = *this;
+		this->backward();
+		return __tmp;
+	}
+	bool operator==(const _Self &rvalue) const
+	{
+		return (this->chunk == rvalue.chunk) &&
+					(this->idx == rvalue.idx);
+	}
+	bool operator!=(const _Self &rvalue) const
+	{
+		return ! (*this == rvalue);
+	}
+};
+
+/**
+ * \class XChunkList
+ * Unrolled list with concurrent readers, for lists that are scanned
+ * much more than changed.
+ *
+ * Each chunk keeps "N" elements (N <= 64). Like of XList, erase would
+ * be done in two steps:
+ * \code
+ * 	// Critical Section begin
+ * 	bool ret = list.xerase_prepare(iter);
+ * 	// Critical Section end
+ * 	if (ret) list.xerase(iter);
+ * \endcode
+ * "xerase_prepare" would hide the element from iterations (and remove
+ * his chunk when all of chunk elements have been erased), "xerase"
+ * doesn't block: element would be destroyed by last iteration that
+ * leaves his chunk. So readers may destroy erased elements, and all
+ * erases of a list should use the same "dispose" function.
+ * Just one writer (push_back/xerase_prepare) could change the list at
+ * a time.
+ */
+template <typename T, unsigned N = 16>
+class XChunkList
+{
+	static_assert((N > 0) && (N <= 64), "chunk size should be 1..64");
+public:
+	typedef XChunkList<T, N>			_XList;
+	typedef XChunkListIterator<T, N>		iterator;
+	typedef XChunkListConstIterator<T, N>		const_iterator;
+	typedef std::reverse_iterator<iterator>		reverse_iterator;
+	typedef std::reverse_iterator<const_iterator>	const_reverse_iterator;
+	typedef XChunk<T, N>				_XChunk;
+	typedef T					value_type;
+	typedef size_t					size_type;
+	typedef typename _XChunk::FT_disposeData	FT_disposeData;
+	/**
+	 * \typedef erase_batch
+	 * Elements that have been prepared for erase, to be erased together.
+	 */
+	typedef std::vector<iterator>			erase_batch;
+
+	XChunkList() : count(0)
+	{ }
+	XChunkList(const _XList &xlist) : count(0)
+	{
+		for (const_iterator iter = xlist.begin();
+					iter != xlist.end(); ++iter) {
+			push_back(*iter);
+		}
+	}
+	iterator begin()
+	{
+		return ++ end();
+	}
+	const_iterator begin() const
+	{
+		return ++ end();
+	}
+	iterator end()
+	{
+		return iterator(&head);
+	}
+	const_iterator end() const
+	{
+		return const_iterator((_XChunk *)&head);
+	}
+	reverse_iterator rbegin()
+	{
+		return reverse_iterator(end());
+	}
+	const_reverse_iterator rbegin() const
+	{
+		return const_reverse_iterator(end());
+	}
+	reverse_iterator rend()
+	{
+		return reverse_iterator(begin());
+	}
+	const_reverse_iterator rend() const
+	{
+		return const_reverse_iterator(begin());
+	}
+	const_iterator cbegin() const
+	{
+		return begin();
+	}
+	const_iterator cend() const
+	{
+		return end();
+	}
+	const_reverse_iterator crbegin() const
+	{
+		return rbegin();
+	}
+	const_reverse_iterator crend() const
+	{
+		return rend();
+	}
+	/**
+	 * Add data to end of the list.
+	 */
+	void push_back(const value_type &val)
+	{
+		_XChunk *tail = static_cast<_XChunk *>(head._M_prev);
+		if ((tail == &head) || (tail->used == N)) {
+			tail = new _XChunk;
+			tail->_M_next = &head;
+			tail->_M_prev = head._M_prev;
+			head._M_prev->chNextPrev(tail, NULL);
+			head.chNextPrev(NULL, tail);
+		}
+		new (tail->slot(tail->used)) T(val);
+		++ tail->constructed;
+		/* Element would be seen by iterations, after construction.
+		 */
+		tail->live.fetch_or((uint64_t)1 << tail->used);
+		++ tail->used;
+		++ count;
+	}
+	/**
+	 * Delete last element of list.
+	 */
+	void pop_back()
+	{
+		erase(-- end());
+	}
+	/**
+	 * Hide element at "pos" from iterations.
+	 *
+	 * Chunk would be removed from list, when all of his elements
+	 * have been erased.
+	 * \return false: element is already erased.
+	 */
+	bool xerase_prepare(iterator pos)
+	{
+		_XChunk *chunk = pos.chunk;
+		uint64_t bit = (uint64_t)1 << pos.idx;
+		if (! (chunk->live.fetch_and(~bit) & bit)) return false;
+		-- count;
+		if ((chunk->used == N) && (chunk->live.load() == 0))
+			unlink(chunk);
+		return true;
+	}
+	/**
+	 * Destroy prepared element, doesn't block.
+	 * \param dispose would be called on data before destruction.
+	 *
+	 * Element would be destroyed when there isn't any iteration in
+	 * his chunk (maybe at return of this function).
+	 */
+	void xerase(iterator pos, FT_disposeData dispose = NULL)
+	{
+		pos.chunk->retire(pos.idx, dispose);
+	}
+	/**
+	 * Prepare element at "pos" for erase and add him to "batch".
+	 */
+	bool xerase_prepare(iterator pos, erase_batch &batch)
+	{
+		if (! xerase_prepare(pos)) return false;
+		batch.push_back(pos);
+		return true;
+	}
+	/**
+	 * Destroy all elements of "batch".
+	 */
+	void xerase(erase_batch &batch, FT_disposeData dispose = NULL)
+	{
+		for (typename erase_batch::iterator iter = batch.begin();
+						iter != batch.end(); ++iter)
+			xerase(*iter, dispose);
+		batch.clear();
+	}
+	/**
+	 * Call of "xerase_prepare" & "xerase" in one function call.
+	 */
+	void erase(iterator pos, FT_disposeData dispose = NULL)
+	{
+		if (xerase_prepare(pos)) xerase(pos, dispose);
+	}
+	void clear(FT_disposeData dispose = NULL)
+	{
+		iterator iter = begin();
+		while (iter != end()) {
+			iterator cur = iter;
+			++ iter;
+			erase(cur, dispose);
+		}
+	}
+	size_type size() const
+	{
+		return count.load();
+	}
+	bool empty() const
+	{
+		return size() == 0;
+	}
+	~XChunkList()
+	{
+		clear();
+		/* Removed chunks have pinned the head.
+		 */
+		while (head.get_usage() > 0) sched_yield();
+		_XChunk *chunk = static_cast<_XChunk *>(head._M_next);
+		while (chunk != &head) {
+			_XChunk *next = static_cast<_XChunk *>(chunk->_M_next);
+			chunk->destroyZombies();
+			delete chunk;
+			chunk = next;
+		}
+	}
+
+private:
+	_XList &operator=(const _XList &);
+
+	/**
+	 * Remove empty "chunk" from list.
+	 *
+	 * Iterations in the chunk still could go back/forward, so pointers
+	 * of the chunk would pin his neighbours until chunk is freed.
+	 */
+	void unlink(_XChunk *chunk)
+	{
+		_XListNode_base *next = chunk->_M_next;
+		_XListNode_base *prev = chunk->_M_prev;
+		next->access();
+		prev->access();
+		next->chNextPrev(NULL, prev);
+		prev->chNextPrev(next, NULL);
+		chunk->unlinked = true;
+	}
+
+	/**
+	 * Sentinel chunk, end of the list.
+	 */
+	_XChunk head;
+	std::atomic<size_t> count;
+};
+
+} // namespace pparam
+
+#endif // _PDN_XCHUNKLIST_HPP_
@@ -0,0 +1,750 @@
+/**
+ * \file xconcurrent.hpp
+ * Defines set-parameter with lock-free readers.
+ *
+ * Copyright 2014 PDNSoft Co. (www.pdnsoft.com)
+ * \author hamid jafarian (hamid.jafarian@pdnsoft.com)
+ *
+ * xconcurrent is part of PParam.
+ *
+ * PParam is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PParam is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PParam.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _PDN_XCONCURRENT_HPP_
+#define _PDN_XCONCURRENT_HPP_
+
+#include <pthread.h>
+
+#include <atomic>
+#include <functional>
+#include <iterator>
+
+#include "xparam.hpp"
+#include "xepoch.hpp"
+
+namespace pparam
+{
+
+/**
+ * \class XConcurrentSetParam
+ * Set-parameter that could be read and changed concurrently.
+ *
+ * Like of XSetParam, sub-parameters are from type T and each of them
+ * has a unique key (by "bool key(Key &)" function of T).
+ *
+ * Readers ("find", iteration, "size") never lock: parameters are kept in
+ * a hash table with atomic bucket chains and in an atomic linked list
+ * (in order of addition). Writers lock one of "STRIPES" locks based on the
+ * key hash, so writers of different keys run concurrently. Deleted
+ * parameters would be freed by epoch based reclamation (XEpochDomain),
+ * when no reader can see them.
+ *
+ * Pointers returned by "find" and iterators are valid while caller is
+ * in a read-side section of the set domain:
+ * \code
+ * 	{
+ * 		XEpochDomain::Guard guard(set.get_domain());
+ * 		Server *s = set.find("10.0.0.1");
+ * 		if (s) use(s);
+ * 	}
+ * \endcode
+ * Iterators enter a read-side section by themselves, so they shouldn't
+ * be passed between threads.
+ * Sub-parameters shouldn't be changed in place when readers exist, delete
+ * and add a new one instead.
+ */
+template<typename T, typename Key = int>
+class XConcurrentSetParam : public XParam
+{
+private:
+	/**
+	 * One parameter of the set.
+	 */
+	struct Node
+	{
+		Node() : param(NULL), next(NULL), prev(NULL) {}
+
+		Key key;
+		T *param;
+		/**
+		 * Next node in order of addition.
+		 */
+		std::atomic<Node *> next;
+		/**
+		 * Previous node in order, just used by writers.
+		 */
+		Node *prev;
+	};
+	/**
+	 * Entry of a hash bucket chain.
+	 */
+	struct Link
+	{
+		Node *node;
+		std::atomic<Link *> next;
+	};
+	/**
+	 * Hash table, size is power of 2.
+	 */
+	struct Table
+	{
+		size_t size;
+		std::atomic<Link *> *buckets;
+	};
+
+public:
+	typedef XConcurrentSetParam<T, Key>	_XConcurrentSetParam;
+	typedef XParam::XmlNode			XmlNode;
+
+	/**
+	 * Number of writer locks.
+	 */
+	enum { STRIPES = 32 };
+
+	/**
+	 * \class const_iterator
+	 * Forward iterator on parameters in order of addition.
+	 */
+	class const_iterator
+	{
+	public:
+		typedef T *				value_type;
+		typedef T * const *			pointer;
+		typedef T * const &			reference;
+		typedef std::forward_iterator_tag	iterator_category;
+		typedef ptrdiff_t			difference_type;
+
+		const_iterator() : domain(NULL), node(NULL) {}
+		const_iterator(XEpochDomain *_domain, Node *_node) :
+			domain(_domain), node(_node)
+		{
+			if (domain) domain->enter();
+		}
+		const_iterator(const const_iterator &iter) :
+			domain(iter.domain), node(iter.node)
+		{
+			if (domain) domain->enter();
+		}
+		const_iterator &operator=(const const_iterator &iter)
+		{
+			if (iter.domain) iter.domain->enter();
+			if (domain) domain->leave();
+			domain = iter.domain;
+			node = iter.node;
+			return *this;
+		}
+		reference operator*() const
+		{
+			return node->param;
+		}
+		const_iterator &operator++()
+		{
+			node = node->next.load(std::memory_order_acquire);
+			return *this;
+		}
+		const_iterator operator++(int)
+		{
+			const_iterator tmp = *this;
+			++ *this;
+			return tmp;
+		}
+		bool operator==(const const_iterator &iter) const
+		{
+			return node == iter.node;
+		}
+		bool operator!=(const const_iterator &iter) const
+		{
+			return node != iter.node;
+		}
+		~const_iterator()
+		{
+			if (domain) domain->leave();
+		}
+
+	private:
+		XEpochDomain *domain;
+		Node *node;
+	};
+	typedef const_iterator iterator;
+
+	/**
+	 * \param buckets initial size of hash table, table would grow
+	 * 	when number of parameters passes twice of his size.
+	 * \param _domain reclamation domain, NULL: XEpochDomain::global().
+	 */
+	XConcurrentSetParam(const string &_pname, size_t buckets = 64,
+					XEpochDomain *_domain = NULL) :
+		XParam(_pname), count(0), tail(&head),
+		domain(_domain ? _domain : XEpochDomain::global())
+	{
+		size_t size = 1;
+		while (size < buckets) size <<= 1;
+		table.store(newTable(size));
+		for (int i = 0; i < STRIPES; ++i)
+			pthread_mutex_init(&stripes[i], NULL);
+		pthread_mutex_init(&order_lock, NULL);
+		pthread_mutex_init(&grow_lock, NULL);
+	}
+
+	virtual XParam &operator=(const XmlNode *node) throw (Exception);
+	virtual XParam &operator=(const string &) { return *this; }
+	virtual XParam &operator=(const XParam &xp) throw (Exception);
+	_XConcurrentSetParam &operator=(const _XConcurrentSetParam &xsp)
+							throw (Exception)
+	{
+		*(XParam *)this = *(const XParam *)&xsp;
+		return *this;
+	}
+	virtual bool operator==(const XParam &xp) throw (Exception);
+	virtual bool operator!=(const XParam &xp) throw (Exception)
+	{
+		return !(*this == xp);
+	}
+	virtual string _xml(bool show_runtime,
+			const int &indent, const string &endl) const;
+	virtual void xmlStream(std::ostream &os, bool show_runtime,
+			const int &indent, const string &endl) const;
+	virtual string value() const { return ""; }
+	virtual bool verify() throw (Exception);
+	virtual XParam *findChild(const string &name, size_t &hint) const;
+	virtual bool findChildByKey(const string &_key, XParam *&child) const;
+	virtual bool visitChildren(XParam::FT_childVisitor visit,
+							void *arg) const;
+
+	/**
+	 * Add a copy of T-object to set.
+	 * \return pointer to the new created object from _t.
+	 */
+	virtual T *addT(const T &_t) throw (Exception)
+	{
+		T *sparam = NULL;
+		try {
+			sparam = newT();
+			*(XParam *)sparam = *(XParam *)&_t;
+			addParam(sparam);
+		} catch (Exception &e) {
+			if (sparam) delete sparam;
+			e.addTracePoint(TracePoint("pparam"));
+			throw e;
+		}
+		return sparam;
+	}
+	/**
+	 * Add "param" to the set, set would own him.
+	 *
+	 * Throws Exception if "param" doesn't have any key or his key
+	 * exists; "param" would be untouched in this case.
+	 */
+	virtual void addParam(XParam *param) throw (Exception);
+	/**
+	 * Delete parameter with specified key.
+	 * \return false: there isn't any parameter with this key.
+	 */
+	virtual bool del(const Key &_key);
+	/**
+	 * Delete all of parameters.
+	 */
+	virtual void clear();
+	/**
+	 * Find parameter by key, NULL if there isn't any.
+	 * \see XConcurrentSetParam about validity of returned pointer.
+	 */
+	T *find(const Key &_key) const;
+	/**
+	 * Is there any parameter with this key?
+	 */
+	bool exist(const Key &_key) const
+	{
+		XEpochDomain::Guard guard(domain);
+		return find(_key) != NULL;
+	}
+	size_t size() const
+	{
+		return count.load(std::memory_order_relaxed);
+	}
+	bool empty() const
+	{
+		return size() == 0;
+	}
+	const_iterator begin() const
+	{
+		/* First node should be loaded in section.
+		 */
+		domain->enter();
+		const_iterator ret(domain,
+				head.next.load(std::memory_order_acquire));
+		domain->leave();
+		return ret;
+	}
+	const_iterator end() const
+	{
+		return const_iterator();
+	}
+	XEpochDomain *get_domain() const
+	{
+		return domain;
+	}
+
+	virtual ~XConcurrentSetParam()
+	{
+		clear();
+		Table *t = table.load();
+		delete [] t->buckets;
+		delete t;
+		pthread_mutex_destroy(&grow_lock);
+		pthread_mutex_destroy(&order_lock);
+		for (int i = 0; i < STRIPES; ++i)
+			pthread_mutex_destroy(&stripes[i]);
+	}
+
+protected:
+	/**
+	 * Allocate new T object, \see XSetParam::newT.
+	 */
+	virtual T *newT() throw (Exception)
+	{
+		T *t = new T;
+		if (t == NULL)
+			throw Exception("Can't allocate memory !",
+						TracePoint("pparam"));
+		return t;
+	}
+
+private:
+	XConcurrentSetParam(const _XConcurrentSetParam &);
+
+	static size_t hash(const Key &_key)
+	{
+		size_t h = std::hash<Key>()(_key);
+		/* Spread low quality hashes (like of integers).
+		 */
+		h ^= h >> 16;
+		h *= 0x45d9f3b;
+		h ^= h >> 16;
+		return h;
+	}
+	static Table *newTable(size_t size)
+	{
+		Table *t = new Table;
+		t->size = size;
+		t->buckets = new std::atomic<Link *>[size];
+		for (size_t i = 0; i < size; ++i) t->buckets[i].store(NULL);
+		return t;
+	}
+	/**
+	 * Key of string form, without copy for string keys.
+	 */
+	template<typename K>
+	static const K *keyOf(const string &str, K &tmp)
+	{
+		return xkeyFromString(str, tmp) ? &tmp : NULL;
+	}
+	static const string *keyOf(const string &str, string &tmp)
+	{
+		return &str;
+	}
+	/**
+	 * Find link of "_key" in "t", caller should be in section or
+	 * hold stripe lock of key.
+	 */
+	static Link *lookup(Table *t, const Key &_key, size_t h)
+	{
+		Link *link = t->buckets[h & (t->size - 1)].load(
+						std::memory_order_acquire);
+		for (; link; link = link->next.load(std::memory_order_acquire))
+			if (link->node->key == _key) return link;
+		return NULL;
+	}
+	/**
+	 * Double the table, when it's too loaded.
+	 */
+	void grow();
+
+	static void disposeNode(void *obj, void *arg)
+	{
+		Node *node = (Node *)obj;
+		delete node->param;
+		delete node;
+	}
+	static void disposeLink(void *obj, void *arg)
+	{
+		delete (Link *)obj;
+	}
+	/**
+	 * Dispose a table with all of his links.
+	 */
+	static void disposeTable(void *obj, void *arg)
+	{
+		Table *t = (Table *)obj;
+		for (size_t i = 0; i < t->size; ++i) {
+			Link *link = t->buckets[i].load();
+			while (link) {
+				Link *next = link->next.load();
+				delete link;
+				link = next;
+			}
+		}
+		delete [] t->buckets;
+		delete t;
+	}
+
+	std::atomic<Table *> table;
+	std::atomic<size_t> count;
+	/**
+	 * Sentinel of order list, "head.next" is first parameter.
+	 */
+	Node head;
+	/**
+	 * Last node of order list, managed by "order_lock".
+	 */
+	Node *tail;
+	XEpochDomain *domain;
+	/**
+	 * Writer locks, each key is protected by "hash % STRIPES" lock.
+	 */
+	pthread_mutex_t stripes[STRIPES];
+	/**
+	 * Lock to manage order list.
+	 */
+	pthread_mutex_t order_lock;
+	/**
+	 * Just one thread would grow the table.
+	 */
+	pthread_mutex_t grow_lock;
+};
+
+template<typename T, typename Key>
+T *XConcurrentSetParam<T, Key>::find(const Key &_key) const
+{
+	XEpochDomain::Guard guard(domain);
+	Link *link = lookup(table.load(std::memory_order_acquire), _key,
+								hash(_key));
+	return link ? link->node->param : NULL;
+}
+
+template<typename T, typename Key>
+void XConcurrentSetParam<T, Key>::addParam(XParam *param) throw (Exception)
+{
+	T *sparam = dynamic_cast<T *>(param);
+	if (sparam == NULL)
+		throw Exception("Bad T param in addParam",
+					TracePoint("pparam"));
+	Node *node = new Node;
+	if (! sparam->key(node->key)) {
+		delete node;
+		throw Exception("Parameter doesn't have any key !",
+					TracePoint("pparam"));
+	}
+	node->param = sparam;
+	size_t h = hash(node->key);
+	pthread_mutex_t *stripe = &stripes[h % STRIPES];
+
+	pthread_mutex_lock(stripe);
+	Table *t = table.load(std::memory_order_acquire);
+	if (lookup(t, node->key, h)) {
+		pthread_mutex_unlock(stripe);
+		node->param = NULL;
+		delete node;
+		throw Exception("Duplicated key parameter !",
+					TracePoint("pparam"));
+	}
+	/* Publish in order list, then in hash table.
+	 */
+	pthread_mutex_lock(&order_lock);
+	node->prev = tail;
+	tail->next.store(node, std::memory_order_release);
+	tail = node;
+	pthread_mutex_unlock(&order_lock);
+
+	Link *link = new Link;
+	link->node = node;
+	std::atomic<Link *> &bucket = t->buckets[h & (t->size - 1)];
+	link->next.store(bucket.load(std::memory_order_relaxed));
+	bucket.store(link, std::memory_order_release);
+	/* "t" may be retired by a "grow" after unlock, so size of table
+	 * is read under the stripe lock ("grow" takes all of stripes).
+	 */
+	bool need_grow = ++ count > 2 * t->size;
+	pthread_mutex_unlock(stripe);
+
+	if (need_grow) grow();
+}
+
+template<typename T, typename Key>
+bool XConcurrentSetParam<T, Key>::del(const Key &_key)
+{
+	size_t h = hash(_key);
+	pthread_mutex_t *stripe = &stripes[h % STRIPES];
+
+	pthread_mutex_lock(stripe);
+	Table *t = table.load(std::memory_order_acquire);
+	std::atomic<Link *> *prev = &t->buckets[h & (t->size - 1)];
+	Link *link = prev->load(std::memory_order_relaxed);
+	for (; link; link = link->next.load(std::memory_order_relaxed)) {
+		if (link->node->key == _key) break;
+		prev = &link->next;
+	}
+	if (!link) {
+		pthread_mutex_unlock(stripe);
+		return false;
+	}
+	Node *node = link->node;
+	prev->store(link->next.load(std::memory_order_relaxed),
+					std::memory_order_release);
+
+	/* Readers on "node" still could go forward by his "next".
+	 */
+	pthread_mutex_lock(&order_lock);
+	Node *next = node->next.load(std::memory_order_relaxed);
+	node->prev->next.store(next, std::memory_order_release);
+	if (next) next->prev = node->prev;
+	else tail = node->prev;
+	pthread_mutex_unlock(&order_lock);
+	-- count;
+	pthread_mutex_unlock(stripe);
+
+	domain->retire(link, disposeLink);
+	domain->retire(node, disposeNode);
+	return true;
+}
+
+template<typename T, typename Key>
+void XConcurrentSetParam<T, Key>::clear()
+{
+	pthread_mutex_lock(&grow_lock);
+	for (int i = 0; i < STRIPES; ++i) pthread_mutex_lock(&stripes[i]);
+
+	Table *t = table.load(std::memory_order_relaxed);
+	table.store(newTable(t->size), std::memory_order_release);
+	pthread_mutex_lock(&order_lock);
+	Node *node = head.next.load(std::memory_order_relaxed);
+	head.next.store(NULL, std::memory_order_release);
+	tail = &head;
+	pthread_mutex_unlock(&order_lock);
+	count.store(0);
+
+	for (int i = STRIPES - 1; i >= 0; --i)
+		pthread_mutex_unlock(&stripes[i]);
+	pthread_mutex_unlock(&grow_lock);
+
+	domain->retire(t, disposeTable);
+	while (node) {
+		Node *next = node->next.load(std::memory_order_relaxed);
+		domain->retire(node, disposeNode);
+		node = next;
+	}
+}
+
+template<typename T, typename Key>
+void XConcurrentSetParam<T, Key>::grow()
+{
+	pthread_mutex_lock(&grow_lock);
+	Table *t = table.load(std::memory_order_relaxed);
+	if (count.load() <= 2 * t->size) {
+		/* Another thread has grown the table.
+		 */
+		pthread_mutex_unlock(&grow_lock);
+		return;
+	}
+	for (int i = 0; i < STRIPES; ++i) pthread_mutex_lock(&stripes[i]);
+
+	/* No writer is active, so order list is stable.
+	 */
+	Table *nt = newTable(t->size * 2);
+	for (Node *node = head.next.load(std::memory_order_relaxed); node;
+			node = node->next.load(std::memory_order_relaxed)) {
+		Link *link = new Link;
+		link->node = node;
+		std::atomic<Link *> &bucket =
+			nt->buckets[hash(node->key) & (nt->size - 1)];
+		link->next.store(bucket.load(std::memory_order_relaxed));
+		bucket.store(link, std::memory_order_relaxed);
+	}
+	table.store(nt, std::memory_order_release);
+
+	for (int i = STRIPES - 1; i >= 0; --i)
+		pthread_mutex_unlock(&stripes[i]);
+	pthread_mutex_unlock(&grow_lock);
+	domain->retire(t, disposeTable);
+}
+
+template<typename T, typename Key>
+XParam &XConcurrentSetParam<T, Key>::operator=(const XmlNode *node)
+							throw (Exception)
+{
+	if (!is_myNode(node)) return (*this);
+
+	XmlNode::NodeList nlist = node->get_children();
+	for (XmlNode::NodeList::iterator iter = nlist.begin();
+				iter != nlist.end(); ++iter) {
+		const xmlpp::Element *nElem =
+			dynamic_cast<const xmlpp::Element *>(*iter);
+		if (nElem) {
+			XParam *sparam = NULL;
+			try {
+				sparam = newT();
+				if (sparam->is_myNode(*iter)) {
+					(*sparam) = (*iter);
+					addParam(sparam);
+				} else delete sparam;
+			} catch (Exception &e) {
+				clear();
+				if (sparam) delete sparam;
+				e.addTracePoint(TracePoint("pparam"));
+				throw e;
+			}
+		}
+	}
+	return (*this);
+}
+
+template<typename T, typename Key>
+XParam &XConcurrentSetParam<T, Key>::operator=(const XParam &xp)
+							throw (Exception)
+{
+	const _XConcurrentSetParam *xsp =
+			dynamic_cast<const _XConcurrentSetParam *>(&xp);
+	if (xsp == NULL)
+		throw Exception("Bad set XParam in assignment !",
+					TracePoint("pparam"));
+	/* check prameter name. */
+	if (get_pname() != xsp->get_pname())
+		throw Exception("Different set xparameters "
+			"in assignment !", TracePoint("pparam"));
+	try {
+		assignHelper(xp);
+	} catch(Exception &e) {
+		e.addTracePoint(TracePoint("pparam"));
+		throw e;
+	}
+	/* clear current content. */
+	clear();
+	for (const_iterator iter = xsp->begin(); iter != xsp->end(); ++iter) {
+		try {
+			addT(**iter);
+		} catch (Exception &e) {
+			clear();
+			e.addTracePoint(TracePoint("pparam"));
+			throw e;
+		}
+	}
+	return *this;
+}
+
+template<typename T, typename Key>
+bool XConcurrentSetParam<T, Key>::operator==(const XParam &xp)
+							throw (Exception)
+{
+	const _XConcurrentSetParam *xsp =
+			dynamic_cast<const _XConcurrentSetParam *>(&xp);
+	if (!xsp)
+		throw Exception(Exception::FAILED,
+				"Bad set parameter in comparison !",
+				TracePoint("pparam"));
+	if (size() != xsp->size())
+		return false;
+	const_iterator first = begin(), second = xsp->begin();
+	for (; (first != end()) && (second != xsp->end());
+						++first, ++second) {
+		if (**first != **second)
+			return false;
+	}
+	return (first == end()) && (second == xsp->end());
+}
+
+template<typename T, typename Key>
+string XConcurrentSetParam<T, Key>::_xml(bool show_runtime,
+			const int& indent, const string& endl) const
+{
+	/* we shouldn't write runtime parameters. */
+	if (dont_show(show_runtime))
+		return "";
+
+	string ind(indent, ' ');
+	string xstr = "";
+	string ver = (version.empty()) ? "" : " ver=\"" + version + "\"";
+	xstr += ind + "<" + pname + ver + ">" + endl;
+	for (const_iterator iter = begin(); iter != end(); ++iter) {
+		xstr += (*iter)->_xml(show_runtime,
+			(indent) ? indent + 4 : indent, endl);
+	}
+	xstr += ind + "</" + pname + ">" + endl;
+	return xstr;
+}
+
+template<typename T, typename Key>
+void XConcurrentSetParam<T, Key>::xmlStream(std::ostream &os,
+			bool show_runtime, const int& indent,
+			const string& endl) const
+{
+	/* we shouldn't write runtime parameters. */
+	if (dont_show(show_runtime))
+		return;
+
+	string ind(indent, ' ');
+	string ver = (version.empty()) ? "" : " ver=\"" + version + "\"";
+	os << ind << "<" << pname << ver << ">" << endl;
+	for (const_iterator iter = begin(); iter != end(); ++iter) {
+		(*iter)->xmlStream(os, show_runtime,
+			(indent) ? indent + 4 : indent, endl);
+	}
+	os << ind << "</" << pname << ">" << endl;
+}
+
+template<typename T, typename Key>
+bool XConcurrentSetParam<T, Key>::verify() throw (Exception)
+{
+	bool ret = true;
+	for (const_iterator iter = begin(); iter != end(); ++iter) {
+		ret = ret && (*iter)->verify();
+	}
+	return ret;
+}
+
+template<typename T, typename Key>
+XParam *XConcurrentSetParam<T, Key>::findChild(const string &name,
+						size_t &hint) const
+{
+	size_t i = 0;
+	for (const_iterator iter = begin(); iter != end(); ++iter, ++i) {
+		if ((*iter)->get_pname() == name) {
+			hint = i;
+			return *iter;
+		}
+	}
+	return NULL;
+}
+
+template<typename T, typename Key>
+bool XConcurrentSetParam<T, Key>::findChildByKey(const string &_key,
+						XParam *&child) const
+{
+	Key tmp;
+	const Key *k = keyOf(_key, tmp);
+	child = (k) ? find(*k) : NULL;
+	return true;
+}
+
+template<typename T, typename Key>
+bool XConcurrentSetParam<T, Key>::visitChildren(
+		XParam::FT_childVisitor visit, void *arg) const
+{
+	for (const_iterator iter = begin(); iter != end(); ++iter) {
+		if (!visit(*iter, arg)) return false;
+	}
+	return true;
+}
+
+} // namespace pparam
+
+#endif // _PDN_XCONCURRENT_HPP_
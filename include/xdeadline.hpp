@@ -0,0 +1,105 @@
+/**
+ * \file xdeadline.hpp
+ * Defines deadline of blocking waits of the calling thread.
+ *
+ * Waits on object statuses would give up when deadline of the thread
+ * is passed, so one stuck operation couldn't hang other threads
+ * indefinitely.
+ *
+ * Copyright 2014 PDNSoft Co. (www.pdnsoft.com)
+ * \author hamid jafarian (hamid.jafarian@pdnsoft.com)
+ *
+ * xdeadline is part of PParam.
+ *
+ * PParam is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PParam is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PParam.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _PDN_XDEADLINE_HPP_
+#define _PDN_XDEADLINE_HPP_
+
+#include <pthread.h>
+#include <time.h>
+
+namespace pparam
+{
+
+/**
+ * \class XDeadline
+ * Scoped deadline of the calling thread.
+ *
+ * \code
+ * 	{
+ * 		XDeadline deadline(100);	// 100ms from now
+ * 		list.del(key);
+ * 		if (deadline.is_fired()) ...	// some waits timed out
+ * 	}
+ * \endcode
+ * Deadlines could be nested, inner deadline would never be later than
+ * outer one. Without any deadline waits are unbounded.
+ * Times are on CLOCK_MONOTONIC.
+ */
+class XDeadline
+{
+public:
+	/**
+	 * \param msec milliseconds from now, "0" means don't wait at all.
+	 */
+	explicit XDeadline(unsigned int msec);
+	~XDeadline();
+	/**
+	 * Has any wait timed out under this deadline?
+	 */
+	bool is_fired() const
+	{
+		return fired;
+	}
+	/**
+	 * Absolute time of current deadline of the calling thread.
+	 * \return NULL if there isn't any deadline.
+	 */
+	static const struct timespec *abstime();
+	/**
+	 * Record timeout of a wait in current deadlines of the calling
+	 * thread.
+	 */
+	static void fire();
+	/**
+	 * Has any wait timed out under current deadline of the calling
+	 * thread?
+	 */
+	static bool timedout();
+
+private:
+	XDeadline(const XDeadline &);
+	XDeadline &operator = (const XDeadline &);
+
+	static XDeadline *current();
+	static void init();
+
+	/**
+	 * Absolute time of deadline.
+	 */
+	struct timespec when;
+	bool fired;
+	/**
+	 * Enclosing deadline of the thread.
+	 */
+	XDeadline *outer;
+
+	static pthread_key_t key;
+	static pthread_once_t once;
+};
+
+} // namespace pparam
+
+#endif // _PDN_XDEADLINE_HPP_
@@ -0,0 +1,144 @@
+/**
+ * \file xdepindex.hpp
+ * Defines reverse-dependency index of XObjects.
+ *
+ * STRONG connections make other side of connection dependent to the
+ * object, this index keeps dependents of each object so "what would
+ * break if the object is deleted" could be answered without scanning
+ * objects.
+ *
+ * Copyright 2014 PDNSoft Co. (www.pdnsoft.com)
+ * \author hamid jafarian (hamid.jafarian@pdnsoft.com)
+ *
+ * xdepindex is part of PParam.
+ *
+ * PParam is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PParam is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PParam.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _PDN_XDEPINDEX_HPP_
+#define _PDN_XDEPINDEX_HPP_
+
+#include <pthread.h>
+
+#include <atomic>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace pparam
+{
+
+using std::string;
+
+/**
+ * \class XDependencyIndex
+ * Index of dependents of objects, by object keys.
+ *
+ * Edges are added/removed by objects when STRONG connections are
+ * created/deleted, so index is always equal to STRONG connections.
+ * Transitive closures are cached, cache of a closure would be
+ * invalidated when dependents of any of his members change.
+ * \code
+ * 	XDependencyIndex deps;
+ * 	list.set_dependencyIndex(&deps);
+ * 	...
+ * 	std::vector<string> broken = deps.closure(key);
+ * \endcode
+ * One index could be shared between lists of a repository, so
+ * dependencies between objects of different lists are indexed too.
+ */
+class XDependencyIndex
+{
+public:
+	typedef std::vector<string> Keys;
+
+	XDependencyIndex();
+	~XDependencyIndex();
+	/**
+	 * "dependent" depends to "obj" by one more STRONG connection.
+	 */
+	void addEdge(const string &obj, const string &dependent);
+	/**
+	 * One STRONG connection between "obj" and "dependent" removed.
+	 */
+	void delEdge(const string &obj, const string &dependent);
+	/**
+	 * Does any object depend to "obj"?
+	 */
+	bool has_dependents(const string &obj);
+	/**
+	 * Objects that depend to "obj" directly.
+	 */
+	Keys dependents(const string &obj);
+	/**
+	 * Objects that depend to "obj" directly or indirectly.
+	 * \return keys of objects in BFS order, "obj" isn't included.
+	 */
+	Keys closure(const string &obj);
+	/**
+	 * Number of edges (dependent, object pairs).
+	 */
+	size_t size();
+	unsigned long get_cacheHits() const
+	{
+		return cacheHits.load();
+	}
+	unsigned long get_cacheMisses() const
+	{
+		return cacheMisses.load();
+	}
+
+private:
+	XDependencyIndex(const XDependencyIndex &);
+	XDependencyIndex &operator = (const XDependencyIndex &);
+
+	/**
+	 * Drop cached closures that "obj" is member of.
+	 */
+	void invalidate(const string &obj);
+	/**
+	 * "obj" isn't member of closure of "root" anymore.
+	 */
+	void unmember(const string &obj, const string &root);
+
+	/**
+	 * Dependents of each object, with number of STRONG connections
+	 * between them.
+	 */
+	typedef std::unordered_map<string, unsigned> Edges;
+	typedef std::unordered_map<string, Edges> Graph;
+	/**
+	 * Cached closures, by their roots.
+	 */
+	typedef std::unordered_map<string, Keys> Closures;
+	/**
+	 * Roots of cached closures that contain each object (roots
+	 * contain themselves).
+	 */
+	typedef std::unordered_map<string, std::unordered_set<string> >
+								Members;
+
+	Graph graph;
+	Closures closures;
+	Members members;
+	size_t edges;
+	pthread_mutex_t lock;
+
+	std::atomic<unsigned long> cacheHits;
+	std::atomic<unsigned long> cacheMisses;
+};
+
+} // namespace pparam
+
+#endif // _PDN_XDEPINDEX_HPP_
@@ -0,0 +1,206 @@
+/**
+ * \file xepoch.hpp
+ * Defines epoch based memory reclamation.
+ *
+ * Readers of lock-free containers would enter a read-side section before
+ * touching shared elements and leave him when done; they never block.
+ * Writers unlink elements and "retire" them, retired elements would be
+ * disposed when all of readers that could see them have left their
+ * sections.
+ *
+ * Copyright 2014 PDNSoft Co. (www.pdnsoft.com)
+ * \author hamid jafarian (hamid.jafarian@pdnsoft.com)
+ *
+ * xepoch is part of PParam.
+ *
+ * PParam is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PParam is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PParam.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _PDN_XEPOCH_HPP_
+#define _PDN_XEPOCH_HPP_
+
+#include <pthread.h>
+
+#include <atomic>
+#include <vector>
+
+namespace pparam
+{
+
+/**
+ * \class XEpochDomain
+ * Domain of epoch based reclamation.
+ *
+ * There is a global epoch number. Each reader announces the epoch he has
+ * seen at entering of his section. Retired objects would be kept by
+ * the epoch of their retirement, and disposed when global epoch is
+ * two steps ahead; global epoch could advance only when all of active
+ * readers have seen current epoch.
+ * \code
+ * 	{
+ * 		XEpochDomain::Guard guard(domain);
+ * 		// read shared elements ...
+ * 	}
+ * 	// writer:
+ * 	unlink(elem);
+ * 	domain->retire(elem, disposeElem);
+ * \endcode
+ * Read-side sections could be nested. A section belongs to his thread,
+ * so it shouldn't be passed to another thread.
+ */
+class XEpochDomain
+{
+public:
+	/**
+	 * \typedef FT_dispose
+	 * Type for functions that would free retired objects.
+	 */
+	typedef void (*FT_dispose)(void *obj, void *arg);
+
+	XEpochDomain();
+	/**
+	 * Enter read-side section.
+	 */
+	void enter();
+	/**
+	 * Leave read-side section.
+	 */
+	void leave();
+	/**
+	 * Is calling thread in read-side section?
+	 */
+	bool in_section();
+	/**
+	 * Dispose "obj" by "dispose" when no reader can see him.
+	 *
+	 * Caller should have unlinked "obj" from shared structures before.
+	 * "dispose" may be called in this call, or in later calls of
+	 * retire/synchronize by any thread.
+	 */
+	void retire(void *obj, FT_dispose dispose, void *arg = NULL);
+	/**
+	 * Wait until all of current readers leave their sections and
+	 * dispose all retired objects.
+	 *
+	 * Shouldn't be called in a read-side section.
+	 */
+	void synchronize();
+	/**
+	 * Number of retired objects that haven't been disposed yet.
+	 */
+	size_t pending();
+	/**
+	 * Process wide domain.
+	 */
+	static XEpochDomain *global();
+	/**
+	 * All readers should have left before destruction,
+	 * remaining objects would be disposed.
+	 */
+	~XEpochDomain();
+
+	/**
+	 * \class Guard
+	 * Read-side section in a scope.
+	 */
+	class Guard
+	{
+	public:
+		Guard(XEpochDomain *_domain = NULL) :
+			domain(_domain ? _domain : XEpochDomain::global())
+		{
+			domain->enter();
+		}
+		~Guard()
+		{
+			domain->leave();
+		}
+	private:
+		Guard(const Guard &);
+		Guard &operator=(const Guard &);
+
+		XEpochDomain *domain;
+	};
+
+private:
+	XEpochDomain(const XEpochDomain &);
+	XEpochDomain &operator=(const XEpochDomain &);
+
+	/**
+	 * Announcement of one thread.
+	 *
+	 * Records are padded, so announcements of different threads
+	 * never share a cache line.
+	 */
+	struct Record
+	{
+		char pad0[64];
+		/**
+		 * Epoch seen by thread, 0: thread isn't in section.
+		 */
+		std::atomic<unsigned long> epoch;
+		/**
+		 * Record is owned by a thread.
+		 */
+		std::atomic<bool> used;
+		/**
+		 * Nesting of sections, just used by owner thread.
+		 */
+		unsigned nest;
+		Record *next;
+		char pad1[64];
+	};
+	/**
+	 * One retired object.
+	 */
+	struct Retired
+	{
+		void *obj;
+		FT_dispose dispose;
+		void *arg;
+	};
+	typedef std::vector<Retired> RetiredList;
+
+	Record *record();
+	static void releaseRecord(void *rec);
+	/**
+	 * Advance global epoch if all active readers have seen him.
+	 * \return true: epoch advanced.
+	 */
+	bool tryAdvance();
+	/**
+	 * Dispose objects of "list" out of locks.
+	 */
+	static void dispose(RetiredList &list);
+
+	std::atomic<unsigned long> epoch;
+	/**
+	 * Records of threads, records never would be freed until
+	 * destruction of domain, they would be reused by new threads.
+	 */
+	std::atomic<Record *> records;
+	pthread_key_t recordKey;
+	/**
+	 * Retired objects by epoch of retirement (epoch % 3).
+	 */
+	RetiredList limbo[3];
+	size_t limboSize;
+	/**
+	 * Lock to manage "limbo" and advancing epochs.
+	 */
+	pthread_mutex_t lock;
+};
+
+} // namespace pparam
+
+#endif // _PDN_XEPOCH_HPP_
@@ -0,0 +1,476 @@
+/**
+ * \file xepochlist.hpp
+ * Defines list with epoch based reclamation of erased nodes.
+ *
+ * Usage model is like of XList (many readers and two step erase), but
+ * just one writer could change the list at a time and readers don't
+ * touch nodes: they traverse plain atomic pointers in a read-side
+ * section of an XEpochDomain, and erased nodes would be freed after all
+ * of readers that could see them left their sections.
+ *
+ * Copyright 2014 PDNSoft Co. (www.pdnsoft.com)
+ * \author hamid jafarian (hamid.jafarian@pdnsoft.com)
+ *
+ * xepochlist is part of PParam.
+ *
+ * PParam is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PParam is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+#ifndef _PDN_XEPOCHLIST_HPP_
+#define _PDN_XEPOCHLIST_HPP_
+
+#include <stddef.h>
+
+#include <atomic>
+#include <iterator>
+#include <vector>
+
+#include "xepoch.hpp"
+
+namespace pparam
+{
+
+template <typename T>
+class XEpochList;
+template <typename T>
+class XEpochListConstIterator;
+
+/**
+ * \class _XEpochNode_base
+ * Common part of a node in %XEpochList.
+ *
+ * There isn't any lock, condition or usage counter in node; readers just
+ * load next/prev pointers.
+ */
+class _XEpochNode_base
+{
+public:
+	_XEpochNode_base() : is_erasing(false)
+	{
+		_M_next.store(this, std::memory_order_relaxed);
+		_M_prev.store(this, std::memory_order_relaxed);
+	}
+	_XEpochNode_base *next() const
+	{
+		return _M_next.load(std::memory_order_acquire);
+	}
+	_XEpochNode_base *prev() const
+	{
+		return _M_prev.load(std::memory_order_acquire);
+	}
+
+	std::atomic<_XEpochNode_base *> _M_next;
+	std::atomic<_XEpochNode_base *> _M_prev;
+	/**
+	 * Is node erased from list? just used by writer.
+	 */
+	bool is_erasing;
+};
+
+/**
+ * \class XEpochNode
+ * Node of %XEpochList, containor of actual data.
+ */
+template <typename T>
+class XEpochNode : public _XEpochNode_base
+{
+public:
+	typedef void (*FT_disposeData)(T &data);
+
+	XEpochNode(const T &_data) : _M_data(_data), disposeData(NULL) {}
+
+	T _M_data;
+	/**
+	 * Would be called on data before node destruction.
+	 */
+	FT_disposeData disposeData;
+};
+
+/**
+ * \class XEpochListIterator
+ * Iterator of %XEpochList.
+ *
+ * Iterator is just a pointer to the node, it doesn't change anything in
+ * the node. So it should be used in read-side section of the list domain,
+ * if the list may be changed concurrently.
+ */
+template <typename T>
+class XEpochListIterator
+{
+	friend class XEpochList<T>;
+	friend class XEpochListConstIterator<T>;
+public:
+	typedef XEpochListIterator<T>			_Self;
+	typedef XEpochNode<T>				_XNode;
+	typedef _XEpochNode_base			_XNodeBase;
+
+	typedef T					value_type;
+	typedef T*					pointer;
+	typedef T&					reference;
+	typedef std::bidirectional_iterator_tag		iterator_category;
+	typedef ptrdiff_t				difference_type;
+
+	XEpochListIterator() : _M_node(NULL) {}
+	explicit
+	XEpochListIterator(_XNodeBase *__x) : _M_node(__x) {}
+
+	reference operator*() const
+	{
+		return static_cast<_XNode *>(_M_node)->_M_data;
+	}
+	pointer operator->() const
+	{
+		return &(static_cast<_XNode *>(_M_node)->_M_data);
+	}
+	_Self &operator++()
+	{
+		_M_node = _M_node->next();
+		return *this;
+	}
+	_Self operator++(int)
+	{
+		_Self __tmp = *this;
+		_M_node = _M_node->next();
+		return __tmp;
+	}
+	_Self &operator--()
+	{
+		_M_node = _M_node->prev();
+		return *this;
+	}
+	_Self operator--(int)
+	{
+		_Self __tmp = *this;
+		_M_node = _M_node->prev();
+		return __tmp;
+	}
+	bool operator==(const _Self &rvalue) const
+	{
+		return _M_node == rvalue._M_node;
+	}
+	bool operator!=(const _Self &rvalue) const
+	{
+		return _M_node != rvalue._M_node;
+	}
+
+private:
+	_XNodeBase *_M_node;
+};
+
+/**
+ * \class XEpochListConstIterator
+ * Const iterator of %XEpochList.
+ */
+template <typename T>
+class XEpochListConstIterator
+{
+	friend class XEpochList<T>;
+public:
+	typedef XEpochListConstIterator<T>		_Self;
+	typedef XEpochListIterator<T>			iterator;
+	typedef const XEpochNode<T>			_XNode;
+	typedef const _XEpochNode_base			_XNodeBase;
+
+	typedef T					value_type;
+	typedef const T*				pointer;
+	typedef const T&				reference;
+	typedef std::bidirectional_iterator_tag		iterator_category;
+	typedef ptrdiff_t				difference_type;
+
+	XEpochListConstIterator() : _M_node(NULL) {}
+	explicit
+	XEpochListConstIterator(_XNodeBase *__x) : _M_node(__x) {}
+	XEpochListConstIterator(const iterator &__x) : _M_node(__x._M_node) {}
+
+	reference operator*() const
+	{
+		return static_cast<_XNode *>(_M_node)->_M_data;
+	}
+	pointer operator->() const
+	{
+		return &(static_cast<_XNode *>(_M_node)->_M_data);
+	}
+	_Self &operator++()
+	{
+		_M_node = _M_node->next();
+		return *this;
+	}
+	_Self operator++(int)
+	{
+		_Self __tmp = *this;
+		_M_node = _M_node->next();
+		return __tmp;
+	}
+	_Self &operator--()
+	{
+		_M_node = _M_node->prev();
+		return *this;
+	}
+	_Self operator--(int)
+	{
+		_Self __tmp = *this;
+		_M_node = _M_node->prev();
+		return __tmp;
+	}
+	bool operator==(const _Self &rvalue) const
+	{
+		return _M_node == rvalue._M_node;
+	}
+	bool operator!=(const _Self &rvalue) const
+	{
+		return _M_node != rvalue._M_node;
+	}
+
+private:
+	_XNodeBase *_M_node;
+};
+
+/**
+ * \class XEpochList
+ * List with lock-free readers and epoch based reclamation.
+ *
+ * Readers that run concurrently with erase, should iterate in read-side
+ * section of list domain:
+ * \code
+ * 	{
+ * 		XEpochDomain::Guard guard(list.get_domain());
+ * 		for (iter = list.begin(); iter != list.end(); ++iter)
+ * 			...
+ * 	}
+ * \endcode
+ * Unlike XList, just one writer could change the list at a time, and
+ * erase could be done in two steps:
+ * \code
+ * 	// Critical Section begin
+ * 	bool ret = list.xerase_prepare(iter);
+ * 	// Critical Section end
+ * 	if (ret) list.xerase(iter);
+ * \endcode
+ * "xerase_prepare" would unlink node, "xerase" wouldn't block: node would
+ * be retired to the domain and freed after a grace period. Iterators on
+ * erased node still could go back/forward in their section.
+ */
+template <typename T>
+class XEpochList
+{
+public:
+	typedef XEpochList<T>				_XList;
+	typedef XEpochListIterator<T>			iterator;
+	typedef XEpochListConstIterator<T>		const_iterator;
+	typedef std::reverse_iterator<iterator>		reverse_iterator;
+	typedef std::reverse_iterator<const_iterator>	const_reverse_iterator;
+	typedef XEpochNode<T>				_XNode;
+	typedef _XEpochNode_base			_XNodeBase;
+	typedef T					value_type;
+	typedef size_t					size_type;
+	/**
+	 * \typedef FT_disposeData
+	 * Type of functions that would free data of erased nodes, like of
+	 * pointers in the list.
+	 */
+	typedef typename _XNode::FT_disposeData		FT_disposeData;
+	/**
+	 * \typedef erase_batch
+	 * Nodes that have been prepared for erase, to be erased together.
+	 */
+	typedef std::vector<_XNodeBase *>		erase_batch;
+
+	/**
+	 * \param _domain reclamation domain, NULL: XEpochDomain::global().
+	 */
+	XEpochList(XEpochDomain *_domain = NULL) : count(0),
+		domain(_domain ? _domain : XEpochDomain::global())
+	{ }
+	XEpochList(const _XList &xlist) : count(0), domain(xlist.domain)
+	{
+		for (const_iterator iter = xlist.begin();
+					iter != xlist.end(); ++iter) {
+			push_back(*iter);
+		}
+	}
+	iterator begin()
+	{
+		return iterator(head.next());
+	}
+	const_iterator begin() const
+	{
+		return const_iterator(head.next());
+	}
+	iterator end()
+	{
+		return iterator(&head);
+	}
+	const_iterator end() const
+	{
+		return const_iterator(&head);
+	}
+	reverse_iterator rbegin()
+	{
+		return reverse_iterator(end());
+	}
+	const_reverse_iterator rbegin() const
+	{
+		return const_reverse_iterator(end());
+	}
+	reverse_iterator rend()
+	{
+		return reverse_iterator(begin());
+	}
+	const_reverse_iterator rend() const
+	{
+		return const_reverse_iterator(begin());
+	}
+	const_iterator cbegin() const
+	{
+		return begin();
+	}
+	const_iterator cend() const
+	{
+		return end();
+	}
+	const_reverse_iterator crbegin() const
+	{
+		return rbegin();
+	}
+	const_reverse_iterator crend() const
+	{
+		return rend();
+	}
+	/**
+	 * Add data to end of the list.
+	 */
+	void push_back(const value_type &val)
+	{
+		link(new _XNode(val), head.prev(), &head);
+	}
+	/**
+	 * Add data to start of the list.
+	 */
+	void push_front(const value_type &val)
+	{
+		link(new _XNode(val), &head, head.next());
+	}
+	/**
+	 * Delete last node of list.
+	 */
+	void pop_back()
+	{
+		erase(-- end());
+	}
+	/**
+	 * Unlink node at "pos" from list.
+	 *
+	 * After preparation, new iterations couldn't see the node, but
+	 * iterations on him could go back/forward.
+	 * \return false: node is already erased.
+	 */
+	bool xerase_prepare(iterator pos)
+	{
+		_XNodeBase *node = pos._M_node;
+		if (node->is_erasing) return false;
+		node->is_erasing = true;
+		_XNodeBase *next = node->next();
+		_XNodeBase *prev = node->prev();
+		next->_M_prev.store(prev, std::memory_order_release);
+		prev->_M_next.store(next, std::memory_order_release);
+		-- count;
+		return true;
+	}
+	/**
+	 * Free prepared node after a grace period, doesn't block.
+	 * \param dispose would be called on data before destruction.
+	 */
+	void xerase(iterator pos, FT_disposeData dispose = NULL)
+	{
+		_XNode *node = static_cast<_XNode *>(pos._M_node);
+		node->disposeData = dispose;
+		domain->retire(node, disposeNode);
+	}
+	/**
+	 * Prepare node at "pos" for erase and add him to "batch".
+	 */
+	bool xerase_prepare(iterator pos, erase_batch &batch)
+	{
+		if (! xerase_prepare(pos)) return false;
+		batch.push_back(pos._M_node);
+		return true;
+	}
+	/**
+	 * Free all nodes of "batch" after a grace period.
+	 */
+	void xerase(erase_batch &batch, FT_disposeData dispose = NULL)
+	{
+		for (typename erase_batch::iterator iter = batch.begin();
+						iter != batch.end(); ++iter)
+			xerase(iterator(*iter), dispose);
+		batch.clear();
+	}
+	/**
+	 * Call of "xerase_prepare" & "xerase" in one function call.
+	 */
+	void erase(iterator pos, FT_disposeData dispose = NULL)
+	{
+		if (xerase_prepare(pos)) xerase(pos, dispose);
+	}
+	void clear(FT_disposeData dispose = NULL)
+	{
+		iterator iter;
+		while ((iter = begin()) != end()) erase(iter, dispose);
+	}
+	size_type size() const
+	{
+		return count.load(std::memory_order_relaxed);
+	}
+	bool empty() const
+	{
+		return size() == 0;
+	}
+	XEpochDomain *get_domain() const
+	{
+		return domain;
+	}
+	~XEpochList()
+	{
+		clear();
+	}
+
+private:
+	_XList &operator=(const _XList &);
+
+	/**
+	 * Link "node" between "prev" and "next".
+	 * Node would be published after initialization of his pointers.
+	 */
+	void link(_XNodeBase *node, _XNodeBase *prev, _XNodeBase *next)
+	{
+		node->_M_next.store(next, std::memory_order_relaxed);
+		node->_M_prev.store(prev, std::memory_order_relaxed);
+		prev->_M_next.store(node, std::memory_order_release);
+		next->_M_prev.store(node, std::memory_order_release);
+		++ count;
+	}
+	static void disposeNode(void *obj, void *arg)
+	{
+		_XNode *node = (_XNode *)obj;
+		if (node->disposeData) node->disposeData(node->_M_data);
+		delete node;
+	}
+
+	/**
+	 * Sentinel node, end of the list.
+	 */
+	_XNodeBase head;
+	std::atomic<size_t> count;
+	XEpochDomain *domain;
+};
+
+} // namespace pparam
+
+#endif // _PDN_XEPOCHLIST_HPP_
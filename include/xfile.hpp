@@ -0,0 +1,236 @@
+/**
+ * \file xfile.hpp
+ * Defines crash-safe file writing for xml documents.
+ *
+ * Documents would be written to a temporary file next to the target,
+ * synced to the disk and then atomically renamed over the target.
+ * So a crash in middle of write process never leaves a truncated document.
+ *
+ * Also defines stream buffers to write/read gzip or zlib compressed
+ * documents on the fly, without any full in-memory copy of document.
+ *
+ * Copyright 2014 PDNSoft Co. (www.pdnsoft.com)
+ * \author hamid jafarian (hamid.jafarian@pdnsoft.com)
+ *
+ * xfile is part of PParam.
+ *
+ * PParam is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PParam is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PParam.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _PDN_XFILE_HPP_
+#define _PDN_XFILE_HPP_
+
+#include <zlib.h>
+
+#include <streambuf>
+#include <string>
+using std::string;
+
+#include "exception.hpp"
+
+namespace pparam
+{
+
+/**
+ * \class XAtomicFile
+ * Writes a file by "temporary file + fsync + rename" method.
+ *
+ * \code
+ * 	XAtomicFile file("repo.xml");
+ * 	file.write(data);
+ * 	file.commit();
+ * \endcode
+ * Until "commit" the target file is untouched. If object destroyed
+ * without commit, temporary file would be removed.
+ */
+class XAtomicFile
+{
+public:
+	/**
+	 * Create temporary file next to "_path".
+	 */
+	XAtomicFile(const string &_path) throw (Exception);
+	/**
+	 * Append data to the temporary file.
+	 */
+	void write(const char *data, size_t len) throw (Exception);
+	void write(const string &data) throw (Exception)
+	{
+		write(data.data(), data.size());
+	}
+	/**
+	 * Sync temporary file, rename him to the target path and sync
+	 * target directory.
+	 */
+	void commit() throw (Exception);
+	/**
+	 * Discard temporary file, target would be untouched.
+	 */
+	void abort();
+	/**
+	 * Write "data" to "path" in one call.
+	 */
+	static void save(const string &path, const string &data)
+							throw (Exception);
+	string get_path() const
+	{
+		return path;
+	}
+	~XAtomicFile();
+
+private:
+	XAtomicFile(const XAtomicFile &);
+	XAtomicFile &operator=(const XAtomicFile &);
+
+	/**
+	 * Target file path.
+	 */
+	string path;
+	/**
+	 * Temporary file path.
+	 */
+	string tmpPath;
+	/**
+	 * Descriptor of temporary file, -1 after commit/abort.
+	 */
+	int fd;
+};
+
+/**
+ * \class XCompression
+ * Different compression formats of documents.
+ */
+class XCompression
+{
+public:
+	enum Type {
+		NONE,	/**< 0 - Plain document. */
+		GZIP,	/**< 1 - gzip format (rfc 1952). */
+		ZLIB,	/**< 2 - zlib/deflate format (rfc 1950). */
+		AUTO,	/**< 3 - Select by document name at save time,
+				"*.gz": GZIP, "*.zz", "*.z": ZLIB, else NONE. */
+		MAX,
+	};
+	const static string typeString[MAX];
+	/**
+	 * Resolve "AUTO" based on document name.
+	 */
+	static Type select(Type policy, const string &path);
+	/**
+	 * Detect compression of document by his first bytes.
+	 * \param len size of "magic", 2 bytes are enough.
+	 */
+	static Type detect(const unsigned char *magic, size_t len);
+};
+
+/**
+ * \class XDeflateBuf
+ * Output stream buffer that compresses data into an XAtomicFile.
+ *
+ * Data would be compressed by chunks as they arrive, so document 
+ * serialization and compression overlap.
+ * \code
+ * 	XAtomicFile file("repo.xml.gz");
+ * 	XDeflateBuf buf(file, XCompression::GZIP);
+ * 	std::ostream os(&buf);
+ * 	os << data;
+ * 	buf.finish();
+ * 	file.commit();
+ * \endcode
+ */
+class XDeflateBuf : public std::streambuf
+{
+public:
+	XDeflateBuf(XAtomicFile &_file, XCompression::Type _type)
+							throw (Exception);
+	/**
+	 * Flush remaining data and end of compressed stream to the file.
+	 * Throws any error occurred during writes.
+	 */
+	void finish() throw (Exception);
+	~XDeflateBuf();
+
+protected:
+	virtual int_type overflow(int_type c);
+	virtual int sync();
+
+private:
+	XDeflateBuf(const XDeflateBuf &);
+	XDeflateBuf &operator=(const XDeflateBuf &);
+
+	/**
+	 * Pass buffered data to the file.
+	 * \param flush zlib flush mode.
+	 */
+	bool drain(int flush);
+
+	XAtomicFile &file;
+	XCompression::Type type;
+	z_stream zs;
+	/**
+	 * Uncompressed data would be gathered here.
+	 */
+	char in[64 * 1024];
+	/**
+	 * Compressed data would be gathered here.
+	 */
+	char out[64 * 1024];
+	/**
+	 * First error in writes, would be thrown by "finish".
+	 */
+	string error;
+	bool finished;
+};
+
+/**
+ * \class XInflateBuf
+ * Input stream buffer that reads a document from a file descriptor and
+ * decompresses him on the fly.
+ *
+ * Compression format (gzip or zlib) would be detected by zlib.
+ */
+class XInflateBuf : public std::streambuf
+{
+public:
+	XInflateBuf(int _fd) throw (Exception);
+	/**
+	 * Error occurred in reads, empty if there isn't any.
+	 */
+	string get_error() const
+	{
+		return error;
+	}
+	~XInflateBuf();
+
+protected:
+	virtual int_type underflow();
+
+private:
+	XInflateBuf(const XInflateBuf &);
+	XInflateBuf &operator=(const XInflateBuf &);
+
+	int fd;
+	z_stream zs;
+	char in[64 * 1024];
+	char out[64 * 1024];
+	string error;
+	bool eof;
+	/**
+	 * Has last compressed member been ended?
+	 */
+	bool streamEnd;
+};
+
+} // namespace pparam
+
+#endif // _PDN_XFILE_HPP_
@@ -0,0 +1,180 @@
+/**
+ * \file xjournal.hpp
+ * Defines append-only journal of changes of a document.
+ *
+ * Changes would be appended to the journal instead of rewriting whole
+ * of the document, document and journal would be folded together by
+ * compaction from time to time.
+ *
+ * Copyright 2014 PDNSoft Co. (www.pdnsoft.com)
+ * \author hamid jafarian (hamid.jafarian@pdnsoft.com)
+ *
+ * xjournal is part of PParam.
+ *
+ * PParam is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PParam is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PParam.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _PDN_XJOURNAL_HPP_
+#define _PDN_XJOURNAL_HPP_
+
+#include <pthread.h>
+#include <sys/types.h>
+
+#include <atomic>
+#include <string>
+using std::string;
+
+#include "exception.hpp"
+
+namespace pparam
+{
+
+/**
+ * \class XJournal
+ * Append-only file of change records.
+ *
+ * Each record is: length and crc32 of body, operation, key and data of
+ * the changed element (in host byte order). Records torn by a crash
+ * would be detected by their length/crc and dropped at replay.
+ *
+ * Appenders would return when their records are on the disk, concurrent
+ * appenders are committed by one write and one fdatasync (group commit).
+ * \code
+ * 	XJournal journal("objects.xml.journal");
+ * 	journal.append(XJournal::ADD, key, xml);
+ * 	...
+ * 	off_t cut = journal.mark();
+ * 	// save whole of the document ...
+ * 	journal.truncate(cut);	// records before "cut" are in document
+ * \endcode
+ */
+class XJournal
+{
+public:
+	/**
+	 * \enum Op
+	 * Operation of a record.
+	 */
+	enum Op {
+		ADD = 1,
+		DEL = 2,
+		MOD = 3,
+	};
+	/**
+	 * \class Replayer
+	 * Receiver of records in replay.
+	 */
+	class Replayer
+	{
+	public:
+		virtual void replay(Op op, const string &key,
+						const string &data) = 0;
+		virtual ~Replayer() {}
+	};
+
+	/**
+	 * Open (or create) journal file of "path".
+	 * \param sync fdatasync records before return of "append".
+	 */
+	XJournal(const string &path, bool sync = true) throw (Exception);
+	~XJournal();
+	/**
+	 * Append one record, and wait until he is written.
+	 */
+	void append(Op op, const string &key, const string &data)
+							throw (Exception);
+	/**
+	 * Pass valid records to "replayer" in order of appending.
+	 *
+	 * Torn or corrupted tail of journal would be cut.
+	 * \return number of replayed records.
+	 */
+	size_t replay(Replayer &replayer) throw (Exception);
+	/**
+	 * Offset of end of written records, start of a compaction.
+	 */
+	off_t mark();
+	/**
+	 * Drop records before "offset", they have been saved in the
+	 * document. Records appended after "mark" would be kept.
+	 */
+	void truncate(off_t offset) throw (Exception);
+	/**
+	 * Size of journal in bytes.
+	 */
+	off_t size();
+	const string &get_path() const
+	{
+		return path;
+	}
+	unsigned long get_records() const
+	{
+		return records.load();
+	}
+	/**
+	 * Number of syncs of journal, writes aren't synced when journal
+	 * isn't synchronous.
+	 */
+	unsigned long get_syncs() const
+	{
+		return syncs.load();
+	}
+
+private:
+	XJournal(const XJournal &);
+	XJournal &operator=(const XJournal &);
+
+	void open() throw (Exception);
+	/**
+	 * Write "data" at end of journal (caller is the only writer).
+	 */
+	void write(const string &data) throw (Exception);
+
+	string path;
+	bool sync;
+	int fd;
+	/**
+	 * Records waiting to be written by next writer.
+	 */
+	string pending;
+	/**
+	 * Sequence of last appended record.
+	 */
+	unsigned long appended;
+	/**
+	 * Sequence of last written record.
+	 */
+	unsigned long written;
+	/**
+	 * Is a writer writing the records?
+	 */
+	bool writing;
+	/**
+	 * Size of written records.
+	 */
+	off_t end;
+	/**
+	 * Error of last failed write, journal wouldn't accept records
+	 * after a failure.
+	 */
+	string error;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+
+	std::atomic<unsigned long> records;
+	std::atomic<unsigned long> syncs;
+};
+
+} // namespace pparam
+
+#endif // _PDN_XJOURNAL_HPP_
@@ -32,12 +32,18 @@
 				+ __GNUC_PATCHLEVEL__)
 
 #include <list>
+#include <vector>
 #if	GCC_VERSION > 40500 // check for GCC > 4.5
 #include <atomic>
 #else
 #include <cstdatomic>
 #endif
 
+#include <sched.h>
+
+#include "xpark.hpp"
+#include "xreclaimer.hpp"
+
 namespace pparam
 {
 
@@ -57,6 +63,11 @@ class XListConstIterator;
  * Common part of a node in %XList.
  *
  * _XListNode_base would record and care concurrent usage of data.
+ *
+ * Node is compact: two pointers and one atomic state word that keeps
+ * node lock, erasing flag and usage number. There isn't any mutex or
+ * condition in node, threads that should block (to lock the node or
+ * to wait for usages) would be parked in XParkingLot.
  */
 class _XListNode_base
 {
@@ -64,10 +75,8 @@ public:
 	_XListNode_base *_M_next;
 	_XListNode_base *_M_prev;
 public:
-	_XListNode_base() :  usageNO(0), is_erasing(false)
+	_XListNode_base() : state(0)
 	{
-		pthread_mutex_init(&n_lock, NULL);
-		pthread_cond_init(&usage_cond, NULL);
 		_M_next = _M_prev = this;
 	}
 
@@ -91,15 +100,67 @@ public:
 	}
 	int get_usage()
 	{
-		return usageNO;
+		return state.load() >> USAGE_SHIFT;
+	}
+	/**
+	 * Isn't there any usage or lock on the node?
+	 */
+	bool unused()
+	{
+		return (state.load() & ~(ERASING | WAITERS)) == 0;
 	}
 	void lock()
 	{
-		pthread_mutex_lock(&n_lock);
+		unsigned s = state.load(std::memory_order_relaxed);
+		int spin = 0;
+		while (1) {
+			if (!(s & LOCKED)) {
+				if (state.compare_exchange_weak(s, s | LOCKED,
+						std::memory_order_acquire,
+						std::memory_order_relaxed))
+					return;
+				continue;
+			}
+			/* Lock is held just for some pointer changes, 
+			 * so spin a little before parking.
+			 */
+			if (spin < LOCK_SPINS) {
+				++ spin;
+				s = state.load(std::memory_order_relaxed);
+				continue;
+			}
+			if (!(s & WAITERS) && 
+				!state.compare_exchange_weak(s, s | WAITERS))
+				continue;
+			XParkingLot::park(this, state, s | WAITERS);
+			s = state.load(std::memory_order_relaxed);
+		}
+	}
+	/**
+	 * Try to lock the node, without parking.
+	 * \param spins number of spins on locked node before giving up.
+	 * \return true: node has been locked.
+	 */
+	bool try_lock(int spins = LOCK_SPINS)
+	{
+		unsigned s = state.load(std::memory_order_relaxed);
+		while (1) {
+			if (!(s & LOCKED)) {
+				if (state.compare_exchange_weak(s, s | LOCKED,
+						std::memory_order_acquire,
+						std::memory_order_relaxed))
+					return true;
+				continue;
+			}
+			if (spins-- <= 0) return false;
+			s = state.load(std::memory_order_relaxed);
+		}
 	}
 	void unlock()
 	{
-		pthread_mutex_unlock(&n_lock);
+		unsigned s = state.fetch_and(~(LOCKED | WAITERS),
+						std::memory_order_release);
+		if (s & WAITERS) XParkingLot::unpark(this);
 	}
 	/**
 	 * Start erasing process on this node.
@@ -111,18 +172,10 @@ public:
 	 */
 	bool erasing()
 	{
-		if (is_erasing) {
-			/* There is another erasing process on this node, 
-			 * so erasing couldn't be continued.
-			 */
-			return false;
-		} else {
-			/* This is the first erasing process, so continue to
-			 * erase.
-			 */
-			is_erasing = true;
-			return true;
-		} 
+		/* If there is another erasing process on this node, 
+		 * erasing couldn't be continued.
+		 */
+		return !(state.fetch_or(ERASING) & ERASING);
 	}
 	/**
 	 * Change the next/prev pointers of this node.
@@ -139,64 +192,95 @@ public:
 protected:
 	/**
 	 * Wait to finish all concurrent usages.
+	 *
+	 * Lock of node should be released too, users may release their
+	 * usage in "lock(); release(); unlock()" sequence and "unlock"
+	 * would touch the node after last usage.
 	 */
 	void waitForUsage()
 	{
-		lock();
-		while (usageNO > 0)
-			pthread_cond_wait(&usage_cond, &n_lock);
-		unlock();
+		unsigned s = state.load();
+		while ((s >> USAGE_SHIFT) || (s & LOCKED)) {
+			if (!(s & WAITERS) && 
+				!state.compare_exchange_weak(s, s | WAITERS))
+				continue;
+			XParkingLot::park(this, state, s | WAITERS);
+			s = state.load();
+		}
 	}
 	/**
 	 * Increment usageNO by "_inc".
 	 * \param _inc number of increment, default is "1".
 	 *
 	 * We don't use any lock to increment usageNO.
-	 * This beacause of atomic nature of "usageNO".
-	 * Also wait operation on "usageNO" in "waitForUsage"
+	 * This beacause of atomic nature of "state".
+	 * Also wait operation on usageNO in "waitForUsage"
 	 * would be done at deletion time, when no one could access him 
-	 * to increment "usageNO", so "usageNO" never been increased
+	 * to increment usageNO, so usageNO never been increased
 	 * at deletion time.
 	 */
 	void inc_usage(unsigned int _inc = 1)
 	{
-		usageNO += _inc;
+		state.fetch_add(_inc * USAGE_ONE);
 	}
 	/**
 	 * Decrement usageNO by "_dec".
 	 * \param _dec number of decrement, default is "1".
-	 * \note Use this function when "this" has been locked.
-	 * This because of "waitForUsage" ability to capture any decrement
-	 * changes on "usageNO".
+	 *
+	 * Last usage would wake up parked waiters of "waitForUsage".
+	 * Waiters flag is cleared by the decrement itself, so the node
+	 * isn't touched after his last usage (waiters may destroy him).
+	 * If node is locked, "unlock" would wake up the waiters.
 	 */
 	void dec_usage(unsigned int _dec = 1)
 	{
-		usageNO -= _dec;
-		if (usageNO <= 0) pthread_cond_signal(&usage_cond);
+		unsigned s = state.load(std::memory_order_relaxed);
+		unsigned ns;
+		do {
+			ns = s - _dec * USAGE_ONE;
+			if ((ns < USAGE_ONE) && !(ns & LOCKED))
+				ns &= ~WAITERS;
+		} while (!state.compare_exchange_weak(s, ns));
+		if ((s & WAITERS) && !(ns & WAITERS))
+			XParkingLot::unpark(this);
 	}
 	/**
-	 * Number of concurrent usage of this node.
-	 */
-	std::atomic_uint usageNO;
-	/**
-	 * Lock to manage decrement changes of "usageNO".
-	 *
-	 * Also use to manage access next/prev nodes from "this".
-	 * "n_lock" would be locked before (next/prev)pointer read, and 
-	 * would be released after "access" to node pointed with 
-	 * (next/prev) pointer.
-	 * So between pointer read and node access, next/prev pointers 
-	 * couldn't change.
-	 */
-	pthread_mutex_t n_lock; 
-	/**
-	 * Condition to monitor decrement changes of usageNO.
+	 * Bits of "state".
 	 */
-	pthread_cond_t usage_cond;
+	enum {
+		/**
+		 * Node is locked.
+		 *
+		 * Lock would be used to manage access next/prev nodes 
+		 * from "this". node would be locked before (next/prev)
+		 * pointer read, and would be released after "access" to
+		 * node pointed with (next/prev) pointer.
+		 * So between pointer read and node access, next/prev 
+		 * pointers couldn't change.
+		 */
+		LOCKED = 1,
+		/**
+		 * Erasing process is in progress on this node.
+		 */
+		ERASING = 2,
+		/**
+		 * There are threads parked on this node.
+		 */
+		WAITERS = 4,
+		/**
+		 * Rest of bits are number of concurrent usages (usageNO).
+		 */
+		USAGE_SHIFT = 3,
+		USAGE_ONE = 1 << USAGE_SHIFT,
+		/**
+		 * Number of spins to lock the node before parking.
+		 */
+		LOCK_SPINS = 64
+	};
 	/**
-	 * Is erasing process in progress on this node?
+	 * Lock, erasing flag and usage number of this node.
 	 */
-	bool is_erasing;
+	std::atomic<unsigned> state;
 };
 
 /**
@@ -735,18 +819,23 @@ protected:
 	struct _XList_impl : public _Node_alloc_type
 	{
 		_XListNode_base _M_node;
+		/**
+		 * Number of nodes, nodes under erase aren't counted after
+		 * "xerase_prepare".
+		 */
+		std::atomic<size_t> _M_size;
 
 		_XList_impl()
-		: _Node_alloc_type(), _M_node()
+		: _Node_alloc_type(), _M_node(), _M_size(0)
 		{ }
 
 		_XList_impl(const _Node_alloc_type& __a)
-		: _Node_alloc_type(__a), _M_node()
+		: _Node_alloc_type(__a), _M_node(), _M_size(0)
 		{ }
 
 	#ifdef __GXX_EXPERIMENTAL_CXX0X__
 		_XList_impl(_Node_alloc_type&& __a)
-		: _Node_alloc_type(std::move(__a)), _M_node()
+		: _Node_alloc_type(std::move(__a)), _M_node(), _M_size(0)
 		{ }
 	#endif
 
@@ -801,7 +890,11 @@ public:
  * In XList, reads(concurrent accesses) to any node of list means 
  * "iterators" have been located on that node.
  *
- * XList supports cocurrently multiple reads with one write at a time.
+ * XList supports cocurrently multiple reads with multiple writes:
+ * "push_back", "push_front" and "xerase_prepare" could be called by 
+ * many threads at a time. Each of them would lock just the nodes that
+ * he changes (target node and his neighbours), so writes at different
+ * places of the list don't wait for each other.
  *
  * Erase of nodes from list could be done in two steps:
  * \code
@@ -831,6 +924,17 @@ public:
 	typedef _XList_base<T, _Alloc>			_XBase;
 	typedef T					value_type;
 	typedef size_t					size_type;
+	/**
+	 * \typedef FT_disposeData
+	 * Type of functions that would free data of erased nodes, like of
+	 * pointers in the list.
+	 */
+	typedef void (*FT_disposeData)(T &data);
+	/**
+	 * \typedef erase_batch
+	 * Nodes that have been prepared for erase, to be erased together.
+	 */
+	typedef std::vector<_XNodeBase *>		erase_batch;
 
 protected:
 	using _XBase::_M_get_Node_allocator;
@@ -873,9 +977,10 @@ protected:
 #endif
 
 public:
-	XList() : _XList_base<T, _Alloc>()
+	XList() : _XList_base<T, _Alloc>(), reclaimer(NULL), pending(0)
 	{ }
-	XList(const _XList &xlist) : _XList_base<T, _Alloc>()
+	XList(const _XList &xlist) : _XList_base<T, _Alloc>(),
+		reclaimer(xlist.reclaimer), pending(0)
 	{	
 		for (const_iterator iter = xlist.begin();
 					iter != xlist.end(); ++iter) {
@@ -947,14 +1052,41 @@ public:
 	void push_back(const value_type &val)
 	{
 		_XNode *_node = _M_create_node(val);
-		/* next points to end */
-		_node->_M_next = &this->_M_impl._M_node;
-		/* prev points to the prev node of end */
-		_node->_M_prev = this->_M_impl._M_node._M_prev;
-		_node->access();
-		_M_impl._M_node._M_prev->chNextPrev((_XNodeBase *)_node, NULL);
-		_node->access();
-		_M_impl._M_node.chNextPrev(NULL, (_XNodeBase *)_node);
+		_XNodeBase *_end = &this->_M_impl._M_node;
+		/* Lock end, then the last node.
+		 */
+		while (1) {
+			_end->lock();
+			_XNodeBase *_prev = _end->_M_prev;
+			if ((_prev == _end) || _prev->try_lock()) break;
+			_end->unlock();
+			sched_yield();
+		}
+		_XNodeBase *_prev = _end->_M_prev;
+		_M_link(_node, _prev, _end);
+		if (_prev != _end) _prev->unlock();
+		_end->unlock();
+	}
+	/**
+	 * Add data to start of the list.
+	 */
+	void push_front(const value_type &val)
+	{
+		_XNode *_node = _M_create_node(val);
+		_XNodeBase *_end = &this->_M_impl._M_node;
+		/* Lock end, then the first node.
+		 */
+		while (1) {
+			_end->lock();
+			_XNodeBase *_next = _end->_M_next;
+			if ((_next == _end) || _next->try_lock()) break;
+			_end->unlock();
+			sched_yield();
+		}
+		_XNodeBase *_next = _end->_M_next;
+		_M_link(_node, _end, _next);
+		if (_next != _end) _next->unlock();
+		_end->unlock();
 	}
 	/**
 	 * Delete last node of list.
@@ -980,9 +1112,8 @@ public:
 	 * \endcode
 	 * So after prepare, list iterations couldn't see target node ("B").
 	 * But any iteration on this node ("B") can go back/forward.
-	 * Beacause of one write/delete operation at a time on XList, 
-	 * you could position this function in your critical section
-	 * and protect him by lock.
+	 * Concurrent writers would change just neighbours of target node,
+	 * so you don't need to protect this function by a lock.
 	 * After preparation, "xerase" call could be done out of critical 
 	 * section. So actual deletion of target node wouldn't block your
 	 * critical section.
@@ -991,45 +1122,75 @@ public:
 	 */
 	bool xerase_prepare(iterator pos)
 	{
+		_XNodeBase *_node = pos._M_node;
+		_XNodeBase *_next, *_prev;
 		/* Check to see can erase this node? 
 		 */
-		if (! pos._M_node->erasing()) return false;
+		if (! _node->erasing()) return false;
+		/* Lock node, then his neighbours. Neighbours could be
+		 * changed by concurrent writers, so they would be read
+		 * under lock of node. Node is locked before of neighbours,
+		 * so they would be tried, and all locks would be released
+		 * on failure to prevent deadlock.
+		 */
+		while (1) {
+			_node->lock();
+			_next = _node->_M_next;
+			_prev = _node->_M_prev;
+			if (_prev->try_lock()) {
+				if ((_next == _prev) || _next->try_lock())
+					break;
+				_prev->unlock();
+			}
+			_node->unlock();
+			sched_yield();
+		}
 		/* Change prev pointer of next node.
-		 * Because of pos._M_prev points to the prev node, we should
-		 * access him. there is one more pointer to this node.
-		 * Beacause of one write at a time, access without lock on
-		 * node.
+		 * Because of _node->_M_prev points to the prev node, 
+		 * we should access him. there is one more pointer to 
+		 * this node.
 		 */
-		pos._M_node->_M_prev->access();
-		pos._M_node->_M_next->chNextPrev(NULL, pos._M_node->_M_prev);
+		_prev->access();
+		_next->_M_prev = _prev;
 		/* Release without lock, because we are before of "xerase",
 		 * So there is no waiting for uasge.
 		 */
-		pos._M_node->release();
+		_node->release();
 		/* Change next pointer of prev node.
-		 * Because of pos._M_next points to the next node, we should
-		 * access him. there is one more pointer to this node.
-		 * Beacause of one write at a time, access without lock on
-		 * node
+		 * Because of _node->_M_next points to the next node, 
+		 * we should access him. there is one more pointer to 
+		 * this node.
 		 */
-		pos._M_node->_M_next->access();
-		pos._M_node->_M_prev->chNextPrev(pos._M_node->_M_next, NULL);
-		/* Release without lock, because we are before of "xerase",
-		 * So there is no waiting for uasge.
-		 */
-		pos._M_node->release();
+		_next->access();
+		_prev->_M_next = _next;
+		_node->release();
+		if (_next != _prev) _next->unlock();
+		_prev->unlock();
+		_node->unlock();
+		-- _M_impl._M_size;
 		return true;
 	}
 	/** 
 	 * Destroy node.
+	 * \param dispose would be called on data of the node, after all
+	 * 	accesses to the node finished.
+	 *
 	 * Destructor of the node would wait to finish all concurrent 
 	 * accesses to the node.
 	 * By the block nature of this function, it 's appropriate to call and 
 	 * use XList in multithreaded environment.
+	 *
+	 * If list has a reclaimer, node would be given to the reclaimer and
+	 * this function wouldn't block. Iterators on the node would be
+	 * released by their owners (they shouldn't be "reset").
 	 */
-	void xerase(iterator pos)
+	void xerase(iterator pos, FT_disposeData dispose = NULL)
 	{
 		_XNode *__n = static_cast<_XNode*>(pos._M_node);
+		if (reclaimer) {
+			_M_defer(__n, dispose);
+			return;
+		}
 		_XNodeBase *__M_next = __n->_M_next;
 		_XNodeBase *__M_prev = __n->_M_prev;
 		/* Decrement usage by "one" because There is another iterator 
@@ -1039,15 +1200,51 @@ public:
 		/* Finalize iteration.
 		 */
 		pos.fini();
-		_M_get_Node_allocator().destroy(__n);
-		/* Node destroyed, so release next/prev nodes.
-		 */
-		__M_next->lock();
-		__M_next->release();
-		__M_next->unlock();
-		__M_prev->lock();
-		__M_prev->release();
-		__M_prev->unlock();
+		if (dispose) {
+			__n->waitForUsage();
+			dispose(__n->_M_data);
+		}
+		_M_destroy(__n, __M_next, __M_prev);
+	}
+	/**
+	 * Prepare node at "pos" for erase and add him to "batch".
+	 * \see xerase_prepare
+	 */
+	bool xerase_prepare(iterator pos, erase_batch &batch)
+	{
+		if (! xerase_prepare(pos)) return false;
+		batch.push_back(pos._M_node);
+		return true;
+	}
+	/**
+	 * Destroy all nodes of "batch".
+	 * \param dispose would be called on data of each node, after all
+	 * 	accesses to the node finished.
+	 *
+	 * All nodes have been unlinked before, so new accesses couldn't
+	 * reach any of them, and waits for concurrent accesses would be 
+	 * overlapped: erasing of a batch waits about one time for readers,
+	 * not one time per node.
+	 * Caller shouldn't have any iterator on the nodes of batch.
+	 * Nodes would be destroyed in order of preparation, because nodes
+	 * prepared later may be accessed by nodes prepared sooner.
+	 */
+	void xerase(erase_batch &batch, FT_disposeData dispose = NULL)
+	{
+		for (typename erase_batch::iterator iter = batch.begin();
+						iter != batch.end(); ++iter) {
+			_XNode *__n = static_cast<_XNode*>(*iter);
+			if (reclaimer) {
+				_M_defer(__n, dispose);
+				continue;
+			}
+			if (dispose) {
+				__n->waitForUsage();
+				dispose(__n->_M_data);
+			}
+			_M_destroy(__n, __n->_M_next, __n->_M_prev);
+		}
+		batch.clear();
 	}
 	/**
 	 * Call of "xerase-prepare" & "xerase" in one function call.
@@ -1059,7 +1256,7 @@ public:
 			 * another iterator on this node that "pos" is 
 			 * copy of that.
 			 */
-			pos._M_node->release();
+			if (! reclaimer) pos._M_node->release();
 			xerase(pos);
 		}
 	}
@@ -1072,15 +1269,125 @@ public:
 	}
 	/**  
 	 * Returns the number of elements in the %XList.  
+	 *
+	 * Number is kept by "push_back" & "xerase_prepare", so there is 
+	 * no iteration on nodes.
 	 */
 	size_type size() const
 	{
-		return std::distance(begin(), end()); 
+		return _M_impl._M_size.load();
+	}
+	/**
+	 * Is the %XList empty?
+	 */
+	bool empty() const
+	{
+		return size() == 0;
+	}
+	/**
+	 * Use "_reclaimer" to free erased nodes, NULL: erasers would free
+	 * nodes themselves.
+	 */
+	void set_reclaimer(XReclaimer *_reclaimer)
+	{
+		reclaimer = _reclaimer;
+	}
+	XReclaimer *get_reclaimer() const
+	{
+		return reclaimer;
 	}
 	~XList()
 	{
 		clear();
+		/* Nodes given to the reclaimer would release next/prev
+		 * nodes, so wait for them.
+		 */
+		if (reclaimer) reclaimer->wait(pending);
 	}
+
+protected:
+	/**
+	 * \class _XReclaimJob
+	 * Erased node of list, to be freed by reclaimer.
+	 */
+	class _XReclaimJob : public XReclaimer::Job
+	{
+	public:
+		_XReclaimJob(_XList *_list, _XNode *_node, 
+						FT_disposeData _dispose) :
+			list(_list), node(_node), disposeData(_dispose)
+		{ }
+		bool ready()
+		{
+			return node->unused();
+		}
+		void dispose()
+		{
+			if (disposeData) disposeData(node->_M_data);
+			list->_M_destroy(node, node->_M_next, node->_M_prev);
+			/* No one could touch an unused node, so memory of
+			 * node could be freed too.
+			 */
+			list->_M_put_node(node);
+			-- list->pending;
+		}
+	private:
+		_XList *list;
+		_XNode *node;
+		FT_disposeData disposeData;
+	};
+
+	/**
+	 * Give unlinked node "__n" to the reclaimer.
+	 */
+	void _M_defer(_XNode *__n, FT_disposeData dispose)
+	{
+		++ pending;
+		reclaimer->enqueue(new _XReclaimJob(this, __n, dispose));
+	}
+	/**
+	 * Destroy unlinked node "__n" and release his next/prev nodes.
+	 * Destructor of the node would wait to finish all concurrent 
+	 * accesses to the node.
+	 */
+	void _M_destroy(_XNode *__n, _XNodeBase *__M_next, 
+						_XNodeBase *__M_prev)
+	{
+		_M_get_Node_allocator().destroy(__n);
+		/* Node destroyed, so release next/prev nodes.
+		 */
+		__M_next->lock();
+		__M_next->release();
+		__M_next->unlock();
+		__M_prev->lock();
+		__M_prev->release();
+		__M_prev->unlock();
+	}
+	/**
+	 * Link new "node" between "prev" and "next".
+	 * "prev" & "next" should have been locked.
+	 */
+	void _M_link(_XNodeBase *node, _XNodeBase *prev, _XNodeBase *next)
+	{
+		node->_M_next = next;
+		node->_M_prev = prev;
+		/* There would be two pointers to the new node.
+		 */
+		node->access();
+		node->access();
+		prev->_M_next = node;
+		next->_M_prev = node;
+		++ _M_impl._M_size;
+	}
+
+	/**
+	 * Reclaimer of erased nodes, may be NULL.
+	 */
+	XReclaimer *reclaimer;
+	/**
+	 * Number of nodes given to the reclaimer and not freed yet.
+	 */
+	std::atomic<unsigned> pending;
 };
 
 } // namespace pparam
@@ -0,0 +1,172 @@
+/**
+ * \file xnotify.hpp
+ * Defines pool of threads to deliver change notifications.
+ *
+ * Modifiers would queue notifications of their dependents and return
+ * immediately, notifications of one object would be coalesced while
+ * they are pending.
+ *
+ * Copyright 2014 PDNSoft Co. (www.pdnsoft.com)
+ * \author hamid jafarian (hamid.jafarian@pdnsoft.com)
+ *
+ * xnotify is part of PParam.
+ *
+ * PParam is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PParam is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PParam.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _PDN_XNOTIFY_HPP_
+#define _PDN_XNOTIFY_HPP_
+
+#include <pthread.h>
+
+#include <atomic>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+#include "exception.hpp"
+
+namespace pparam
+{
+
+/**
+ * \class XNotifyExecutor
+ * Asynchronous delivery of change notifications by a pool of threads.
+ *
+ * Each notification is a "Task" of one target (key), there would be
+ * at most one pending task per target: tasks submitted while another
+ * task of the target is pending would be dropped. Tasks of one target
+ * wouldn't run concurrently, a task submitted while the target is
+ * running would run after him.
+ * \code
+ * 	XNotifyExecutor executor(4);
+ * 	XObjectList<Type> list("objects", "objects");
+ * 	list.set_notifier(&executor);
+ * 	// mod() wouldn't notify dependents himself anymore.
+ * \endcode
+ */
+class XNotifyExecutor
+{
+public:
+	/**
+	 * \class Task
+	 * One notification to be delivered.
+	 */
+	class Task
+	{
+	public:
+		/**
+		 * Errors should be reported by task himself, exceptions
+		 * would be dropped by the executor.
+		 */
+		virtual void run() = 0;
+		virtual ~Task() {}
+	};
+
+	/**
+	 * Start worker threads.
+	 * \param threads number of workers.
+	 */
+	XNotifyExecutor(int threads = 2) throw (Exception);
+	/**
+	 * Give "task" of "key" to the executor, task would be deleted
+	 * after run (or when coalesced).
+	 * \return false: task coalesced with a pending task of "key".
+	 */
+	bool submit(const void *key, Task *task);
+	/**
+	 * Wait until all of submitted tasks have been run.
+	 */
+	void flush();
+	/**
+	 * Number of pending tasks.
+	 */
+	size_t get_queueDepth();
+	unsigned long get_submitted() const
+	{
+		return submitted.load();
+	}
+	unsigned long get_coalesced() const
+	{
+		return coalesced.load();
+	}
+	unsigned long get_delivered() const
+	{
+		return delivered.load();
+	}
+	/**
+	 * Number of tasks that have thrown exceptions.
+	 */
+	unsigned long get_failed() const
+	{
+		return failed.load();
+	}
+	/**
+	 * Run all of pending tasks, and stop workers.
+	 */
+	~XNotifyExecutor();
+
+private:
+	XNotifyExecutor(const XNotifyExecutor &);
+	XNotifyExecutor &operator=(const XNotifyExecutor &);
+
+	static void *run(void *arg);
+
+	/**
+	 * State of a target.
+	 */
+	struct Target
+	{
+		/**
+		 * Pending task, NULL if there isn't.
+		 */
+		Task *task;
+		/**
+		 * Is there a running task of target?
+		 */
+		bool running;
+		/**
+		 * Is target in "queue"?
+		 */
+		bool queued;
+	};
+
+	typedef std::unordered_map<const void *, Target> Targets;
+
+	/**
+	 * Targets with pending task, in order of submission.
+	 */
+	std::deque<const void *> queue;
+	Targets targets;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	/**
+	 * Would be signaled when executor becomes idle.
+	 */
+	pthread_cond_t idle_cond;
+	std::vector<pthread_t> workers;
+	/**
+	 * Number of running tasks.
+	 */
+	int running;
+	bool stopping;
+
+	std::atomic<unsigned long> submitted;
+	std::atomic<unsigned long> coalesced;
+	std::atomic<unsigned long> delivered;
+	std::atomic<unsigned long> failed;
+};
+
+} // namespace pparam
+
+#endif // _PDN_XNOTIFY_HPP_
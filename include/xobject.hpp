@@ -24,8 +24,25 @@
 #ifndef _PDN_XOBJECT_HPP_
 #define _PDN_XOBJECT_HPP_
 
+#include <string.h>
+
+#include <list>
+#include <unordered_map>
+#include <unordered_set>
+#include <deque>
+#include <vector>
+
+#include <libxml/parser.h>
+
 #include "xparam.hpp"
 #include "sparam.hpp"
+#include "xatom.hpp"
+#include "xdepindex.hpp"
+#include "xpark.hpp"
+#include "xdeadline.hpp"
+#include "xjournal.hpp"
+#include "xsnapshot.hpp"
+#include "xnotify.hpp"
 
 namespace pparam 
 {
@@ -78,12 +95,27 @@ public:
 	{
 		return transitionTable[from][to];
 	}
+	/**
+	 * Is "status" a read-only status?
+	 *
+	 * Read-only statuses are shared, many threads could hold them
+	 * at once on one object.
+	 */
+	static bool isShared(int status)
+	{
+		return (status == SCANNING) || (status == QUERYING) ||
+			(status == PRINTING);
+	}
 };
 
 template <typename Type>
 class XObject;
 template <typename Type>
 class XObjectList;
+template <typename Type>
+class XShardedObjectList;
+template <typename Type>
+class XObjectTraversal;
 
 /**
  * \class XObjectConnection
@@ -142,7 +174,7 @@ public:
 		notify = c.notify;
 		type = c.type;
 		oside = c.oside;
-		cid = c.cid.value();
+		cid = c.cid;
 
 		return *this;
 	}
@@ -194,12 +226,14 @@ public:
 
 	/**
 	 * Name of connection.
+	 *
+	 * Names and roles are interned, so they are compared as integers.
 	 */
-	string name;
+	XAtom name;
 	/**
 	 * Role of other side of connection.
 	 */
-	string role;
+	XAtom role;
 	/**
 	 * Do notify other side of conection about changes on this side 
 	 * of connection?
@@ -276,15 +310,15 @@ public:
 	 * "match" the "c" connection to see scanner would scan this connection
 	 * or not.
 	 */
-	bool match(const _XObjectConnection c)
+	bool match(const _XObjectConnection &c) const
 	{
 		if (use_name 	&& (c.name != cond.name))	return false;
 		if (use_role  	&& (c.role != cond.role))	return false;
 		if (use_notify 	&& (c.notify != cond.notify)) 	return false;
 		if (use_type 	&& (c.type != cond.type))	return false;
 		if (use_oside 	&& (c.oside != cond.oside))	return false;
-		if (use_cid	&& (c.cid.value() != 
-					cond.cid.value()))	return false;
+		if (use_cid	&& (c.cid.key() != 
+					cond.cid.key()))	return false;
 		return true;
 	}
 	void setCondition(const _XObjectConnection &c)
@@ -326,6 +360,48 @@ public:
 	bool use_cid;
 };
 
+/**
+ * \class XTraversalEpoch
+ * Epochs of XObject traversals.
+ *
+ * Each traversal stamps visited objects by his epoch, so there isn't
+ * any visited-set allocation per traversal. Epochs of running
+ * traversals are registered here, so concurrent traversals wouldn't
+ * overwrite each others stamps.
+ */
+class XTraversalEpoch
+{
+public:
+	/**
+	 * Start a traversal.
+	 * \param registered would be false, if there isn't any free slot
+	 * 	to register the epoch, such traversal shouldn't stamp objects.
+	 * \return epoch of traversal.
+	 */
+	static unsigned begin(bool &registered);
+	/**
+	 * End of traversal.
+	 */
+	static void end(unsigned epoch, bool registered);
+	/**
+	 * Is traversal of "epoch" running?
+	 */
+	static bool active(unsigned epoch);
+
+private:
+	static const int SLOTS = 64;
+
+	static std::atomic<unsigned> next;
+	/**
+	 * Epochs of running traversals.
+	 */
+	static std::atomic<unsigned> slots[SLOTS];
+	/**
+	 * Number of slots that have been used.
+	 */
+	static std::atomic<int> used;
+};
+
 /**
  * \class XObject 
  * Defines XObject attributes.
@@ -363,6 +439,8 @@ template <typename _Type>
 class XObject : public XMixParam
 {
 	friend class XObjectList<_Type>;
+	friend class XShardedObjectList<_Type>;
+	friend class XObjectTraversal<_Type>;
 public:
 	/**
 	 * \enum XObjectNotify
@@ -477,48 +555,183 @@ public:
 		 */
 		XObjectNotify nt;
 	};
+	/**
+	 * \class XObjectNotifyTask
+	 * Notification of dependents of an object, would be delivered by
+	 * XNotifyExecutor.
+	 */
+	class XObjectNotifyTask : public XNotifyExecutor::Task
+	{
+	public:
+		XObjectNotifyTask(const typename XObjectList<Type>::iterator
+				&_target, XObjectNotify _nt, LogSystem *_logs) :
+			target(_target), nt(_nt), logs(_logs)
+		{}
+		/**
+		 * Errors of notification would be logged, executor would
+		 * continue with other tasks.
+		 */
+		void run()
+		{
+			_XObject *xobj = (_XObject *)*target;
+			try {
+				xobj->notifyDependentObjects(nt);
+			} catch (Exception &e) {
+				log(xobj, e.what());
+			} catch (std::exception &e) {
+				log(xobj, e.what());
+			}
+		}
+	private:
+		void log(_XObject *xobj, const string &what)
+		{
+			if (! logs) return;
+			string err = "Can't notify dependents of " + 
+				xobj->get_name() + " !: " + what;
+			*logs << LogLevel::ERROR << err;
+		}
+		/**
+		 * Iterator on the modified object, he wouldn't be freed
+		 * before delivery.
+		 */
+		typename XObjectList<Type>::iterator target;
+		XObjectNotify nt;
+		/**
+		 * Log system of list of object.
+		 */
+		LogSystem *logs;
+	};
 	
 	XObject(const string &objClass) : XMixParam(objClass), 
 			xoKey("uuid"), xoName("name"),
 			xoType(objClass),
-			xoStatus("status", ObjStatus::LOADED),
-			xoStatus_prev("status", ObjStatus::LOADED),
-			cListVersion("xobj_clist_version", 0, -1)
+			xoState(ObjStatus::LOADED |
+				(ObjStatus::LOADED << PREV_SHIFT)),
+			visitEpoch(0),
+			cListVersion("xobj_clist_version", 0, -1),
+			notifyExecutor(NULL),
+			listLogs(NULL),
+			depIndex(NULL),
+			cIndex(NULL),
+			xmlVersion(0),
+			imageVersion(0),
+			imageRuntime(false),
+			imageIndent(0)
 	{
 		addParam(&xoKey);
 		addParam(&xoName);
 		addParam(xoType.getTypeParam());
-		//addParam(&xoStatus);
 		//addParam(&cListVersion);
 
-		xoStatus.set_runtime();
 		cListVersion.set_runtime();
 
 		pthread_mutex_init(&obj_status_lock, NULL);
-		pthread_cond_init(&obj_status_cond, NULL);
+		pthread_mutex_init(&image_lock, NULL);
 		ruse = 0;
 	}
 
 	XObject() : XMixParam("UNNAMED_OBJ_CLASS"),
 			xoKey("uuid"), xoName("name"),
 			xoType("UNNAMED_OBJ_CLASS"),
-			xoStatus("status", ObjStatus::LOADED),
-			xoStatus_prev("status", ObjStatus::LOADED),
-			cListVersion("xobj_clist_version", 0, -1)
+			xoState(ObjStatus::LOADED |
+				(ObjStatus::LOADED << PREV_SHIFT)),
+			visitEpoch(0),
+			cListVersion("xobj_clist_version", 0, -1),
+			notifyExecutor(NULL),
+			listLogs(NULL),
+			depIndex(NULL),
+			cIndex(NULL),
+			xmlVersion(0),
+			imageVersion(0),
+			imageRuntime(false),
+			imageIndent(0)
 	{
 		addParam(&xoKey);
 		addParam(&xoName);
 		addParam(xoType.getTypeParam());
-		//addParam(&xoStatus);
 		//addParam(&cListVersion);
 
-		xoStatus.set_runtime();
 		cListVersion.set_runtime();
 
 		pthread_mutex_init(&obj_status_lock, NULL);
-		pthread_cond_init(&obj_status_cond, NULL);
+		pthread_mutex_init(&image_lock, NULL);
 		ruse = 0;
 	}
+	virtual ~XObject()
+	{
+		/* Index accesses to the connections should be released
+		 * before the list.
+		 */
+		delete cIndex.load();
+	}
+
+	typedef XObjectSnapshot::Image XmlImage;
+	/**
+	 * Xml of object as an immutable image, shared with snapshots.
+	 *
+	 * Image would be regenerated (in PRINTING status) just if object
+	 * has been changed since last image, \see get_xmlVersion.
+	 * \param refresh false: don't regenerate, return NULL if image
+	 * isn't up to date.
+	 * \return NULL: object couldn't be printed (e-g- he is deleted).
+	 */
+	XmlImage xmlImage(bool show_runtime, const int &indent,
+				const string &endl, bool refresh = true)
+	{
+		unsigned long v = xmlVersion.load();
+		pthread_mutex_lock(&image_lock);
+		if (image && (imageVersion == v) && 
+				(imageRuntime == show_runtime) &&
+				(imageIndent == indent) && (imageEndl == endl)) {
+			XmlImage ret = image;
+			pthread_mutex_unlock(&image_lock);
+			return ret;
+		}
+		pthread_mutex_unlock(&image_lock);
+		if (! refresh) return XmlImage();
+		if (! chStatus(ObjStatus::PRINTING)) return XmlImage();
+		/* Connections may change in PRINTING status, so version
+		 * is read before printing them.
+		 */
+		v = xmlVersion.load();
+		XmlImage ret;
+		try {
+			ret = std::make_shared<const string>(
+				xobj_xml(show_runtime, indent, endl));
+		} catch (...) {
+			bkStatus();
+			throw;
+		}
+		bkStatus();
+		pthread_mutex_lock(&image_lock);
+		if (!image || (imageVersion <= v)) {
+			image = ret;
+			imageVersion = v;
+			imageRuntime = show_runtime;
+			imageIndent = indent;
+			imageEndl = endl;
+		}
+		pthread_mutex_unlock(&image_lock);
+		return ret;
+	}
+	/**
+	 * Version of object xml.
+	 *
+	 * Would increment by any exclusive status (add, modify, delete, 
+	 * reload) and by any change in connections.
+	 */
+	unsigned long get_xmlVersion() const
+	{
+		return xmlVersion.load();
+	}
+	/**
+	 * Object has been changed out of exclusive statuses (e-g- by
+	 * direct setting of his parameters), drop his xml image.
+	 */
+	void touchXml()
+	{
+		++ xmlVersion;
+	}
 
 	bool key(string &_key) const
 	{
@@ -563,12 +776,39 @@ public:
 	}
 	XInt get_status()
 	{
-		return xoStatus.get_value();
+		return xoState.load() & STATUS_MASK;
 	}
 	c_iterator cListEnd()
 	{
 		return cList.end();
 	}
+	/**
+	 * Enable/Disable hash indexes on connections.
+	 *
+	 * Objects with many connections would enable indexes, then
+	 * queries by connection id or by other side would not scan
+	 * whole of the connections list.
+	 */
+	void set_connectionIndex(bool enable)
+	{
+		ConnectionIndex *index = NULL;
+		pthread_mutex_lock(&obj_status_lock);
+		if (enable && !cIndex.load()) {
+			index = new ConnectionIndex;
+			for (c_iterator iter = cList.begin(); 
+					iter != cList.end(); ++iter)
+				index->insert(iter);
+			cIndex.store(index);
+			index = NULL;
+		} else if (!enable)
+			index = cIndex.exchange(NULL);
+		pthread_mutex_unlock(&obj_status_lock);
+		delete index;
+	}
+	bool get_connectionIndex() const
+	{
+		return cIndex.load() != NULL;
+	}
 	/**
 	 * Should be implemented with leaf-inherited classes.
 	 */
@@ -609,7 +849,7 @@ public:
 		size_t gtPos = str.find('>');
 		/* insert object status and connections.
 		 */
-		str.insert(gtPos + 1, xoStatus_prev.xml(show_runtime)
+		str.insert(gtPos + 1, prevStatus().xml(show_runtime)
 				+ cListVersion.xml(show_runtime)
 				+ xml_connectionsList());
 		return str;
@@ -631,6 +871,14 @@ public:
 		}
 		return sxml;
 	}
+	/**
+	 * Objects are small, so stream them by their locked _xml().
+	 */
+	virtual void xmlStream(std::ostream &os, bool show_runtime,
+			const int &indent, const string &endl) const
+	{
+		os << _xml(show_runtime, indent, endl);
+	}
 	string shell_xml()
 	{
 		string	shellXml = "<row>";
@@ -639,7 +887,7 @@ public:
 			shellXml += "<columns>";
 			shellXml += "<column>" + get_key() + "</column>";
 			shellXml += "<column>" + get_name() + "</column>";
-			shellXml += "<column>" + xoStatus_prev.value()
+			shellXml += "<column>" + prevStatus().value()
 				+ "</column>";
 			shellXml += "<column>" + xoType.value() + "</column>";
 			shellXml += "</columns>";
@@ -696,6 +944,17 @@ public:
 					TracePoint("xobject"));
 		}
 	}
+	/**
+	 * Keys of objects that "_add" of this object would depend on
+	 * (e.g. would connect to them), base on loaded attributes.
+	 *
+	 * Parallel addition of loaded objects would add them before this
+	 * object. Inherited objects that connect to others in "_add"
+	 * should develope this function.
+	 * \see XObjectList::set_addThreads
+	 */
+	virtual void loadDependencies(std::vector<string> &keys) const
+	{ }
 	/**
 	 * Delete object from system.
 	 */
@@ -723,7 +982,7 @@ public:
 			chStatus(ObjStatus::DELETED);
 			disconnectAll();
 		} else {
-			throw Exception("Can't prepare object : " + get_name()
+			throw Exception("Can't prepare object : " + get_key()
 					+ " for deleting!",
 					TracePoint("xobject"));
 		}
@@ -751,13 +1010,13 @@ public:
 			bkStatus();
 			if (e.is_nok()) {
 				set_name(xo->get_name());
-				notifyDependentObjects(OBJ_NOTIFY_MODIFY);
+				notifyDependents(OBJ_NOTIFY_MODIFY);
 			}
 			e.addTracePoint(TracePoint("xobject"));
 			throw e;
 		}
 		bkStatus();
-		notifyDependentObjects(OBJ_NOTIFY_MODIFY);
+		notifyDependents(OBJ_NOTIFY_MODIFY);
 	}
 	/**
 	 * Prepare object for reloading.
@@ -790,74 +1049,79 @@ public:
 	 * \param [in] async If it set to false (default), change the status of
 	 * the object ot SCANNING, otherwise, do not change the status of the
 	 * object
+	 *
+	 * Objects would be scanned in prefix (DFS) order, each object at
+	 * most once. \see XObjectTraversal
 	 */
 	ScannerAction scan(_XObjectScanner &s,const bool async = false)
 	{
-		if ((!async) && (! chStatus(ObjStatus::SCANNING)))
-			return _XObjectScanner::SA_CONTINUE;
-		ScannerAction sact = s.scan((_XObject *) *this_iter);
-		if (!async)
-			bkStatus();
-
-		switch (sact) {
-		case _XObjectScanner::SA_FORWARD:
-			/* FORWARD received, so scan connections to "this".
-			 */
-			for (c_iterator iter = cList.begin(); 
-					iter != cList.end(); ++iter) {
-				if (! s.match(*iter)) continue;
-
-				_XObject *xobj = (_XObject *) *(iter->oside);
-				switch (xobj->scan(s)) {
-				case _XObjectScanner::SA_CONTINUE:
-					/* Continue scanning of "this" 
-					 * connections.
-					 */
-					continue;
-					break;
-				case _XObjectScanner::SA_BACKWARD:
-					/* UP recieved from one 
-					 * connections, so shoud return
-					 * to parent and continue
-					 * scanning objects at "this" 
-					 * level.
-					 */
-					s.scan_return((_XObject *)*this_iter);
-					return _XObjectScanner::SA_CONTINUE;
-					break;
-				case _XObjectScanner::SA_END:
-					s.scan_return((_XObject *)*this_iter);
-					return _XObjectScanner::SA_END;
-					break;
-				case _XObjectScanner::SA_FORWARD:
-					/* This case doen't occure, because 
-					 * scan don't return SA_FORWARD.
-					 * Scan handles SA_FORWARD himself.
-					 */
-					break;
-				}
-			}
-			break;
-		case _XObjectScanner::SA_BACKWARD:
-			/* Don't continue scanning in this level, return
-			 * and continue scanning in parent level.
-			 */
-			s.scan_return((_XObject *)*this_iter);
-			return _XObjectScanner::SA_BACKWARD;
-			break;
-		case _XObjectScanner::SA_CONTINUE:
-			/* continue scanning of objects with mine level.
-			*/	
-			s.scan_return((_XObject *)*this_iter);
-			return _XObjectScanner::SA_CONTINUE;
-			break;
-		case _XObjectScanner::SA_END:
-			s.scan_return((_XObject *)*this_iter);
-			return _XObjectScanner::SA_END;
-			break;
+		XObjectTraversal<Type> traversal;
+		return traversal.run(this, s, async);
+	}
+	/**
+	 * Scan like of "scan", but give up waits on objects statuses after
+	 * "msec" milliseconds.
+	 *
+	 * Exception with "ETIMEDOUT" errno would be thrown, if some 
+	 * objects couldn't be scanned in time.
+	 */
+	ScannerAction scan_for(_XObjectScanner &s, unsigned int msec)
+							throw (Exception)
+	{
+		XDeadline deadline(msec);
+		ScannerAction sact = scan(s);
+		if (deadline.is_fired()) {
+			Exception e("Scanning of object : " + get_key() +
+					" timed out !", TracePoint("xobject"));
+			e.set_errno(ETIMEDOUT);
+			throw e;
+		}
+		return sact;
+	}
+	/**
+	 * Scan without waiting on busy objects.
+	 * \see scan_for
+	 */
+	ScannerAction try_scan(_XObjectScanner &s) throw (Exception)
+	{
+		try {
+			return scan_for(s, 0);
+		} catch (Exception &e) {
+			e.addTracePoint(TracePoint("xobject"));
+			throw e;
+		}
+	}
+	/**
+	 * Xml of object, but give up waiting for object after "msec"
+	 * milliseconds.
+	 *
+	 * Exception with "ETIMEDOUT" errno would be thrown on timeout.
+	 */
+	string xml_for(unsigned int msec, bool show_runtime = false) const
+							throw (Exception)
+	{
+		XDeadline deadline(msec);
+		string ret = xml(show_runtime);
+		if (deadline.is_fired()) {
+			Exception e("Printing of object : " + get_key() +
+					" timed out !", TracePoint("xobject"));
+			e.set_errno(ETIMEDOUT);
+			throw e;
+		}
+		return ret;
+	}
+	/**
+	 * Xml of object, without waiting on busy object.
+	 * \see xml_for
+	 */
+	string try_xml(bool show_runtime = false) const throw (Exception)
+	{
+		try {
+			return xml_for(0, show_runtime);
+		} catch (Exception &e) {
+			e.addTracePoint(TracePoint("xobject"));
+			throw e;
 		}
-		s.scan_return((_XObject *)*this_iter);
-		return _XObjectScanner::SA_CONTINUE;
 	}
 	/**
 	 * Return list of object connections in "XML" format.
@@ -895,6 +1159,31 @@ public:
 	{
 		return false;
 	}
+	/**
+	 * Has this object structural equivalency?
+	 *
+	 * Object list would compare structures (operator==) of objects
+	 * that return true only, so types that develope operator== should
+	 * develope this function too. Default objects have no structural
+	 * equivalency and aren't indexed by structure.
+	 */
+	virtual bool has_structural_key() const
+	{
+		return false;
+	}
+	/**
+	 * Hash key of structural parameters.
+	 *
+	 * Objects that could be equivalent (operator==) should have same
+	 * structural key; object list would compare structures of objects
+	 * with same key only. Used when has_structural_key() is true;
+	 * empty key (default) puts all of objects in one bucket, so each
+	 * object would be compared with all of others.
+	 */
+	virtual string structural_key() const
+	{
+		return "";
+	}
 	/**
 	 * Returns xml-formatted of this and all objects that is 
 	 * connect to this object.
@@ -914,25 +1203,76 @@ protected:
 	 * Change object status.
 	 *
 	 * This function would wait to see appropriate object status to
+	 * transit to "_status".
+	 *
+	 * DIRECT transitions are done by a compare-and-swap on "xoState",
+	 * threads park only on WAIT transitions. A read-only (shared)
+	 * status would be joined if it could be reached directly from the
+	 * status under him, so concurrent readers don't wait for each
+	 * other.
 	 */
 	bool chStatus(XInt _status)
 	{
-		pthread_mutex_lock(&obj_status_lock);
+		/* Connections are added under "obj_status_lock" while object
+		 * isn't being deleted, so deletion statuses would be set
+		 * under that lock.
+		 */
+		bool guarded = (_status == ObjStatus::DELETING) ||
+				(_status == ObjStatus::DELETED);
+		unsigned s = xoState.load();
 		while (1) {
-			switch (ObjStatus::canTransit(xoStatus.get_value(),
-								_status)) {
+			XInt cur = s & STATUS_MASK;
+			unsigned ns;
+			ObjStatus::StatusTransition tr;
+			if (ObjStatus::isShared(cur) &&
+					ObjStatus::isShared(_status) &&
+					(ObjStatus::canTransit(
+						(s >> PREV_SHIFT) & STATUS_MASK,
+						_status) == ObjStatus::DIRECT)) {
+				/* join the readers.
+				 */
+				tr = ObjStatus::DIRECT;
+				ns = s + READER_ONE;
+			} else {
+				tr = ObjStatus::canTransit(cur, _status);
+				/* Other readers should leave before any 
+				 * exclusive status.
+				 */
+				if ((tr == ObjStatus::DIRECT) &&
+						ObjStatus::isShared(cur) &&
+						(s >= 2 * READER_ONE))
+					tr = ObjStatus::WAIT;
+				ns = _status | (cur << PREV_SHIFT);
+				if (ObjStatus::isShared(_status))
+					ns += READER_ONE;
+			}
+			switch (tr) {
 			case ObjStatus::DIRECT: /* there is direct transition*/
-				setStatus(_status);
-				pthread_mutex_unlock(&obj_status_lock);
+				if (guarded) {
+					pthread_mutex_lock(&obj_status_lock);
+					bool done = xoState.
+						compare_exchange_strong(s, ns);
+					pthread_mutex_unlock(&obj_status_lock);
+					if (!done) continue;
+				} else if (!xoState.compare_exchange_weak(s, ns))
+					continue;
+				/* Object would be changed in exclusive
+				 * statuses, so his xml image is stale.
+				 */
+				if (! ObjStatus::isShared(_status))
+					++ xmlVersion;
+				/* Say to others, status has been changed.
+				 */
+				if ((s & STATE_WAITERS) && !(ns & STATE_WAITERS))
+					XParkingLot::unpark(&xoState);
 				return true;
 				break;
 			case ObjStatus::WAIT: /* would wait, may be ability
 						to transit */
-				pthread_cond_wait(&obj_status_cond, 
-							&obj_status_lock);
+				if (!waitStatus(s)) return false;
+				s = xoState.load();
 				break;
 			case ObjStatus::NONE: /* can't transit */
-				pthread_mutex_unlock(&obj_status_lock);
 				return false;
 				break;
 			}
@@ -942,24 +1282,52 @@ protected:
 	 * Back object status to previous status.
 	 *
 	 * With suppose that transition could be done.
+	 * Shared statuses would be restored by their last reader.
 	 */
 	void bkStatus()
 	{
-		pthread_mutex_lock(&obj_status_lock);
-		setStatus(xoStatus_prev.get_value());
-		pthread_mutex_unlock(&obj_status_lock);
+		unsigned s = xoState.load();
+		unsigned ns;
+		XInt cur;
+		do {
+			cur = s & STATUS_MASK;
+			if (ObjStatus::isShared(cur) && (s >= 2 * READER_ONE))
+				ns = (s - READER_ONE) & ~STATE_WAITERS;
+			else
+				ns = ((s >> PREV_SHIFT) & STATUS_MASK) |
+							(cur << PREV_SHIFT);
+		} while (!xoState.compare_exchange_weak(s, ns));
+		/* Changes of exclusive status are done. */
+		if (! ObjStatus::isShared(cur)) ++ xmlVersion;
+		if (s & STATE_WAITERS)
+			XParkingLot::unpark(&xoState);
+	}
+	/**
+	 * Wait for any change in "xoState" from "s".
+	 * \return false: deadline of the thread passed.
+	 * \see XDeadline
+	 */
+	bool waitStatus(unsigned s)
+	{
+		if (!(s & STATE_WAITERS) &&
+			!xoState.compare_exchange_strong(s, s | STATE_WAITERS))
+			/* State has been changed. */
+			return true;
+		if (XParkingLot::park(&xoState, xoState, s | STATE_WAITERS,
+						XDeadline::abstime()))
+			return true;
+		XDeadline::fire();
+		return false;
 	}
 	/**
-	 * Set object status to specified value.
-	 * \note should be called in protected area with "obj_status_lock".
+	 * Previous status as a parameter, for xml generation.
 	 */
-	void setStatus(XInt _status)
+	XEnumParam<XObjectStatus> prevStatus() const
 	{
-		xoStatus_prev = xoStatus;
-		xoStatus = _status;
-		/* Say to others, status has been changed.
-		 */
-		pthread_cond_broadcast(&obj_status_cond);
+		XEnumParam<XObjectStatus> prev("status",
+			(xoState.load() >> PREV_SHIFT) & STATUS_MASK);
+		prev.set_runtime();
+		return prev;
 	}
 	/**
 	 * Connect to specified object from this object.
@@ -976,7 +1344,7 @@ protected:
 	{
 		/* Make connection ids identical.
 		 */
-		fromc.cid = toc.cid.value();
+		fromc.cid = toc.cid;
 		/* Change other side of connections, because each object
 		 * stores connection attributes of other side.
 		 */
@@ -984,7 +1352,7 @@ protected:
 		fromc.oside = this_iter;
 		addConnection(toc);
 		if (! ((_XObject *) *(toc.oside))->addConnection(fromc, true)) {
-			delConnection(toc.cid.value());
+			delConnection(toc.cid.key());
 			return false;
 		}
 		return true;
@@ -1031,7 +1399,7 @@ protected:
 	}
 	c_iterator disconnect(c_iterator &iter)
 	{
-		string cid = iter->cid.value();
+		UUIDKey cid = iter->cid.key();
 		if (xdelConnection_prepare(iter)) {
 			//disconnectNotice(*iter);
 			((_XObject *) *(iter->oside))->delConnection(cid);
@@ -1052,24 +1420,42 @@ protected:
 			pthread_mutex_unlock(&obj_status_lock);
 			return false;
 		}
-		while (xoStatus.get_value() == ObjStatus::DELETING)
+		unsigned s;
+		while (((s = xoState.load()) & STATUS_MASK) ==
+						ObjStatus::DELETING) {
 			/* In DELETING status we should wait to see what would
 			 * happen?
 			 * If object deleted, can't add new connection, else
 			 * may add new connection.
 			 */
-			pthread_cond_wait(&obj_status_cond, &obj_status_lock);
-		if (xoStatus.get_value() == ObjStatus::DELETED) {
+			pthread_mutex_unlock(&obj_status_lock);
+			if (!waitStatus(s)) return false;
+			pthread_mutex_lock(&obj_status_lock);
+		}
+		if ((s & STATUS_MASK) == ObjStatus::DELETED) {
 			pthread_mutex_unlock(&obj_status_lock);
 			return false;
 		}
 		cList.push_back(c);
-		if (c.type == _XObjectConnection::STRONG)
+		if (cIndex.load()) {
+			/* Connections are pushed just under this lock, so the
+			 * last one is ours.
+			 */
+			c_iterator last = cList.end();
+			-- last;
+			cIndex.load()->insert(last);
+		}
+		if (c.type == _XObjectConnection::STRONG) {
 			/* "ruse" or "resource usage" would present
 			 * number of strong connections.
 			 */
 			++ ruse;
+			if (depIndex)
+				depIndex->addEdge(get_key(),
+						(*(c.oside))->get_key());
+		}
 		++ cListVersion;
+		++ xmlVersion;
 		pthread_mutex_unlock(&obj_status_lock);
 		/* Notice about new connection to this at "to" side.
 		 */
@@ -1104,13 +1490,13 @@ protected:
 	 */
 	void delConnection(const string &cid)
 	{
-		for (c_iterator iter = cList.begin(); 
-				iter != cList.end(); ++iter) {
-			if (iter->cid.value() == cid) {
-				delConnection(iter);
-				break;
-			}
-		}
+		UUIDKey k;
+		if (k.parse(cid)) delConnection(k);
+	}
+	void delConnection(const UUIDKey &cid)
+	{
+		c_iterator iter = queryConnection(cid);
+		if (iter != cList.end()) delConnection(iter);
 	}
 	/**
 	 * Delete connection base on position in connections list.
@@ -1131,9 +1517,19 @@ protected:
 		bool ret;
 		pthread_mutex_lock(&obj_status_lock);
 		ret = cList.xerase_prepare(iter);
-		if (ret && (iter->type == _XObjectConnection::STRONG))
+		if (ret && cIndex.load())
+			/* Index holds an access to the node, it should be
+			 * released before "xerase".
+			 */
+			cIndex.load()->erase(iter);
+		if (ret && (iter->type == _XObjectConnection::STRONG)) {
 			-- ruse;
+			if (depIndex)
+				depIndex->delEdge(get_key(),
+						(*(iter->oside))->get_key());
+		}
 		++ cListVersion;
+		++ xmlVersion;
 		pthread_mutex_unlock(&obj_status_lock);
 		return ret;
 	}
@@ -1163,9 +1559,29 @@ protected:
 	 */
 	c_iterator queryConnection(const string &cid)
 	{
+		UUIDKey k;
+		if (! k.parse(cid)) return cList.end();
+		return queryConnection(k);
+	}
+	c_iterator queryConnection(const UUIDKey &cid)
+	{
+		if (cIndex.load()) {
+			c_iterator ret = cList.end();
+			pthread_mutex_lock(&obj_status_lock);
+			ConnectionIndex *index = cIndex.load();
+			if (index) {
+				typename ConnectionIndex::CidIndex::iterator
+					pos = index->byCid.find(cid);
+				if (pos != index->byCid.end())
+					ret = pos->second;
+				pthread_mutex_unlock(&obj_status_lock);
+				return ret;
+			}
+			pthread_mutex_unlock(&obj_status_lock);
+		}
 		for (c_iterator iter = cList.begin(); 
 					iter != cList.end(); ++iter)
-			if (iter->cid.value() == cid) return iter;
+			if (iter->cid.key() == cid) return iter;
 		return cList.end();
 	}
 	/**
@@ -1184,6 +1600,26 @@ protected:
 	 */
 	c_iterator queryConnection(_XObjectScanner &s, const string &objID)
 	{
+		if (cIndex.load()) {
+			c_iterator ret = cList.end();
+			pthread_mutex_lock(&obj_status_lock);
+			ConnectionIndex *index = cIndex.load();
+			if (index) {
+				std::pair<typename ConnectionIndex::PeerIndex::
+					iterator, typename ConnectionIndex::
+					PeerIndex::iterator> range =
+					index->byPeer.equal_range(objID);
+				for (; range.first != range.second;
+							++ range.first)
+					if (s.match(*(range.first->second))) {
+						ret = range.first->second;
+						break;
+					}
+				pthread_mutex_unlock(&obj_status_lock);
+				return ret;
+			}
+			pthread_mutex_unlock(&obj_status_lock);
+		}
 		for (c_iterator iter = cList.begin(); 
 					iter != cList.end(); ++iter)
 			if (s.match(*iter) && 
@@ -1205,7 +1641,8 @@ protected:
 	/**
 	 * Notify dependent objects from changes in this object.
 	 * 
-	 * In this function, looping in notification path don't check.
+	 * Each dependent object would be notified once, even if there are
+	 * loops in notification path.
 	 * If some connection need notification about any change in its
 	 * peer, so we notify him.
 	 * Notify would be stopped when modification doen't have any effect
@@ -1216,6 +1653,21 @@ protected:
 		XObjectNotifier notifier(this, nt);
 		scan(notifier);
 	}
+	/**
+	 * Notify dependent objects by "notifyExecutor", or by this thread
+	 * if there isn't any executor.
+	 *
+	 * Notifications of one object would be coalesced while pending.
+	 */
+	void notifyDependents(XObjectNotify nt)
+	{
+		if (notifyExecutor)
+			notifyExecutor->submit(this,
+					new XObjectNotifyTask(this_iter, nt,
+								listLogs));
+		else
+			notifyDependentObjects(nt);
+	}
 	/**
 	 * All leaf-inherited classes that want to catch changes notification
 	 * in dependent objects, should implement this function.
@@ -1263,13 +1715,36 @@ protected:
 	 */
 	Type xoType;
 	/**
-	 * XObject status in his lifecycle.
+	 * Bits of "xoState".
+	 */
+	enum {
+		/**
+		 * XObject status in his lifecycle.
+		 */
+		STATUS_MASK = 0xf,
+		/**
+		 * Previous status.
+		 */
+		PREV_SHIFT = 4,
+		/**
+		 * There are threads parked on status changes.
+		 */
+		STATE_WAITERS = 0x100,
+		/**
+		 * Rest of bits are number of readers in a shared status.
+		 */
+		READER_SHIFT = 9,
+		READER_ONE = 1 << READER_SHIFT
+	};
+	/**
+	 * Status, previous status and readers of xobject.
 	 */
-	XEnumParam<XObjectStatus> xoStatus;
+	std::atomic<unsigned> xoState;
 	/**
-	 * Stores previous status.
+	 * Epoch of last traversal that visited this object.
+	 * \see XObjectTraversal
 	 */
-	XEnumParam<XObjectStatus> xoStatus_prev;
+	std::atomic<unsigned> visitEpoch;
 
 	/**
 	 * List of connections to other objects.
@@ -1291,62 +1766,558 @@ protected:
 	 */
 	XInt ruse;
 	/**
-	 * Condition to trace any changes in xoStatus.
-	 */
-	pthread_cond_t obj_status_cond;
-	/**
-	 * Lock to manage asynchronus access to xoStatus.
+	 * Lock to manage asynchronus access to connections, deletion
+	 * statuses would also be set under this lock.
 	 */
 	pthread_mutex_t obj_status_lock;
 	/**
 	 * Iterator to this object in object list.
 	 */
 	typename XObjectList<Type>::iterator this_iter;
-};
-
-template <class Type>
-class XObjectRepository;
-
-/*y
- * \class XObjectList
- * Manages list of XObject\<type\> and any function on that.
- *
- * Objects store base on their keys and may query/delete base on their
- * keys.
- * On object list we can only have one add()/one del() at one time.
- * mod() operations can occure concurrently.
- * Also base on objects dependencies, concurrent with add()/del()/mod()
- * we can have mod() operations called base on object dependecies.
- */
-template <typename Type>
-class XObjectList
-{
-public:
 	/**
-	 * \typedef _XObject for easy type definition.
+	 * Executor of notifications to dependents, NULL: notify them
+	 * synchronously.
 	 */
-	typedef XObject<Type>			_XObject;
-	typedef XObjectList<Type>		_XObjectList;
-	typedef typename Type::Literal 		TypeLiteral;
-	typedef std::vector<TypeLiteral> 	Priority;
-
-	typedef XListParam<_XObject, string> 	List;
-	typedef typename List::iterator 	iterator;
-	typedef typename List::const_iterator 	const_iterator;
-	typedef typename List::riterator 	riterator;
-	typedef typename List::const_riterator 	const_riterator;
+	XNotifyExecutor *notifyExecutor;
 	/**
-	 * \typedef Status
-	 * A synonim for XObjectStatus.
+	 * Log system of list, errors of asynchronous notifications would
+	 * be logged by him.
 	 */
-	typedef XObjectStatus ObjStatus;
-
-	XObjectList(const string &name, const string &logName) : list(name),
-		logs(logName)
-	{
+	LogSystem *listLogs;
+	/**
+	 * Index of dependents of objects, NULL: not indexed.
+	 */
+	XDependencyIndex *depIndex;
+	/**
+	 * \struct ConnectionIndex
+	 * Hash indexes on connections, by connection id and by key of
+	 * other side.
+	 *
+	 * Entries hold accesses to the nodes of "cList", so they are
+	 * removed at "xerase_prepare".
+	 */
+	struct ConnectionIndex
+	{
+		typedef std::unordered_map<UUIDKey, c_iterator, 
+						UUIDKey::Hash> CidIndex;
+		typedef std::unordered_multimap<string, c_iterator> PeerIndex;
+
+		void insert(c_iterator &iter)
+		{
+			byCid[iter->cid.key()] = iter;
+			byPeer.insert(std::make_pair(
+					(*(iter->oside))->get_key(), iter));
+		}
+		void erase(c_iterator &iter)
+		{
+			byCid.erase(iter->cid.key());
+			std::pair<typename PeerIndex::iterator, 
+				typename PeerIndex::iterator> range = 
+				byPeer.equal_range((*(iter->oside))->get_key());
+			for (; range.first != range.second; ++ range.first)
+				if (range.first->second == iter) {
+					byPeer.erase(range.first);
+					break;
+				}
+		}
+
+		CidIndex byCid;
+		PeerIndex byPeer;
+	};
+	/**
+	 * Connection indexes, NULL: connections are scanned linearly.
+	 *
+	 * Changed under "obj_status_lock".
+	 */
+	std::atomic<ConnectionIndex *> cIndex;
+	/**
+	 * Version of object xml, \see get_xmlVersion.
+	 */
+	std::atomic<unsigned long> xmlVersion;
+	/**
+	 * Last xml image of object and his version and format, guarded
+	 * by "image_lock".
+	 */
+	XmlImage image;
+	unsigned long imageVersion;
+	bool imageRuntime;
+	int imageIndent;
+	string imageEndl;
+	pthread_mutex_t image_lock;
+};
+
+/**
+ * \class XObjectTraversal
+ * Iterative traversal of connected XObjects by an XObjectScanner.
+ *
+ * Traversal would be done without recursion, in DFS (prefix) or BFS order,
+ * with the semantics of "ScannerAction" values:
+ * SA_FORWARD would traverse matched connections of the object, 
+ * SA_CONTINUE would continue in current level, SA_BACKWARD would return
+ * to upper level (in BFS it's like of SA_CONTINUE) and SA_END would end 
+ * the traversal.
+ * Each object would be visited at most once in a traversal, so cyclic
+ * connections are safe. Objects deeper than "maxDepth" wouldn't be 
+ * traversed (start object is at depth 0).
+ *
+ * "run_parallel" would traverse the graph level by level (BFS) by some
+ * threads, in this mode scanner functions would be called concurrently.
+ */
+template <typename Type>
+class XObjectTraversal
+{
+public:
+	typedef XObject<Type>				_XObject;
+	typedef XObjectScanner<Type>			_XObjectScanner;
+	typedef typename _XObjectScanner::ScannerAction ScannerAction;
+	typedef typename _XObject::c_iterator		c_iterator;
+	typedef XObjectStatus				ObjStatus;
+
+	/**
+	 * \enum Order
+	 * Order of traversal.
+	 */
+	enum Order {
+		DFS,	/**< Depth first, prefix order. */
+		BFS,	/**< Breadth first, level by level. */
+	};
+
+	/**
+	 * \param maxDepth maximum depth of traversal, -1: unlimited.
+	 */
+	XObjectTraversal(Order _order = DFS, int _maxDepth = -1) :
+		order(_order), maxDepth(_maxDepth), localUsed(false)
+	{
+		pthread_mutex_init(&lock, NULL);
+	}
+	~XObjectTraversal()
+	{
+		pthread_mutex_destroy(&lock);
+	}
+	/**
+	 * Traverse from "start".
+	 * \param async don't change status of "start" to SCANNING, like of
+	 * 	"XObject::scan".
+	 * \return action of "start", SA_CONTINUE, SA_BACKWARD or SA_END.
+	 */
+	ScannerAction run(_XObject *start, _XObjectScanner &s,
+						bool async = false)
+	{
+		Epoch e(this);
+		if (order == BFS) return bfs(start, s, async);
+		return dfs(start, s, async);
+	}
+	/**
+	 * Traverse from "start" in BFS order by "threads" threads.
+	 *
+	 * "s" should be thread safe.
+	 */
+	ScannerAction run_parallel(_XObject *start, _XObjectScanner &s,
+					int threads, bool async = false)
+	{
+		Epoch e(this);
+		if (threads < 2) return bfs(start, s, async);
+		return pbfs(start, s, threads, async);
+	}
+
+private:
+	XObjectTraversal(const XObjectTraversal &);
+	XObjectTraversal &operator = (const XObjectTraversal &);
+
+	/**
+	 * Start/end of traversal epoch, in scope.
+	 */
+	struct Epoch
+	{
+		Epoch(XObjectTraversal *_t) : t(_t)
+		{
+			t->epoch = XTraversalEpoch::begin(t->registered);
+			t->local.clear();
+			t->localUsed = !t->registered;
+			t->stop = false;
+		}
+		~Epoch()
+		{
+			XTraversalEpoch::end(t->epoch, t->registered);
+		}
+		XObjectTraversal *t;
+	};
+	/**
+	 * DFS stack frame.
+	 */
+	struct Frame
+	{
+		Frame(_XObject *_xobj, int _depth) : xobj(_xobj),
+			next(_xobj->cList.begin()), depth(_depth) {}
+		_XObject *xobj;
+		/**
+		 * Next connection to traverse.
+		 */
+		c_iterator next;
+		int depth;
+	};
+	struct Item
+	{
+		Item(_XObject *_xobj, int _depth) :
+			xobj(_xobj), depth(_depth) {}
+		_XObject *xobj;
+		int depth;
+	};
+	/**
+	 * Visit "xobj" for first time?
+	 *
+	 * Object would be stamped by epoch of this traversal, if his stamp
+	 * belongs to another running traversal, visit would be recorded
+	 * in "local" set.
+	 */
+	bool visit(_XObject *xobj)
+	{
+		unsigned m = xobj->visitEpoch.load();
+		while (registered) {
+			if (m == epoch) return false;
+			if (m && XTraversalEpoch::active(m)) break;
+			if (!xobj->visitEpoch.compare_exchange_weak(m, epoch))
+				continue;
+			if (!localUsed.load()) return true;
+			/* May be visited before, when stamp belonged to
+			 * the other traversal.
+			 */
+			pthread_mutex_lock(&lock);
+			bool visited = local.count(xobj);
+			pthread_mutex_unlock(&lock);
+			return !visited;
+		}
+		localUsed = true;
+		pthread_mutex_lock(&lock);
+		bool first = (xobj->visitEpoch.load() != epoch) &&
+					local.insert(xobj).second;
+		pthread_mutex_unlock(&lock);
+		return first;
+	}
+	/**
+	 * Scan "xobj", if it's not visited.
+	 * \return false: object hasn't been scanned.
+	 */
+	bool scanObject(_XObject *xobj, _XObjectScanner &s, bool async,
+							ScannerAction &sact)
+	{
+		if (!visit(xobj)) return false;
+		if (!async && !xobj->chStatus(ObjStatus::SCANNING))
+			return false;
+		sact = s.scan(xobj);
+		if (!async) xobj->bkStatus();
+		return true;
+	}
+	/**
+	 * Should connections of object at "depth" be traversed?
+	 */
+	bool expand(ScannerAction sact, int depth)
+	{
+		return (sact == _XObjectScanner::SA_FORWARD) &&
+			((maxDepth < 0) || (depth < maxDepth));
+	}
+	/**
+	 * Next matched connection of frame "f".
+	 * \return NULL: there isn't any more connection.
+	 */
+	_XObject *nextChild(Frame &f, _XObjectScanner &s)
+	{
+		while (f.next != f.xobj->cList.end()) {
+			c_iterator c = f.next;
+			++ f.next;
+			if (s.match(*c)) return (_XObject *) *(c->oside);
+		}
+		return NULL;
+	}
+	ScannerAction dfs(_XObject *start, _XObjectScanner &s, bool async)
+	{
+		ScannerAction sact;
+		stack.clear();
+		if (!scanObject(start, s, async, sact))
+			return _XObjectScanner::SA_CONTINUE;
+		if (!expand(sact, 0)) {
+			s.scan_return(start);
+			return (sact == _XObjectScanner::SA_FORWARD) ?
+				_XObjectScanner::SA_CONTINUE : sact;
+		}
+		stack.push_back(Frame(start, 0));
+		while (!stack.empty()) {
+			ScannerAction ret = _XObjectScanner::SA_CONTINUE;
+			int depth = stack.back().depth + 1;
+			_XObject *child = nextChild(stack.back(), s);
+			if (child) {
+				if (!scanObject(child, s, false, sact))
+					continue;
+				if (expand(sact, depth)) {
+					stack.push_back(Frame(child, depth));
+					continue;
+				}
+				s.scan_return(child);
+				if ((sact == _XObjectScanner::SA_FORWARD) ||
+					(sact == _XObjectScanner::SA_CONTINUE))
+					continue;
+				/* BACKWARD: return to parent of "this" level.
+				 */
+				if (sact == _XObjectScanner::SA_END)
+					ret = _XObjectScanner::SA_END;
+			}
+			/* Return from top of stack, parents would return
+			 * too on SA_END.
+			 */
+			do {
+				s.scan_return(stack.back().xobj);
+				stack.pop_back();
+			} while (!stack.empty() &&
+					(ret == _XObjectScanner::SA_END));
+			if (ret == _XObjectScanner::SA_END) return ret;
+		}
+		return _XObjectScanner::SA_CONTINUE;
+	}
+	ScannerAction bfs(_XObject *start, _XObjectScanner &s, bool async)
+	{
+		ScannerAction sact;
+		queue.clear();
+		queue.push_back(Item(start, 0));
+		while (!queue.empty()) {
+			Item item = queue.front();
+			queue.pop_front();
+			if (!scanObject(item.xobj, s,
+					async && (item.xobj == start), sact))
+				continue;
+			if (expand(sact, item.depth))
+				for (c_iterator c = item.xobj->cList.begin();
+					c != item.xobj->cList.end(); ++c)
+					if (s.match(*c))
+						queue.push_back(Item((_XObject *)
+							*(c->oside),
+							item.depth + 1));
+			s.scan_return(item.xobj);
+			if (sact == _XObjectScanner::SA_END) {
+				queue.clear();
+				return sact;
+			}
+		}
+		return _XObjectScanner::SA_CONTINUE;
+	}
+	/**
+	 * Shared data of parallel BFS workers.
+	 */
+	struct Level
+	{
+		XObjectTraversal *t;
+		_XObjectScanner *s;
+		_XObject *start;
+		bool async;
+		int depth;
+		/**
+		 * Objects of current level.
+		 */
+		std::vector<_XObject *> objects;
+		/**
+		 * Objects of next level.
+		 */
+		std::vector<_XObject *> next;
+		std::atomic<size_t> pos;
+		/**
+		 * Would be set when there isn't any more level.
+		 */
+		bool done;
+		/**
+		 * Barriers are sized by number of started workers, so
+		 * workers wait on "gate" until they are initialized.
+		 */
+		pthread_mutex_t gate;
+		pthread_barrier_t start_barrier;
+		pthread_barrier_t end_barrier;
+	};
+	static void *worker(void *arg)
+	{
+		Level *l = (Level *)arg;
+		pthread_mutex_lock(&l->gate);
+		pthread_mutex_unlock(&l->gate);
+		while (1) {
+			pthread_barrier_wait(&l->start_barrier);
+			if (l->done) break;
+			l->t->scanLevel(l);
+			pthread_barrier_wait(&l->end_barrier);
+		}
+		return NULL;
+	}
+	/**
+	 * Scan objects of current level, would be called by all workers.
+	 */
+	void scanLevel(Level *l)
+	{
+		std::vector<_XObject *> next;
+		ScannerAction sact;
+		size_t i;
+		while (!stop && ((i = l->pos.fetch_add(1)) <
+						l->objects.size())) {
+			_XObject *xobj = l->objects[i];
+			if (!scanObject(xobj, *l->s,
+					l->async && (xobj == l->start), sact))
+				continue;
+			if (expand(sact, l->depth))
+				for (c_iterator c = xobj->cList.begin();
+					c != xobj->cList.end(); ++c)
+					if (l->s->match(*c))
+						next.push_back((_XObject *)
+							*(c->oside));
+			l->s->scan_return(xobj);
+			if (sact == _XObjectScanner::SA_END) stop = true;
+		}
+		pthread_mutex_lock(&lock);
+		l->next.insert(l->next.end(), next.begin(), next.end());
+		pthread_mutex_unlock(&lock);
+	}
+	ScannerAction pbfs(_XObject *start, _XObjectScanner &s, int threads,
+								bool async)
+	{
+		Level l;
+		l.t = this;
+		l.s = &s;
+		l.start = start;
+		l.async = async;
+		l.depth = 0;
+		l.done = false;
+		l.objects.push_back(start);
+		pthread_mutex_init(&l.gate, NULL);
+		pthread_mutex_lock(&l.gate);
+		std::vector<pthread_t> workers(threads - 1);
+		int started = 0;
+		for (int i = 0; i < threads - 1; ++i)
+			if (pthread_create(&workers[started], NULL, worker,
+								&l) == 0)
+				++ started;
+		/* Caller is a worker too. */
+		pthread_barrier_init(&l.start_barrier, NULL, started + 1);
+		pthread_barrier_init(&l.end_barrier, NULL, started + 1);
+		pthread_mutex_unlock(&l.gate);
+		while (1) {
+			l.pos = 0;
+			l.done = l.objects.empty() || stop;
+			pthread_barrier_wait(&l.start_barrier);
+			if (l.done) break;
+			scanLevel(&l);
+			pthread_barrier_wait(&l.end_barrier);
+			l.objects.swap(l.next);
+			l.next.clear();
+			++ l.depth;
+		}
+		for (int i = 0; i < started; ++i)
+			pthread_join(workers[i], NULL);
+		pthread_barrier_destroy(&l.start_barrier);
+		pthread_barrier_destroy(&l.end_barrier);
+		pthread_mutex_destroy(&l.gate);
+		return stop ? _XObjectScanner::SA_END :
+					_XObjectScanner::SA_CONTINUE;
+	}
+
+	Order order;
+	int maxDepth;
+	/**
+	 * Epoch of current traversal.
+	 */
+	unsigned epoch;
+	/**
+	 * Is "epoch" registered in XTraversalEpoch?
+	 */
+	bool registered;
+	/**
+	 * Objects that have been visited, while their stamp belonged to
+	 * other traversals.
+	 */
+	std::unordered_set<_XObject *> local;
+	std::atomic<bool> localUsed;
+	/**
+	 * SA_END has been received in parallel traversal.
+	 */
+	std::atomic<bool> stop;
+	/**
+	 * Lock of "local" and parallel workers.
+	 */
+	pthread_mutex_t lock;
+	std::vector<Frame> stack;
+	std::deque<Item> queue;
+};
+
+template <class Type>
+class XObjectRepository;
+
+/*y
+ * \class XObjectList
+ * Manages list of XObject\<type\> and any function on that.
+ *
+ * Objects store base on their keys and may query/delete base on their
+ * keys.
+ * On object list we can only have one add()/one del() at one time.
+ * mod() operations can occure concurrently.
+ * Also base on objects dependencies, concurrent with add()/del()/mod()
+ * we can have mod() operations called base on object dependecies.
+ */
+template <typename Type>
+class XObjectList
+{
+	friend class XShardedObjectList<Type>;
+	friend class XObjectRepository<Type>;
+public:
+	/**
+	 * \typedef _XObject for easy type definition.
+	 */
+	typedef XObject<Type>			_XObject;
+	typedef XObjectList<Type>		_XObjectList;
+	typedef typename Type::Literal 		TypeLiteral;
+	typedef std::vector<TypeLiteral> 	Priority;
+
+	typedef XListParam<_XObject, string> 	List;
+	typedef typename List::iterator 	iterator;
+	typedef typename List::const_iterator 	const_iterator;
+	typedef typename List::riterator 	riterator;
+	typedef typename List::const_riterator 	const_riterator;
+	/**
+	 * \typedef Status
+	 * A synonim for XObjectStatus.
+	 */
+	typedef XObjectStatus ObjStatus;
+	/**
+	 * \typedef Index
+	 * Hash index of objects, objects loaded from xml may have
+	 * duplicated keys/names.
+	 */
+	typedef std::unordered_multimap<string, _XObject *>	Index;
+	/**
+	 * \typedef TypeIndex
+	 * Objects of one type.
+	 */
+	typedef std::list<iterator>				TypeIndex;
+	typedef std::map<TypeLiteral, TypeIndex>		TypeIndexes;
+	typedef std::pair<TypeLiteral, typename TypeIndex::iterator>
+								TypePos;
+	typedef std::unordered_map<_XObject *, TypePos>		TypePositions;
+
+	XObjectList(const string &name, const string &logName) : list(name),
+		compression(XCompression::AUTO), logs(logName), repo(NULL),
+		notifyExecutor(NULL),
+		depIndex(NULL),
+		addThreads(1),
+		journaled(false),
+		journalSync(true),
+		journalCompactSize(0),
+		journal(NULL),
+		compacting(false),
+		compactorStarted(false),
+		snapshots(false)
+	{
 		list.enable_smap();
 		pthread_mutex_init(&dup_lock, NULL);
 		pthread_rwlock_init(&list_lock, NULL);
+		pthread_mutex_init(&journal_lock, NULL);
+		pthread_mutex_init(&compact_lock, NULL);
+	}
+	~XObjectList()
+	{
+		joinCompactor();
+		delete journal.load();
 	}
 
 	string get_name() const
@@ -1387,7 +2358,9 @@ public:
 		}
 		/* Going to the loaded object. */
 		-- ret;
+		enterList(ret);
 		unlock();
+		indexObject((_XObject *)*ret);
 		pthread_mutex_unlock(&dup_lock);
 		return ret;
 	}
@@ -1416,10 +2389,18 @@ public:
 				 */
 				nxo->disconnectAll();
 				nxo->this_iter_fini();
+				pthread_mutex_lock(&dup_lock);
+				unindexObject(nxo);
+				pthread_mutex_unlock(&dup_lock);
+				wrlock();
+				unindexType(nxo);
+				unlock();
 				list.del(iter);
-			} 
+			} else
+				journalObject(XJournal::ADD, iter);
 			throw e;
 		}
+		journalObject(XJournal::ADD, iter);
 		return iter;
 	}
 	/**
@@ -1452,6 +2433,12 @@ public:
 	 */
 	iterator del(const string &key) throw (Exception)
 	{
+		/* Objects with dependents are busy, there isn't any need
+		 * to lock anything for them.
+		 */
+		if (depIndex && depIndex->has_dependents(key))
+			throw Exception("Can't delete busy object !",
+						TracePoint("xobject"));
 		wrlock();
 		iterator iter = list.find(key);
 		if (iter == end()) {
@@ -1473,26 +2460,15 @@ public:
 	 */
 	iterator del(iterator &iter) throw (Exception)
 	{
-		_XObject *obj = static_cast<_XObject *>(*iter);
 		try {
-			obj->del();
+			delObject(static_cast<_XObject *>(*iter));
 		} catch (Exception &e) {
 			e.addTracePoint(TracePoint("xobject"));
-			if (e.is_failed()) {
-				string err = obj->get_name() + 
-					" couldn't be deleted: " +
-					e.what();
-				logs << LogLevel::ERROR << err;
-				throw e;
-			} else if (e.is_nok()) {
-				string err = obj->get_name() + 
-					" was deleted but some errors\
-					occured: " +
-					e.what();
-				logs << LogLevel::INFO << err;
-				throw e;
-			}
+			if (! e.is_failed())
+				journalObject(XJournal::DEL, iter);
+			throw e;
 		}
+		journalObject(XJournal::DEL, iter);
 		if (xdel_prepare(iter)) return xdel(iter);
 		else return ++ iterator(iter);
 	}
@@ -1517,26 +2493,29 @@ public:
 	}
 	/**
 	 * Delete all objects of specified type.
+	 *
+	 * Deleted objects would be removed from list in one batch.
 	 */
 	bool delType(TypeLiteral type)
 	{
 		bool isOK = true;
-		iterator iter = begin();
-		while (iter != end()) {
-			_XObject *xobj = (_XObject*)*iter;
-			if (xobj->get_type() != type) {
-				++ iter;
-				continue;
-			}
+		std::vector<iterator> objects, deleted;
+		query_type_lock(type, objects);
+		for (typename std::vector<iterator>::iterator iter =
+				objects.begin(); iter != objects.end(); ++iter) {
 			try {
-				iter = del(iter);
+				delObject((_XObject*)**iter);
+				deleted.push_back(*iter);
 			} catch (Exception &e) {
 				if (e.is_failed()) {
 					isOK = false;
 				}
-				++ iter;
 			}
 		}
+		/* Deleted nodes shouldn't be used by "objects" in xdel.
+		 */
+		objects.clear();
+		xdel(deleted);
 		return isOK;
 	}
 	/**
@@ -1545,17 +2524,18 @@ public:
 	bool delAllTypes() 
 	{
 		bool isOK = true;
-		iterator iter = begin();
-		while (iter != end()) {
+		std::vector<iterator> deleted;
+		for (iterator iter = begin(); iter != end(); ++iter) {
 			try {
-				iter = del(iter);
+				delObject((_XObject*)*iter);
+				deleted.push_back(iter);
 			} catch (Exception &e) {
 				if (e.is_failed()) {
 					isOK = false;
 				}
-				++ iter;
 			}
 		}
+		xdel(deleted);
 		return isOK;
 	}
 	/**
@@ -1589,6 +2569,7 @@ public:
 		}
 		unlock();
 		_XObject *old_obj = static_cast<_XObject *>(*old_obj_iter);
+		string name = xo->get_name(), skey = xo->structural_key();
 		pthread_mutex_lock(&dup_lock);
 		try {
 			verifyObjectDuplication(xo, old_obj);
@@ -1610,11 +2591,23 @@ public:
 					"for modifying !",
 						TracePoint("xobject"));
 		}
+		/* Reserve new name/structure of object in indexes, so
+		 * concurrent verifications would see him.
+		 */
+		reindexObject(old_obj, old_obj->get_name(),
+				old_obj->structural_key(), name, skey);
 		pthread_mutex_unlock(&dup_lock);
 		try {
 			if (reload) old_obj->reload(xo);
 			else old_obj->mod(xo);
 		} catch (Exception &e) {
+			/* Object may keep his old name/structure.
+			 */
+			pthread_mutex_lock(&dup_lock);
+			reindexObject(old_obj, name, skey,
+					old_obj->get_name(),
+					old_obj->structural_key());
+			pthread_mutex_unlock(&dup_lock);
 			e.addTracePoint(TracePoint("xobject"));
 			if (e.is_failed()) {
 				string err = old_obj->get_name() + 
@@ -1628,49 +2621,170 @@ public:
 					occured: " +
 					e.what();
 				logs << LogLevel::INFO << err;
+				journalObject(XJournal::MOD, old_obj_iter);
 				throw e;
 			}
 		}
+		journalObject(XJournal::MOD, old_obj_iter);
 		return old_obj_iter;
 	}
 	/**
-	 * Query specified object.
+	 * Add like of "add", but give up waits on objects statuses after
+	 * "msec" milliseconds.
 	 *
-	 * Use when you are sure about lock on list.
+	 * Exceptions of timed out operations have "ETIMEDOUT" errno
+	 * (Exception::is_timedout), and object isn't added.
+	 * \see XDeadline
 	 */
-	iterator query(const string &objkey)
+	iterator add_for(_XObject *xo, unsigned int msec, bool clone = true)
+							throw (Exception)
 	{
-		return list.find(objkey);
+		XDeadline deadline(msec);
+		try {
+			return add(xo, clone);
+		} catch (Exception &e) {
+			if (deadline.is_fired()) e.set_errno(ETIMEDOUT);
+			e.addTracePoint(TracePoint("xobject"));
+			throw e;
+		}
 	}
 	/**
-	 * Lock the list and query specified object.
+	 * Add without waiting on busy objects.
+	 * \see add_for
 	 */
-	iterator query_lock(const string &objkey)
+	iterator try_add(_XObject *xo, bool clone = true) throw (Exception)
 	{
-		rdlock();
-		iterator iter = query(objkey);
-		unlock();
-		return iter;
+		try {
+			return add_for(xo, 0, clone);
+		} catch (Exception &e) {
+			e.addTracePoint(TracePoint("xobject"));
+			throw e;
+		}
 	}
 	/**
-	 * Query all objects of specified type.
-	 * 
-	 * \return false: can't query all objects, true: all objects queried.
+	 * Delete like of "del", but give up waiting for object after
+	 * "msec" milliseconds.
+	 * \see add_for
 	 */
-	bool query_type_lock(TypeLiteral _type, std::vector<iterator> &out)
+	iterator del_for(const string &key, unsigned int msec)
+							throw (Exception)
 	{
-		rdlock();
-		for (iterator iter = list.begin();
-					iter != list.end(); ++iter) {
-			if (((_XObject *)*iter)->get_type() == _type)
-				try {
-					out.push_back(iter);
-				} catch (std::exception &e) {
-					unlock();
-					return false;	
-				}
+		XDeadline deadline(msec);
+		try {
+			return del(key);
+		} catch (Exception &e) {
+			if (deadline.is_fired()) e.set_errno(ETIMEDOUT);
+			e.addTracePoint(TracePoint("xobject"));
+			throw e;
 		}
-		unlock();
+	}
+	/**
+	 * Delete without waiting on busy object.
+	 * \see del_for
+	 */
+	iterator try_del(const string &key) throw (Exception)
+	{
+		try {
+			return del_for(key, 0);
+		} catch (Exception &e) {
+			e.addTracePoint(TracePoint("xobject"));
+			throw e;
+		}
+	}
+	/**
+	 * Modify like of "mod", but give up waits on objects statuses
+	 * after "msec" milliseconds.
+	 * \see add_for
+	 */
+	iterator mod_for(_XObject *xo, unsigned int msec, bool reload = false)
+							throw (Exception)
+	{
+		XDeadline deadline(msec);
+		try {
+			return mod(xo, reload);
+		} catch (Exception &e) {
+			if (deadline.is_fired()) e.set_errno(ETIMEDOUT);
+			e.addTracePoint(TracePoint("xobject"));
+			throw e;
+		}
+	}
+	/**
+	 * Modify without waiting on busy objects.
+	 * \see mod_for
+	 */
+	iterator try_mod(_XObject *xo) throw (Exception)
+	{
+		try {
+			return mod_for(xo, 0);
+		} catch (Exception &e) {
+			e.addTracePoint(TracePoint("xobject"));
+			throw e;
+		}
+	}
+	/**
+	 * Reload object, but give up waits on objects statuses after
+	 * "msec" milliseconds.
+	 * \see mod_for
+	 */
+	iterator reload_for(_XObject *xo, unsigned int msec) throw (Exception)
+	{
+		try {
+			return mod_for(xo, msec, true);
+		} catch (Exception &e) {
+			e.addTracePoint(TracePoint("xobject"));
+			throw e;
+		}
+	}
+	/**
+	 * Reload without waiting on busy objects.
+	 * \see reload_for
+	 */
+	iterator try_reload(_XObject *xo) throw (Exception)
+	{
+		try {
+			return mod_for(xo, 0, true);
+		} catch (Exception &e) {
+			e.addTracePoint(TracePoint("xobject"));
+			throw e;
+		}
+	}
+	/**
+	 * Query specified object.
+	 *
+	 * Use when you are sure about lock on list.
+	 */
+	iterator query(const string &objkey)
+	{
+		return list.find(objkey);
+	}
+	/**
+	 * Lock the list and query specified object.
+	 */
+	iterator query_lock(const string &objkey)
+	{
+		rdlock();
+		iterator iter = query(objkey);
+		unlock();
+		return iter;
+	}
+	/**
+	 * Query all objects of specified type.
+	 * 
+	 * \return false: can't query all objects, true: all objects queried.
+	 */
+	bool query_type_lock(TypeLiteral _type, std::vector<iterator> &out)
+	{
+		rdlock();
+		typename TypeIndexes::iterator index = typeIndex.find(_type);
+		if (index != typeIndex.end())
+			try {
+				out.insert(out.end(), index->second.begin(),
+							index->second.end());
+			} catch (std::exception &e) {
+				unlock();
+				return false;	
+			}
+		unlock();
 		return true;
 	}
 	/**
@@ -1680,16 +2794,20 @@ public:
 	bool loadXmlStr(string xstr, XParam::XmlParser *parser = NULL) 
 						throw (Exception)
 	{
-		if (repo->cancelLoading()) return false;
+		if (cancelLoading()) return false;
 		wrlock();
 		try {
 			list.loadXmlStr(xstr, parser);
 		} catch(Exception &e) {
+			rebuildTypeIndex();
 			unlock();
+			rebuildIndexes();
 			e.addTracePoint(TracePoint("xobject"));
 			throw e;
 		}
+		rebuildTypeIndex();
 		unlock();
+		rebuildIndexes();
 		return true;
 	}
 	/**
@@ -1699,17 +2817,21 @@ public:
 	bool loadXmlDoc(string xdoc, XParam::XmlParser *parser = NULL) 
 						throw (Exception)
 	{
-		if (repo->cancelLoading()) return false;
+		if (cancelLoading()) return false;
 		wrlock();
 		set_xmlDoc(xdoc);
 		try {
 			list.loadXmlDoc(xdoc, parser);
 		} catch(Exception &e) {
+			rebuildTypeIndex();
 			unlock();
+			rebuildIndexes();
 			e.addTracePoint(TracePoint("xobject"));
 			throw e;
 		}
+		rebuildTypeIndex();
 		unlock();
+		rebuildIndexes();
 		return true;
 	}
 	/** 
@@ -1727,7 +2849,7 @@ public:
 			/* If there is any periority, add based on.
 			 */
 			for (int i = 0; i < size; ++i) {
-				if (repo->cancelLoading()) return false;
+				if (cancelLoading()) return false;
 				isOK = addLoadedObjectsType(priority.at(i))
 					&& isOK;
 			}
@@ -1743,24 +2865,210 @@ public:
 						throw (Exception)
 	{
 		try {
-			list.saveXmlDoc(xdoc, 
-					show_runtime, indent, with_endl);
+			if (snapshots)
+				snapshot(show_runtime, indent, with_endl).save(
+							xdoc, compression);
+			else
+				list.saveXmlDoc(xdoc, show_runtime, indent,
+						with_endl, compression);
 		} catch (Exception &e) {
-			unlock();
 			e.addTracePoint(TracePoint("xobject"));
 			throw e;
 		}
 	}
 	void save() throw (Exception)
+	{
+		if (! has_xmlDoc()) return;
+		if (journaled) compact();
+		else saveXmlDoc(get_xmlDoc());
+	}
+	/**
+	 * Persist changes of objects by journal of the list document.
+	 *
+	 * add/del/mod of objects would append records of changed objects
+	 * to "<xmlDoc>.journal", instead of saving whole of the document.
+	 * "load" would replay journal on the loaded document and "save"
+	 * would fold journal into the document (compaction).
+	 * Connections aren't part of the document, so they aren't
+	 * journaled.
+	 * \param compactSize compact journal in background when he grows
+	 * larger than this size (bytes), "0": compact just by "save".
+	 * \param sync return from changes when their records are on
+	 * the disk.
+	 * Should be set after "set_xmlDoc" and before "load"; changes of
+	 * threads may use the journal, so it can't be changed when list
+	 * has objects or journal has been opened.
+	 */
+	void set_journal(bool enable, off_t compactSize = 0, bool sync = true)
+							throw (Exception)
+	{
+		rdlock();
+		bool loaded = ! list.empty();
+		unlock();
+		pthread_mutex_lock(&journal_lock);
+		if (loaded || journal.load()) {
+			pthread_mutex_unlock(&journal_lock);
+			throw Exception("Can't change journal of loaded list " +
+					get_name() + " !",
+					TracePoint("xobject"));
+		}
+		journaled = enable;
+		journalCompactSize = compactSize;
+		journalSync = sync;
+		pthread_mutex_unlock(&journal_lock);
+	}
+	XJournal *get_journal()
+	{
+		return journal.load();
+	}
+	/**
+	 * Fold journal into the document.
+	 *
+	 * Records appended while compaction would be kept in journal,
+	 * they may be in the new document too, replay would apply them
+	 * again without any side effect.
+	 */
+	void compact() throw (Exception)
+	{
+		if (! has_xmlDoc()) return;
+		pthread_mutex_lock(&compact_lock);
+		try {
+			XJournal *j = openJournal();
+			if (j) {
+				off_t cut = j->mark();
+				saveXmlDoc(get_xmlDoc());
+				j->truncate(cut);
+			} else
+				saveXmlDoc(get_xmlDoc());
+		} catch (Exception &e) {
+			pthread_mutex_unlock(&compact_lock);
+			e.addTracePoint(TracePoint("xobject"));
+			throw e;
+		}
+		pthread_mutex_unlock(&compact_lock);
+	}
+	/**
+	 * Save list in "xdoc" by background writer.
+	 * \see XParam::saveXmlDocAsync
+	 */
+	XDocSaver::Result saveXmlDocAsync(const string &xdoc, 
+			bool show_runtime = false, const int &indent = 0, 
+			bool with_endl = false, XDocSaver *saver = NULL,
+			XDocSaver::FT_saveDone done = NULL, void *arg = NULL)
+							throw (Exception)
+	{
+		try {
+			if (! snapshots)
+				return list.saveXmlDocAsync(xdoc, show_runtime,
+					indent, with_endl, saver, done, arg,
+					compression);
+			string sxml = snapshot(show_runtime, indent, 
+							with_endl).xml();
+			if (saver == NULL) saver = XDocSaver::global();
+			return saver->save(xdoc, sxml, done, arg,
+				XCompression::select(compression, xdoc));
+		} catch (Exception &e) {
+			e.addTracePoint(TracePoint("xobject"));
+			throw e;
+		}
+	}
+	/**
+	 * Save list in his document by background writer.
+	 * \return completion of save, invalid result if list doesn't
+	 * have any document.
+	 */
+	XDocSaver::Result saveAsync(XDocSaver *saver = NULL,
+			XDocSaver::FT_saveDone done = NULL, void *arg = NULL)
+							throw (Exception)
 	{
 		if (has_xmlDoc())
-			saveXmlDoc(get_xmlDoc());
+			return saveXmlDocAsync(get_xmlDoc(), false, 0, false,
+							saver, done, arg);
+		return XDocSaver::Result();
 	}
 	string xml(bool show_runtime = false, 
 			const int &indent = 0, bool with_endl = false)
 	{
+		if (snapshots)
+			return snapshot(show_runtime, indent, with_endl).xml();
 		return list.xml(show_runtime, indent, with_endl);
 	}
+	/**
+	 * Point-in-time image of list.
+	 *
+	 * Images of changed objects are regenerated before any lock, so
+	 * writers would wait just for printing of their own objects. Then
+	 * images are collected under read lock of list, without printing
+	 * any object; objects changed between these two steps are printed
+	 * after the lock. Unchanged objects aren't printed at all.
+	 */
+	XObjectSnapshot snapshot(bool show_runtime = false,
+			const int &indent = 0, bool with_endl = false)
+	{
+		string endl = (with_endl) ? "\n" : "";
+		int oindent = (indent) ? indent + 4 : indent;
+		XObjectSnapshot::Images images;
+		StaleImages stale;
+		refreshImages(show_runtime, oindent, endl);
+		rdlock();
+		collectImages(images, stale, show_runtime, oindent, endl);
+		unlock();
+		fillImages(images, stale, show_runtime, oindent, endl);
+		XObjectSnapshot ret(list.get_pname(), list.get_version(),
+							indent, endl);
+		for (size_t i = 0; i < images.size(); ++i)
+			ret.addImage(images[i]);
+		return ret;
+	}
+	/**
+	 * Print and save list by snapshots, \see snapshot.
+	 *
+	 * Objects would keep xml image of their last version in memory.
+	 */
+	void set_snapshots(bool enable)
+	{
+		snapshots = enable;
+	}
+	bool get_snapshots() const
+	{
+		return snapshots;
+	}
+	/**
+	 * Xml of list, but give up waiting for busy objects after "msec"
+	 * milliseconds.
+	 *
+	 * Exception with "ETIMEDOUT" errno would be thrown if some objects
+	 * couldn't be printed in time.
+	 */
+	string xml_for(unsigned int msec, bool show_runtime = false,
+			const int &indent = 0, bool with_endl = false)
+							throw (Exception)
+	{
+		XDeadline deadline(msec);
+		string ret = list.xml(show_runtime, indent, with_endl);
+		if (deadline.is_fired()) {
+			Exception e("Printing of list : " + get_name() +
+					" timed out !", TracePoint("xobject"));
+			e.set_errno(ETIMEDOUT);
+			throw e;
+		}
+		return ret;
+	}
+	/**
+	 * Xml of list, without waiting on busy objects.
+	 * \see xml_for
+	 */
+	string try_xml(bool show_runtime = false,
+			const int &indent = 0, bool with_endl = false)
+							throw (Exception)
+	{
+		try {
+			return xml_for(0, show_runtime, indent, with_endl);
+		} catch (Exception &e) {
+			e.addTracePoint(TracePoint("xobject"));
+			throw e;
+		}
+	}
 	string shell_xml()
 	{
 		iterator	listIterator;
@@ -1789,6 +3097,107 @@ public:
 	{
 		return ! get_xmlDoc().empty();
 	}
+	/**
+	 * Set compression format of list document.
+	 *
+	 * Default is XCompression::AUTO, so document would be compressed
+	 * based on his name. Loading detects compression by itself.
+	 */
+	void set_compression(XCompression::Type c)
+	{
+		compression = c;
+	}
+	XCompression::Type get_compression()
+	{
+		return compression;
+	}
+	/**
+	 * Free deleted objects by "reclaimer", so deletions (and locks
+	 * held by deleters) wouldn't wait for slow readers.
+	 * Should be set before any deletion.
+	 */
+	void set_reclaimer(XReclaimer *reclaimer)
+	{
+		list.set_reclaimer(reclaimer);
+	}
+	/**
+	 * Deliver notifications of modified objects to their dependents
+	 * by "executor", so mod() wouldn't wait for them.
+	 * NULL: notify dependents synchronously in mod().
+	 * Should be set before any modification, and executor should be
+	 * flushed before destruction of list.
+	 */
+	void set_notifier(XNotifyExecutor *executor)
+	{
+		wrlock();
+		notifyExecutor = executor;
+		for (iterator iter = list.begin(); iter != list.end(); ++iter)
+			((_XObject *)*iter)->notifyExecutor = executor;
+		unlock();
+	}
+	XNotifyExecutor *get_notifier()
+	{
+		return notifyExecutor;
+	}
+	/**
+	 * Keep dependents of objects (by STRONG connections) in "index".
+	 * Should be set before any load, one index could be shared
+	 * by lists of a repository.
+	 * NULL: don't index dependents.
+	 */
+	void set_dependencyIndex(XDependencyIndex *index)
+	{
+		wrlock();
+		depIndex = index;
+		for (iterator iter = list.begin(); iter != list.end(); ++iter)
+			((_XObject *)*iter)->depIndex = index;
+		unlock();
+	}
+	XDependencyIndex *get_dependencyIndex()
+	{
+		return depIndex;
+	}
+	/**
+	 * Add loaded objects by "threads" threads.
+	 *
+	 * Objects of each priority type would be added after objects of
+	 * previous types (like of sequential addition), objects of one
+	 * type would be added concurrently after objects they depend on
+	 * (\see XObject::loadDependencies).
+	 * "1": add objects sequentially in order of list.
+	 */
+	void set_addThreads(int threads)
+	{
+		addThreads = (threads < 1) ? 1 : threads;
+	}
+	int get_addThreads() const
+	{
+		return addThreads;
+	}
+	/**
+	 * Objects that depend to object of "key" directly.
+	 * \see set_dependencyIndex
+	 */
+	std::vector<string> dependents(const string &key) throw (Exception)
+	{
+		if (! depIndex)
+			throw Exception("Dependencies aren't indexed !",
+						TracePoint("xobject"));
+		return depIndex->dependents(key);
+	}
+	/**
+	 * Objects that would break by deletion of object of "key", those
+	 * depend to him directly or indirectly.
+	 * \see set_dependencyIndex
+	 */
+	std::vector<string> dependentsClosure(const string &key)
+							throw (Exception)
+	{
+		if (! depIndex)
+			throw Exception("Dependencies aren't indexed !",
+						TracePoint("xobject"));
+		return depIndex->closure(key);
+	}
 	void set_priority(const Priority &p)
 	{
 		priority = p;
@@ -1844,7 +3253,15 @@ public:
 	bool load()
 	{
 		try {
-			if (has_xmlDoc())
+			if (has_xmlDoc() && journaled) {
+				/* Journaled list may not have been compacted
+				 * to any document yet.
+				 */
+				if ((access(get_xmlDoc().c_str(), F_OK) == 0) &&
+						!loadXmlDoc(get_xmlDoc()))
+					return false;
+				replayJournal();
+			} else if (has_xmlDoc())
 				return loadXmlDoc(get_xmlDoc());
 		} catch (Exception &e) {
 			string err = "Can't load " + get_name() + "list !:" +
@@ -1884,101 +3301,747 @@ protected:
 	 * XML formatted document to load/save list.
 	 */
 	string xmlDoc;
+	/**
+	 * Compression format of "xmlDoc".
+	 */
+	XCompression::Type compression;
 	/**
 	 * Log system of list.
 	 */
 	LogSystem logs;
 	/**
-	 * Repository containor of this list.
+	 * Repository containor of this list.
+	 */
+	XObjectRepository<Type> *repo;
+	/**
+	 * Executor of notifications of objects.
+	 */
+	XNotifyExecutor *notifyExecutor;
+	/**
+	 * Index of dependents of objects.
+	 */
+	XDependencyIndex *depIndex;
+	/**
+	 * Number of threads to add loaded objects.
+	 */
+	int addThreads;
+	/**
+	 * Journal of changes, \see set_journal.
+	 */
+	bool journaled;
+	bool journalSync;
+	off_t journalCompactSize;
+	std::atomic<XJournal *> journal;
+	/**
+	 * Is a size-triggered compaction running?
+	 */
+	std::atomic<bool> compacting;
+	/**
+	 * Thread of size-triggered compaction, guarded by "journal_lock".
+	 */
+	pthread_t compactor;
+	bool compactorStarted;
+	/**
+	 * Print and save list by snapshots?
+	 */
+	bool snapshots;
+	/**
+	 * Lock to open journal.
+	 */
+	pthread_mutex_t journal_lock;
+	/**
+	 * Offsets of journal are changed by compaction, so compactions
+	 * are serialized.
+	 */
+	pthread_mutex_t compact_lock;
+
+private:
+	/**
+	 * Should loading of objects be canceled?
+	 */
+	bool cancelLoading()
+	{
+		return repo && repo->cancelLoading();
+	}
+	/**
+	 * Prepare deletion of object.
+	 */
+	bool xdel_prepare(iterator &iter) throw(Exception)
+	{
+		bool ret;
+		pthread_mutex_lock(&dup_lock);
+		wrlock();
+		ret = list.xdel_prepare(iter);
+		if (ret) unindexType((_XObject *)*iter);
+		unlock();
+		if (ret) unindexObject((_XObject *)*iter);
+		pthread_mutex_unlock(&dup_lock);
+		return ret;
+	}
+	/**
+	 * Freeing object.
+	 * \return iterator on the next element.
+	 */
+	iterator xdel(iterator &iter)
+	{
+		iterator ret = iter;
+		++ ret;
+		list.xdel(iter);
+		return ret;
+	}
+	/**
+	 * Remove objects at "deleted" positions from list and free them.
+	 *
+	 * All of objects would be prepared in one critical section, and
+	 * freed in one batch. "deleted" would be cleared.
+	 */
+	void xdel(std::vector<iterator> &deleted)
+	{
+		typename List::erase_batch batch;
+		pthread_mutex_lock(&dup_lock);
+		wrlock();
+		for (typename std::vector<iterator>::iterator iter = 
+				deleted.begin(); iter != deleted.end(); ++iter)
+			if (list.xdel_prepare(*iter, batch)) {
+				unindexType((_XObject *)**iter);
+				unindexObject((_XObject *)**iter);
+			}
+		unlock();
+		pthread_mutex_unlock(&dup_lock);
+		/* Release the nodes before waiting on them.
+		 */
+		deleted.clear();
+		list.xdel(batch);
+	}
+	/**
+	 * Call "del" of object before removing him from list.
+	 *
+	 * Exception would be thrown if object couldn't be deleted, or
+	 * deleted with some errors.
+	 */
+	void delObject(_XObject *obj) throw (Exception)
+	{
+		try {
+			obj->del();
+		} catch (Exception &e) {
+			e.addTracePoint(TracePoint("xobject"));
+			if (e.is_failed()) {
+				string err = obj->get_key() + 
+					" couldn't be deleted: " +
+					e.what();
+				logs << LogLevel::ERROR << err;
+				throw e;
+			} else if (e.is_nok()) {
+				string err = obj->get_name() + 
+					" was deleted but some errors\
+					occured: " +
+					e.what();
+				logs << LogLevel::INFO << err;
+				throw e;
+			}
+		}
+	}
+	/**
+	 * Verify to see "new_obj" is equal to any object in list.
+	 * \param new_obj Pointer to new object would be added to list.
+	 * \param old_obj Pointer to old version of "new_obj" that is 
+	 * currently in list.
+	 * 
+	 * Keys and names are checked by indexes; structures are compared
+	 * just with objects of same structural key, if object has
+	 * structural equivalency.
+	 * Should be called under "dup_lock". If any duplication found,
+	 * Exception would arised.
+	 */
+	void verifyObjectDuplication(_XObject *new_obj, 
+					_XObject *old_obj = NULL) 
+							throw (Exception)
+	{
+		bool dup = indexed(keyIndex, new_obj->get_key(), old_obj) ||
+			indexed(nameIndex, new_obj->get_name(), old_obj);
+		string skey = new_obj->structural_key();
+		if (!dup && new_obj->has_structural_key()) {
+			std::pair<typename Index::iterator,
+				typename Index::iterator> range =
+					structIndex.equal_range(skey);
+			for (typename Index::iterator iter = range.first;
+					!dup && (iter != range.second); ++iter) {
+				_XObject *xobj = iter->second;
+				if (xobj == old_obj) continue;
+				if (xobj->chStatus(ObjStatus::QUERYING)) {
+					dup = (*xobj == *new_obj);
+					xobj->bkStatus();
+				} else if (XDeadline::timedout()) {
+					/* Waiting for "xobj" timed out, 
+					 * duplication couldn't be verified.
+					 */
+					Exception e("Can't query object : "
+						+ xobj->get_key() + " !",
+						TracePoint("xobject"));
+					e.set_errno(ETIMEDOUT);
+					throw e;
+				}
+			}
+		}
+		if (dup)
+			throw Exception("Duplicated Object !" 
+					" Object name: "
+					+ new_obj->get_name(),
+					TracePoint("xobject"));
+	}
+	/**
+	 * Add "xobj" to indexes, should be called under "dup_lock".
+	 */
+	void indexObject(_XObject *xobj)
+	{
+		keyIndex.insert(std::make_pair(xobj->get_key(), xobj));
+		nameIndex.insert(std::make_pair(xobj->get_name(), xobj));
+		if (xobj->has_structural_key())
+			structIndex.insert(std::make_pair(
+					xobj->structural_key(), xobj));
+	}
+	/**
+	 * Remove "xobj" from indexes, should be called under "dup_lock".
+	 */
+	void unindexObject(_XObject *xobj)
+	{
+		unindex(keyIndex, xobj->get_key(), xobj);
+		unindex(nameIndex, xobj->get_name(), xobj);
+		if (xobj->has_structural_key())
+			unindex(structIndex, xobj->structural_key(), xobj);
+	}
+	/**
+	 * Move "xobj" in indexes from old name/structural key to new ones,
+	 * should be called under "dup_lock".
+	 */
+	void reindexObject(_XObject *xobj, const string &oname,
+			const string &oskey, const string &nname,
+			const string &nskey)
+	{
+		if (oname != nname) {
+			unindex(nameIndex, oname, xobj);
+			nameIndex.insert(std::make_pair(nname, xobj));
+		}
+		if (xobj->has_structural_key() && (oskey != nskey)) {
+			unindex(structIndex, oskey, xobj);
+			structIndex.insert(std::make_pair(nskey, xobj));
+		}
+	}
+	/**
+	 * Is there any object except "except" with "key" in "index"?
+	 */
+	static bool indexed(Index &index, const string &key,
+						_XObject *except)
+	{
+		std::pair<typename Index::iterator, typename Index::iterator>
+					range = index.equal_range(key);
+		for (typename Index::iterator iter = range.first;
+					iter != range.second; ++iter)
+			if (iter->second != except) return true;
+		return false;
+	}
+	static void unindex(Index &index, const string &key, _XObject *xobj)
+	{
+		std::pair<typename Index::iterator, typename Index::iterator>
+					range = index.equal_range(key);
+		for (typename Index::iterator iter = range.first;
+					iter != range.second; ++iter)
+			if (iter->second == xobj) {
+				index.erase(iter);
+				return;
+			}
+	}
+	/**
+	 * Index all of objects again, after loading objects from xml.
+	 */
+	void rebuildIndexes()
+	{
+		pthread_mutex_lock(&dup_lock);
+		keyIndex.clear();
+		nameIndex.clear();
+		structIndex.clear();
+		for (iterator iter = list.begin(); iter != list.end(); ++iter)
+			indexObject((_XObject *)*iter);
+		pthread_mutex_unlock(&dup_lock);
+	}
+	/**
+	 * Object at "iter" entered the list (loaded), index his type and
+	 * give him notifier, logs and dependency index of list; his connections
+	 * may be made before his addition. Should be called under write
+	 * lock of list.
+	 */
+	void enterList(iterator &iter)
+	{
+		_XObject *xobj = (_XObject *)*iter;
+		xobj->notifyExecutor = notifyExecutor;
+		xobj->listLogs = &logs;
+		xobj->depIndex = depIndex;
+		indexType(iter);
+	}
+	/**
+	 * Add object at "iter" to end of his type index, should be called
+	 * under write lock of list.
+	 */
+	void indexType(iterator &iter)
+	{
+		_XObject *xobj = (_XObject *)*iter;
+		TypeLiteral type = xobj->get_type();
+		TypeIndex &index = typeIndex[type];
+		typePos[xobj] = TypePos(type, index.insert(index.end(), iter));
+	}
+	/**
+	 * Remove "xobj" from his type index, should be called under write
+	 * lock of list.
+	 */
+	void unindexType(_XObject *xobj)
+	{
+		typename TypePositions::iterator pos = typePos.find(xobj);
+		if (pos == typePos.end()) return;
+		typeIndex[pos->second.first].erase(pos->second.second);
+		typePos.erase(pos);
+	}
+	/**
+	 * Index types of all objects again, after loading objects from
+	 * xml. Should be called under write lock of list.
+	 */
+	void rebuildTypeIndex()
+	{
+		typePos.clear();
+		typeIndex.clear();
+		for (iterator iter = list.begin(); iter != list.end(); ++iter)
+			enterList(iter);
+	}
+	bool addAllLoadedObjects()
+	{
+		bool isOK = true;
+		if (addThreads > 1) {
+			std::vector<iterator> objects;
+			rdlock();
+			for (iterator iter = list.begin();
+					iter != list.end(); ++iter)
+				objects.push_back(iter);
+			unlock();
+			return addObjectsParallel(objects);
+		}
+		for (iterator iter = list.begin();
+					iter != list.end(); ++iter) {
+			if (cancelLoading()) return false;
+			try {
+				_add(iter);
+			} catch (Exception &e) {
+				/* error has been loged, so discards him.
+				 */
+				if (e.is_failed()) isOK = false;
+			}
+		}
+		return isOK;
+	}
+	bool addLoadedObjectsType(TypeLiteral _type) 
+	{
+		bool isOK = true;
+		std::vector<iterator> objects;
+		query_type_lock(_type, objects);
+		if (addThreads > 1) return addObjectsParallel(objects);
+		for (typename std::vector<iterator>::iterator iter =
+				objects.begin(); iter != objects.end(); ++iter) {
+			if (cancelLoading()) return false;
+			try {
+				_add(*iter);
+			} catch (Exception &e) {
+				if (e.is_failed()) isOK = false;
+			}
+		}
+		return isOK;
+	}
+	/**
+	 * \class ParallelAdd
+	 * Addition of objects by a pool of threads, in order of their
+	 * dependencies.
+	 *
+	 * Each object would be ready when objects he depends on have been
+	 * added (failed or not), ready objects are added concurrently.
+	 * Objects in dependency loops would be added sequentially at the
+	 * end.
+	 */
+	class ParallelAdd
+	{
+	public:
+		ParallelAdd(_XObjectList *_xolist,
+				std::vector<iterator> &_objects) :
+			xolist(_xolist), objects(_objects),
+			dependents(_objects.size()), waits(_objects.size(), 0),
+			added(_objects.size(), false), running(0),
+			isOK(true), canceled(false)
+		{
+			pthread_mutex_init(&lock, NULL);
+			pthread_cond_init(&cond, NULL);
+			/* Dependencies out of "objects" have been added
+			 * before, or would be added later by priority.
+			 */
+			std::unordered_map<string, size_t> pos;
+			for (size_t i = 0; i < objects.size(); ++i)
+				pos[(*objects[i])->get_key()] = i;
+			std::vector<string> keys;
+			for (size_t i = 0; i < objects.size(); ++i) {
+				keys.clear();
+				((_XObject *)*objects[i])->
+						loadDependencies(keys);
+				for (size_t k = 0; k < keys.size(); ++k) {
+					typename std::unordered_map<string,
+						size_t>::iterator p =
+						pos.find(keys[k]);
+					if ((p == pos.end()) || (p->second == i))
+						continue;
+					dependents[p->second].push_back(i);
+					++ waits[i];
+				}
+			}
+			for (size_t i = 0; i < objects.size(); ++i)
+				if (! waits[i]) ready.push_back(i);
+		}
+		~ParallelAdd()
+		{
+			pthread_cond_destroy(&cond);
+			pthread_mutex_destroy(&lock);
+		}
+		/**
+		 * \return true: All objects added, false: some objects
+		 * 	couldn't be added or loading canceled.
+		 */
+		bool run(int threads)
+		{
+			std::vector<pthread_t> workers(threads);
+			int started = 0;
+			for (int i = 0; i < threads; ++i)
+				if (pthread_create(&workers[started], NULL,
+							work, this) == 0)
+					++ started;
+			/* No worker could be started, so caller adds
+			 * objects himself.
+			 */
+			if (! started) work(this);
+			for (int i = 0; i < started; ++i)
+				pthread_join(workers[i], NULL);
+			if (canceled) return false;
+			/* Remaining objects are in loops.
+			 */
+			for (size_t i = 0; i < objects.size(); ++i) {
+				if (added[i]) continue;
+				if (xolist->cancelLoading()) return false;
+				add(i);
+			}
+			return isOK;
+		}
+
+	private:
+		static void *work(void *arg)
+		{
+			ParallelAdd *job = (ParallelAdd *)arg;
+			pthread_mutex_lock(&job->lock);
+			while (1) {
+				while (job->ready.empty() && job->running &&
+							!job->canceled)
+					pthread_cond_wait(&job->cond,
+								&job->lock);
+				/* Nothing is running nor ready: done.
+				 */
+				if (job->canceled || job->ready.empty())
+					break;
+				size_t i = job->ready.front();
+				job->ready.pop_front();
+				++ job->running;
+				pthread_mutex_unlock(&job->lock);
+
+				bool cancel = job->xolist->cancelLoading();
+				if (! cancel) job->add(i);
+
+				pthread_mutex_lock(&job->lock);
+				-- job->running;
+				if (cancel) job->canceled = true;
+				else
+					for (size_t d = 0; 
+						d < job->dependents[i].size();
+									++d)
+						if (! -- job->waits[
+							job->dependents[i][d]])
+							job->ready.push_back(
+							job->dependents[i][d]);
+				pthread_cond_broadcast(&job->cond);
+			}
+			pthread_mutex_unlock(&job->lock);
+			return NULL;
+		}
+		void add(size_t i)
+		{
+			try {
+				xolist->_add(objects[i]);
+			} catch (Exception &e) {
+				/* error has been loged, so discards him.
+				 */
+				if (e.is_failed()) isOK = false;
+			}
+			added[i] = true;
+		}
+
+		_XObjectList *xolist;
+		std::vector<iterator> &objects;
+		/**
+		 * Objects that depend on each object.
+		 */
+		std::vector<std::vector<size_t> > dependents;
+		/**
+		 * Number of objects that each object waits for them.
+		 */
+		std::vector<unsigned> waits;
+		std::vector<char> added;
+		std::deque<size_t> ready;
+		int running;
+		std::atomic<bool> isOK;
+		bool canceled;
+		pthread_mutex_t lock;
+		pthread_cond_t cond;
+	};
+	bool addObjectsParallel(std::vector<iterator> &objects)
+	{
+		if (cancelLoading()) return false;
+		ParallelAdd job(this, objects);
+		return job.run(addThreads);
+	}
+	/**
+	 * Positions of stale images in collected images, and their
+	 * objects.
+	 */
+	typedef std::vector<std::pair<size_t, iterator> > StaleImages;
+	/**
+	 * Regenerate images of changed objects.
+	 */
+	void refreshImages(bool show_runtime, const int &indent,
+							const string &endl)
+	{
+		for (iterator iter = list.begin(); iter != list.end(); ++iter)
+			static_cast<_XObject *>(*iter)->xmlImage(show_runtime,
+							indent, endl);
+	}
+	/**
+	 * Append images of objects to "images", caller should hold
+	 * read lock of list.
+	 *
+	 * Objects aren't printed here, objects with stale images are
+	 * added to "stale" with NULL images.
+	 */
+	void collectImages(XObjectSnapshot::Images &images, 
+			StaleImages &stale, bool show_runtime,
+			const int &indent, const string &endl)
+	{
+		for (iterator iter = list.begin(); iter != list.end(); ++iter) {
+			images.push_back(static_cast<_XObject *>(*iter)->
+				xmlImage(show_runtime, indent, endl, false));
+			if (! images.back())
+				stale.push_back(std::make_pair(
+						images.size() - 1, iter));
+		}
+	}
+	/**
+	 * Print objects of stale images, out of lock of list.
+	 */
+	static void fillImages(XObjectSnapshot::Images &images, 
+			StaleImages &stale, bool show_runtime,
+			const int &indent, const string &endl)
+	{
+		for (size_t i = 0; i < stale.size(); ++i)
+			images[stale[i].first] = static_cast<_XObject *>(
+					*stale[i].second)->xmlImage(
+					show_runtime, indent, endl);
+		stale.clear();
+	}
+	/**
+	 * Open journal of list, if list is journaled.
+	 * \return NULL: list isn't journaled.
+	 */
+	XJournal *openJournal() throw (Exception)
+	{
+		XJournal *ret = journal.load();
+		if (ret) return ret;
+		pthread_mutex_lock(&journal_lock);
+		try {
+			if (journaled && !journal.load() && has_xmlDoc())
+				journal.store(new XJournal(get_xmlDoc() +
+						".journal", journalSync));
+		} catch (Exception &e) {
+			pthread_mutex_unlock(&journal_lock);
+			e.addTracePoint(TracePoint("xobject"));
+			throw e;
+		}
+		ret = journal.load();
+		pthread_mutex_unlock(&journal_lock);
+		return ret;
+	}
+	/**
+	 * Append change of object at "iter" to the journal.
+	 *
+	 * Change has been done, so failures would just be logged.
 	 */
-	XObjectRepository<Type> *repo;
-
-private:
+	void journalObject(XJournal::Op op, iterator &iter)
+	{
+		if (! journaled) return;
+		try {
+			XJournal *j = openJournal();
+			if (! j) return;
+			_XObject *obj = static_cast<_XObject *>(*iter);
+			if (op == XJournal::DEL)
+				j->append(op, obj->get_key(), string());
+			else {
+				/* Object is printed and his record appended
+				 * in PRINTING status, so later modifications
+				 * (exclusive statuses) of him would append
+				 * their records after this record.
+				 */
+				if (! obj->chStatus(ObjStatus::PRINTING))
+					throw Exception("Can't print " + 
+						obj->get_key() + " !",
+						TracePoint("xobject"));
+				try {
+					j->append(op, obj->get_key(),
+						obj->xobj_xml(false, 0, ""));
+				} catch (Exception &e) {
+					obj->bkStatus();
+					throw e;
+				}
+				obj->bkStatus();
+			}
+			if (journalCompactSize && 
+					(j->size() > journalCompactSize))
+				startCompactor();
+		} catch (Exception &e) {
+			string err = "Can't journal changes of " + get_name() +
+					" list !: " + e.what();
+			logs << LogLevel::ERROR << err;
+		}
+	}
 	/**
-	 * Prepare deletion of object.
+	 * Compact journal in background, if there isn't any running
+	 * compaction.
+	 *
+	 * Compaction prints all objects, so he isn't done by the thread
+	 * of change (it may hold other objects in exclusive statuses).
 	 */
-	bool xdel_prepare(iterator &iter) throw(Exception)
+	void startCompactor()
 	{
-		bool ret;
-		wrlock();
-		ret = list.xdel_prepare(iter);
-		unlock();
-		return ret;
+		if (compacting.exchange(true)) return;
+		pthread_mutex_lock(&journal_lock);
+		if (compactorStarted) {
+			/* Previous compactor has finished his work. */
+			pthread_join(compactor, NULL);
+			compactorStarted = false;
+		}
+		int ret = pthread_create(&compactor, NULL, runCompactor, this);
+		if (ret == 0) compactorStarted = true;
+		pthread_mutex_unlock(&journal_lock);
+		if (ret != 0) {
+			compacting = false;
+			string err = "Can't start compaction of " + get_name()
+					+ " list !: " + strerror(ret);
+			logs << LogLevel::ERROR << err;
+		}
+	}
+	static void *runCompactor(void *arg)
+	{
+		_XObjectList *xolist = static_cast<_XObjectList *>(arg);
+		try {
+			xolist->compact();
+		} catch (Exception &e) {
+			string err = "Can't compact journal of " + 
+				xolist->get_name() + " list !: " + e.what();
+			xolist->logs << LogLevel::ERROR << err;
+		}
+		xolist->compacting = false;
+		return NULL;
 	}
 	/**
-	 * Freeing object.
-	 * \return iterator on the next element.
+	 * Wait for background compaction.
 	 */
-	iterator xdel(iterator &iter)
+	void joinCompactor()
 	{
-		iterator ret = iter;
-		++ ret;
-		list.xdel(iter);
-		return ret;
+		pthread_mutex_lock(&journal_lock);
+		if (compactorStarted) {
+			pthread_join(compactor, NULL);
+			compactorStarted = false;
+		}
+		pthread_mutex_unlock(&journal_lock);
 	}
 	/**
-	 * Verify to see "new_obj" is equal to any object in list.
-	 * \param new_obj Pointer to new object would be added to list.
-	 * \param old_obj Pointer to old version of "new_obj" that is 
-	 * currently in list.
-	 * 
-	 * If any duplication found, Exception would arised.
+	 * \class JournalReplayer
+	 * Applies journal records to loaded objects of list.
 	 */
-	void verifyObjectDuplication(_XObject *new_obj, 
-					_XObject *old_obj = NULL) 
-							throw (Exception)
+	class JournalReplayer : public XJournal::Replayer
 	{
-		for (iterator iter = list.begin();
-					iter != list.end(); ++iter) {
-			_XObject *xobj = (_XObject *) *iter;
-			if (xobj == old_obj) continue;
-			if (xobj->chStatus(ObjStatus::QUERYING)) {
-				if ((*xobj == *new_obj) || 
-					(xobj->get_key() == 
-							new_obj->get_key()) ||
-					(xobj->get_name() == 
-							new_obj->get_name())) {
-					xobj->bkStatus();
-					throw Exception("Duplicated Object !" 
-							" Object name: "
-							+ new_obj->get_name(),
-							TracePoint("xobject"));
-				}
-				xobj->bkStatus();
-			}
+	public:
+		JournalReplayer(_XObjectList *_xolist) : xolist(_xolist)
+		{ }
+		void replay(XJournal::Op op, const string &key,
+							const string &data)
+		{
+			xolist->replayRecord(op, key, data);
 		}
-	}
-	bool addAllLoadedObjects()
+	private:
+		_XObjectList *xolist;
+	};
+	/**
+	 * Replay journal on loaded objects.
+	 * \return number of replayed records.
+	 */
+	size_t replayJournal() throw (Exception)
 	{
-		bool isOK = true;
-		for (iterator iter = list.begin();
-					iter != list.end(); ++iter) {
-			if (repo->cancelLoading()) return false;
-			try {
-				_add(iter);
-			} catch (Exception &e) {
-				/* error has been loged, so discards him.
-				 */
-				if (e.is_failed()) isOK = false;
-			}
+		try {
+			XJournal *j = openJournal();
+			if (! j) return 0;
+			JournalReplayer replayer(this);
+			return j->replay(replayer);
+		} catch (Exception &e) {
+			e.addTracePoint(TracePoint("xobject"));
+			throw e;
 		}
-		return isOK;
 	}
-	bool addLoadedObjectsType(TypeLiteral _type) 
+	/**
+	 * Apply one journal record, any old version of object would be
+	 * replaced by record.
+	 */
+	void replayRecord(XJournal::Op op, const string &key,
+							const string &data)
 	{
-		bool isOK = true;
-		for (iterator iter = list.begin();
-					iter != list.end(); ++iter) {
-			_XObject *xobj = (_XObject *)*iter;
-			if (repo->cancelLoading()) return false;
-			if (xobj->get_type() != _type) continue;
-			try {
-				_add(iter);
-			} catch (Exception &e) {
-				if (e.is_failed()) isOK = false;
-			}
+		try {
+			unloadObj(key);
+			if (op == XJournal::DEL) return;
+			List staging(get_name());
+			staging.loadXmlStr("<" + get_name() + ">" + data + 
+						"</" + get_name() + ">");
+			for (iterator iter = staging.begin();
+					iter != staging.end(); ++iter)
+				loadObj(static_cast<_XObject *>(*iter));
+		} catch (Exception &e) {
+			string err = "Can't replay journal record of " + key +
+					" in " + get_name() + " list !: " +
+					e.what();
+			logs << LogLevel::ERROR << err;
 		}
-		return isOK;
+	}
+	/**
+	 * Remove loaded (not added) object of "key" from list.
+	 */
+	void unloadObj(const string &key)
+	{
+		rdlock();
+		iterator iter = list.find(key);
+		unlock();
+		if (iter == end()) return;
+		_XObject *obj = static_cast<_XObject *>(*iter);
+		pthread_mutex_lock(&dup_lock);
+		unindexObject(obj);
+		pthread_mutex_unlock(&dup_lock);
+		wrlock();
+		unindexType(obj);
+		unlock();
+		list.del(iter);
 	}
 	void _add(iterator &iter) throw (Exception)
 	{
@@ -2011,6 +4074,19 @@ private:
 	 * process at a time.
 	 */
 	pthread_mutex_t dup_lock;
+	/**
+	 * Hash indexes of objects by key, name and structural key, to
+	 * verify duplications. They are protected by "dup_lock".
+	 */
+	Index keyIndex;
+	Index nameIndex;
+	Index structIndex;
+	/**
+	 * Objects of each type in order of list, and position of each
+	 * object in his type index. They are protected by "list_lock".
+	 */
+	TypeIndexes typeIndex;
+	TypePositions typePos;
 };
 
 /**
@@ -2216,6 +4292,126 @@ public:
 		unlock();
 		return objiter;
 	}
+	/**
+	 * Add object to specified list, but give up waits on objects
+	 * statuses after "msec" milliseconds.
+	 * \see XObjectList::add_for
+	 */
+	iterator add_for(ListID listID, _XObject *xo, unsigned int msec,
+			bool clone = true) throw (Exception)
+	{
+		iterator objiter;
+		rdlock();
+		try {
+			list_iterator iter = findList(listID);
+			objiter = iter->second->add_for(xo, msec, clone);
+		} catch (Exception &e) {
+			unlock();
+			e.addTracePoint(TracePoint("xobject"));
+			throw e;
+		}
+		unlock();
+		return objiter;
+	}
+	/**
+	 * Add object to specified list, without waiting on busy objects.
+	 */
+	iterator try_add(ListID listID, _XObject *xo, bool clone = true)
+							throw (Exception)
+	{
+		iterator objiter;
+		rdlock();
+		try {
+			list_iterator iter = findList(listID);
+			objiter = iter->second->try_add(xo, clone);
+		} catch (Exception &e) {
+			unlock();
+			e.addTracePoint(TracePoint("xobject"));
+			throw e;
+		}
+		unlock();
+		return objiter;
+	}
+	/**
+	 * Delete object from specified list, but give up waiting for
+	 * object after "msec" milliseconds.
+	 * \see XObjectList::del_for
+	 */
+	iterator del_for(ListID listID, const string &key, unsigned int msec)
+							throw (Exception)
+	{
+		iterator objiter;
+		rdlock();
+		try {
+			list_iterator iter = findList(listID);
+			objiter = iter->second->del_for(key, msec);
+		} catch (Exception &e) {
+			unlock();
+			e.addTracePoint(TracePoint("xobject"));
+			throw e;
+		}
+		unlock();
+		return objiter;
+	}
+	/**
+	 * Delete object from specified list, without waiting on busy
+	 * object.
+	 */
+	iterator try_del(ListID listID, const string &key) throw (Exception)
+	{
+		iterator objiter;
+		rdlock();
+		try {
+			list_iterator iter = findList(listID);
+			objiter = iter->second->try_del(key);
+		} catch (Exception &e) {
+			unlock();
+			e.addTracePoint(TracePoint("xobject"));
+			throw e;
+		}
+		unlock();
+		return objiter;
+	}
+	/**
+	 * Modify object in specified list, but give up waits on objects
+	 * statuses after "msec" milliseconds.
+	 * \see XObjectList::mod_for
+	 */
+	iterator mod_for(ListID listID, _XObject *xo, unsigned int msec)
+							throw (Exception)
+	{
+		iterator objiter;
+		rdlock();
+		try {
+			list_iterator iter = findList(listID);
+			objiter = iter->second->mod_for(xo, msec);
+		} catch (Exception &e) {
+			unlock();
+			e.addTracePoint(TracePoint("xobject"));
+			throw e;
+		}
+		unlock();
+		return objiter;
+	}
+	/**
+	 * Modify object in specified list, without waiting on busy
+	 * objects.
+	 */
+	iterator try_mod(ListID listID, _XObject *xo) throw (Exception)
+	{
+		iterator objiter;
+		rdlock();
+		try {
+			list_iterator iter = findList(listID);
+			objiter = iter->second->try_mod(xo);
+		} catch (Exception &e) {
+			unlock();
+			e.addTracePoint(TracePoint("xobject"));
+			throw e;
+		}
+		unlock();
+		return objiter;
+	}
 	bool loadXmlStr(ListID listID, const string &xstr,
 			XParam::XmlParser *parser = NULL) 
 					throw (Exception)
@@ -2335,6 +4531,50 @@ public:
 		unlock();
 		return str;
 	}
+	/**
+	 * Point-in-time image of all lists.
+	 *
+	 * Images of all lists are collected while all of them are read
+	 * locked, so membership of objects in lists is consistent.
+	 * \see XObjectList::snapshot
+	 */
+	XObjectSnapshot snapshot(bool show_runtime = false,
+			const int &indent = 0, bool with_endl = false)
+	{
+		string endl = (with_endl) ? "\n" : "";
+		int oindent = (indent) ? indent + 4 : indent;
+		XObjectSnapshot ret(name);
+		rdlock();
+		std::vector<XObjectSnapshot::Images> images(repo.size());
+		std::vector<typename _XObjectList::StaleImages> 
+						stale(repo.size());
+		list_iterator iter;
+		for (iter = repo.begin(); iter != repo.end(); ++iter)
+			iter->second->refreshImages(show_runtime, oindent, 
+									endl);
+		/* Lists are locked in order of their IDs. */
+		size_t i = 0;
+		for (iter = repo.begin(); iter != repo.end(); ++iter, ++i) {
+			iter->second->rdlock();
+			iter->second->collectImages(images[i], stale[i],
+					show_runtime, oindent, endl);
+		}
+		for (iter = repo.begin(); iter != repo.end(); ++iter)
+			iter->second->unlock();
+		i = 0;
+		for (iter = repo.begin(); iter != repo.end(); ++iter, ++i) {
+			_XObjectList::fillImages(images[i], stale[i],
+					show_runtime, oindent, endl);
+			XObjectSnapshot list(iter->second->list.get_pname(),
+					iter->second->list.get_version(),
+					indent, endl);
+			for (size_t j = 0; j < images[i].size(); ++j)
+				list.addImage(images[i][j]);
+			ret.addSnapshot(list);
+		}
+		unlock();
+		return ret;
+	}
 	string shell_xml()
 	{
 		rdlock();
@@ -2368,6 +4608,28 @@ public:
 		}
 		unlock();
 	}
+	/**
+	 * Save all lists by background writer.
+	 *
+	 * Lists would be serialized in caller thread and written by "saver",
+	 * use "XDocSaver::flush()" to wait for writes.
+	 */
+	void saveAsync(XDocSaver *saver = NULL)
+	{
+		rdlock();
+		for (list_iterator iter = repo.begin(); 
+					iter != repo.end(); ++iter) {
+			try {
+				iter->second->saveAsync(saver);
+			} catch (Exception &e) {
+				string error = "can't save " + 
+					iter->second->get_name() + ": " +
+					e.what();
+				logs << LogLevel::ERROR << error;
+			}
+		}
+		unlock();
+	}
 	void save(ListID listID) throw (Exception)
 	{
 		rdlock();
@@ -2385,15 +4647,32 @@ public:
 	 * Loading object repository.
 	 *
 	 * This function would first load all objects and then add them.
-	 * Loading/Adding from smallest listID to biggest.
+	 * Documents of lists are parsed concurrently (each list by his own
+	 * thread and parser), adding is from smallest listID to biggest.
 	 */
 	bool load()
 	{
 		bool isOK = true;
 		rdlock();
+		/* libxml should be initialized before concurrent parsers.
+		 */
+		xmlInitParser();
+		std::vector<ListLoad> loads;
 		for (list_iterator iter = repo.begin(); 
 					iter != repo.end(); ++iter)
-			isOK = iter->second->load() && isOK;
+			loads.push_back(ListLoad(iter->second));
+		for (size_t i = 0; i < loads.size(); ++i)
+			loads[i].started = (pthread_create(&loads[i].thread,
+					NULL, loadList, &loads[i]) == 0);
+		for (size_t i = 0; i < loads.size(); ++i) {
+			if (loads[i].started)
+				pthread_join(loads[i].thread, NULL);
+			else
+				/* Load him by this thread.
+				 */
+				loadList(&loads[i]);
+			isOK = loads[i].isOK && isOK;
+		}
 		for (list_iterator iter = repo.begin(); 
 					iter != repo.end(); ++iter)
 			isOK = iter->second->addLoadedObjects() && isOK;
@@ -2671,6 +4950,30 @@ public:
 	{
 		_cancelLoading = n_cancelLoading;
 	}
+	/**
+	 * Add loaded objects of registered lists by "threads" threads.
+	 * \see XObjectList::set_addThreads
+	 */
+	void set_addThreads(int threads)
+	{
+		rdlock();
+		for (list_iterator iter = repo.begin(); 
+					iter != repo.end(); ++iter)
+			iter->second->set_addThreads(threads);
+		unlock();
+	}
+	/**
+	 * Print and save registered lists by snapshots.
+	 * \see XObjectList::set_snapshots
+	 */
+	void set_snapshots(bool enable)
+	{
+		rdlock();
+		for (list_iterator iter = repo.begin(); 
+					iter != repo.end(); ++iter)
+			iter->second->set_snapshots(enable);
+		unlock();
+	}
 
 protected:
 	/**
@@ -2685,6 +4988,25 @@ protected:
 		}
 		return iter;
 	}
+	/**
+	 * Loading of one list by a thread.
+	 */
+	struct ListLoad
+	{
+		ListLoad(_XObjectList *_xolist) : xolist(_xolist),
+			isOK(false), started(false)
+		{ }
+		_XObjectList *xolist;
+		pthread_t thread;
+		bool isOK;
+		bool started;
+	};
+	static void *loadList(void *arg)
+	{
+		ListLoad *load = (ListLoad *)arg;
+		load->isOK = load->xolist->load();
+		return NULL;
+	}
 
 	/**
 	 * Name of object repository.
@@ -45,8 +45,18 @@ using std::map;
 #include <algorithm>
 using std::find;
 
+#include <stdlib.h>
+#include <ctype.h>
+#include <errno.h>
+#include <sstream>
+#include <iterator>
+
 #include "xdbengine.hpp"
 #include "xlist.hpp"
+#include "xepochlist.hpp"
+#include "xchunklist.hpp"
+#include "xfile.hpp"
+#include "xsaver.hpp"
 
 namespace pparam
 {
@@ -170,14 +180,84 @@ public:
 						throw (Exception);
 	/**
 	 * Save the xml output of xparam in the specified file.
+	 *
+	 * Document would be written to a temporary file and renamed over
+	 * "xdoc", so a crash in middle of save doesn't lose old document.
+	 * xml output would be streamed to the file (and compressor), so
+	 * there isn't any full in-memory copy of document.
+	 * \param compression format of document, \see XCompression.
 	 */
 	void saveXmlDoc(string xdoc,
 			bool show_runtime = false, const int &indent = 0,
-			bool with_endl = false) throw (Exception);
+			bool with_endl = false,
+			XCompression::Type compression = XCompression::AUTO)
+						throw (Exception);
+	/**
+	 * Save the xml output of xparam in the specified file by background
+	 * writer.
+	 *
+	 * xml output would be generated in caller thread, writing of him
+	 * would be done by "saver".
+	 * \param saver writer of document, NULL: XDocSaver::global().
+	 * \param done callback would be called at the end of write.
+	 * \param compression format of document, \see XCompression.
+	 * \return completion of save, "get()" rethrows write errors.
+	 */
+	XDocSaver::Result saveXmlDocAsync(string xdoc,
+			bool show_runtime = false, const int &indent = 0,
+			bool with_endl = false, XDocSaver *saver = NULL,
+			XDocSaver::FT_saveDone done = NULL, void *arg = NULL,
+			XCompression::Type compression = XCompression::AUTO)
+						throw (Exception);
 	/**
 	 * return parameter value.
 	 */
 	virtual string value() const = 0;
+	/**
+	 * Is parameter value equal to "str"?
+	 *
+	 * Same as "value() == str", inherited classes would override him
+	 * to compare without building value string.
+	 */
+	virtual bool value_equals(const string &str) const
+	{
+		return value() == str;
+	}
+	/**
+	 * \typedef FT_childVisitor
+	 * Type for visitors of child parameters.
+	 * \return false: stop visiting.
+	 */
+	typedef bool (*FT_childVisitor)(XParam *child, void *arg);
+	/**
+	 * Find child parameter by his name.
+	 * \param hint position of child in the previous lookup, would be
+	 * 	examined first and updated by position of found child.
+	 * \return NULL if there isn't any.
+	 */
+	virtual XParam *findChild(const string &name, size_t &hint) const
+	{
+		return NULL;
+	}
+	/**
+	 * Find child parameter by string form of his key.
+	 * \param child found child or NULL.
+	 * \return false if parameter doesn't have any search map, so
+	 * 	"child" hasn't been set.
+	 * \see XSetParam::enable_smap
+	 */
+	virtual bool findChildByKey(const string &_key, XParam *&child) const
+	{
+		return false;
+	}
+	/**
+	 * Call "visit" for child parameters in order.
+	 * \return false: visitor stopped the visit.
+	 */
+	virtual bool visitChildren(FT_childVisitor visit, void *arg) const
+	{
+		return true;
+	}
 	/**
 	 * Default key operator.
 	 * \see XSetParam
@@ -206,6 +286,18 @@ public:
 	 */
 	virtual string _xml(bool show_runtime,
 			const int &indent, const string &endl) const = 0;
+	/**
+	 * Write out parameter value in xml format to "os".
+	 *
+	 * Output is same as _xml(...), but set parameters would write
+	 * their children one by one, without building whole string.
+	 * Default writes output of _xml(...).
+	 */
+	virtual void xmlStream(std::ostream &os, bool show_runtime,
+			const int &indent, const string &endl) const
+	{
+		os << _xml(show_runtime, indent, endl);
+	}
 	/**
 	 * Verifies parameter value.
 	 *
@@ -229,7 +321,7 @@ public:
 	void set_runtime(bool rt = true) { runtime = rt; }
 	/** Returns parametr name.
 	 */
-	string get_pname() const { return pname; }
+	const string &get_pname() const { return pname; }
 	/** Returns parameter version.
 	 */
 	string get_version() const { return version; }
@@ -289,6 +381,113 @@ protected:
 	bool runtime;
 };
 
+/**
+ * Convert string form of a key to the key value.
+ * \return false if "str" isn't a valid key.
+ *
+ * Integer and float keys would be converted (in decimal) without any
+ * allocation.
+ */
+template<typename Key>
+inline bool xkeyFromString(const string &str, Key &_key)
+{
+	std::istringstream iss(str);
+	iss >> _key;
+	return !iss.fail() && iss.eof();
+}
+/**
+ * Can "str" be a number key? strto* functions skip leading white spaces.
+ */
+inline bool _xkeyNumeric(const string &str)
+{
+	return !str.empty() && !isspace((unsigned char)str[0]);
+}
+inline bool xkeyFromString(const string &str, long long &_key)
+{
+	if (!_xkeyNumeric(str)) return false;
+	char *end;
+	errno = 0;
+	_key = strtoll(str.c_str(), &end, 10);
+	return (*end == '\0') && (errno != ERANGE);
+}
+inline bool xkeyFromString(const string &str, unsigned long long &_key)
+{
+	if (!_xkeyNumeric(str) || (str[0] == '-')) return false;
+	char *end;
+	errno = 0;
+	_key = strtoull(str.c_str(), &end, 10);
+	return (*end == '\0') && (errno != ERANGE);
+}
+inline bool xkeyFromString(const string &str, double &_key)
+{
+	if (!_xkeyNumeric(str)) return false;
+	char *end;
+	errno = 0;
+	_key = strtod(str.c_str(), &end);
+	return (*end == '\0') && (errno != ERANGE);
+}
+/**
+ * Narrowing of integer/float keys with range check.
+ */
+template<typename Key, typename Wide>
+inline bool _xkeyNarrow(const string &str, Key &_key)
+{
+	Wide w;
+	if (!xkeyFromString(str, w)) return false;
+	_key = (Key)w;
+	return (Wide)_key == w;
+}
+inline bool xkeyFromString(const string &str, int &_key)
+{
+	return _xkeyNarrow<int, long long>(str, _key);
+}
+inline bool xkeyFromString(const string &str, long &_key)
+{
+	return _xkeyNarrow<long, long long>(str, _key);
+}
+inline bool xkeyFromString(const string &str, short &_key)
+{
+	return _xkeyNarrow<short, long long>(str, _key);
+}
+inline bool xkeyFromString(const string &str, unsigned int &_key)
+{
+	return _xkeyNarrow<unsigned int, unsigned long long>(str, _key);
+}
+inline bool xkeyFromString(const string &str, unsigned long &_key)
+{
+	return _xkeyNarrow<unsigned long, unsigned long long>(str, _key);
+}
+inline bool xkeyFromString(const string &str, unsigned short &_key)
+{
+	return _xkeyNarrow<unsigned short, unsigned long long>(str, _key);
+}
+inline bool xkeyFromString(const string &str, float &_key)
+{
+	double d;
+	if (!xkeyFromString(str, d)) return false;
+	_key = d;
+	return true;
+}
+/**
+ * Find string form of a key in a search map.
+ *
+ * String keys would be searched directly, others after conversion.
+ */
+template<typename Map>
+inline typename Map::const_iterator xsmapFind(const Map &smap,
+					const string &skey, const string *)
+{
+	return smap.find(skey);
+}
+template<typename Map, typename Key>
+inline typename Map::const_iterator xsmapFind(const Map &smap,
+					const string &skey, const Key *)
+{
+	Key _key;
+	if (!xkeyFromString(skey, _key)) return smap.end();
+	return smap.find(_key);
+}
+
 /**
  * \class XSingleField
  * defines parameter with single value.
@@ -341,14 +540,27 @@ public:
 	virtual bool operator != (const XParam &) throw (Exception);
 	virtual string _xml(bool show_runtime,
 				const int &indent, const string &endl) const;
+	virtual void xmlStream(std::ostream &os, bool show_runtime,
+			const int &indent, const string &endl) const;
+	/**
+	 * Would xmlStream(...) write children one by one?
+	 *
+	 * Default is false and xmlStream(...) writes output of _xml(...),
+	 * so classes that develope _xml(...) are saved by their own output.
+	 */
+	virtual bool stream_children() const { return false; }
 	virtual string value() const { return ""; }
 	virtual XParam *value(int index) const;
 	virtual XParam *value(string name) const;
+	virtual XParam *findChild(const string &name, size_t &hint) const;
+	virtual bool visitChildren(XParam::FT_childVisitor visit, 
+						void *arg) const;
 	virtual bool verify() throw (Exception);
 	/** Add one sub-parameter to list of sub-parameters. */
 	virtual void addParam(XParam *param) { params.push_back(param); }
 
 	XUInt size() const { return params.size(); }
+	bool empty() const { return params.empty(); }
 	iterator begin() { return params.begin(); }
 	iterator end() { return params.end(); }
 	const_iterator begin() const { return params.begin(); }
@@ -416,6 +628,17 @@ public:
 	virtual ~_XMixParam() {}
 
 protected:
+	/**
+	 * findChild for random access lists, "hint" would be an index.
+	 */
+	XParam *_findChild(const string &name, size_t &hint,
+				std::random_access_iterator_tag) const;
+	/**
+	 * findChild for other lists, "hint" would be just updated.
+	 */
+	XParam *_findChild(const string &name, size_t &hint,
+				std::input_iterator_tag) const;
+
 	/**
 	 * list of sub-element(parameters) of the mixture parameter.
 	 */
@@ -455,6 +678,10 @@ public:
 	virtual XParam &operator = (const XParam &xp)
 						throw (Exception);
 	string value() const { return val; }
+	virtual bool value_equals(const string &str) const 
+	{ 
+		return val == str; 
+	}
 	void set_value(const string &str) 
 	{ 
 		val = str;
@@ -531,6 +758,11 @@ public:
 
 		return oss.str();
 	}
+	virtual bool value_equals(const string &str) const
+	{
+		T value;
+		return xkeyFromString(str, value) && (value == val);
+	}
 	void set_value(const T &value) throw (Exception) 
 	{ 
 		if ((max >= min) /* we should check boundries. */
@@ -660,6 +892,11 @@ public:
 		if (val < 0 || val >= T::MAX) return "";
 		return T::typeString[val];
 	}
+	virtual bool value_equals(const string &str) const
+	{
+		if (val < 0 || val >= T::MAX) return str.empty();
+		return T::typeString[val] == str;
+	}
 	virtual void set_value(const int &value) throw (Exception)
 	{ 
 		if (value >= 0 && value <= T::MAX) val = value;
@@ -716,6 +953,11 @@ public:
 
 	XSetParam(const string &_pname) : XMixParam(_pname),
 						smapEnabled(false) {}
+	/**
+	 * Sets may be large, so their children would be streamed one by
+	 * one. Sets that develope _xml(...) should return false.
+	 */
+	virtual bool stream_children() const { return true; }
 	/**
 	 * \param node pointer to parameter node in XML document.
 	 */
@@ -815,6 +1057,13 @@ public:
 		if (iter != smap.end()) return iter->second;
 		return NULL;
 	}
+	virtual bool findChildByKey(const string &_key, XParam *&child) const
+	{
+		if (!smapEnabled) return false;
+		const_smiterator iter = xsmapFind(smap, _key, (Key *)NULL);
+		child = (iter != smap.end()) ? iter->second : NULL;
+		return true;
+	}
 	/**
 	 * Find parameter with highest key.
 	 *
@@ -1075,16 +1324,31 @@ protected:
 	}
 };
 
+/**
+ * Delete parameter of an erased node.
+ */
+inline void _xdisposeParam(XParam *&xparam)
+{
+	delete xparam;
+}
+
 /**
  * \class XListParam
  * "XList" of "XParam" parameters.
+ *
+ * "List" may be XEpochList<XParam *> to have lock-free readers; readers
+ * that run concurrently with deletions should be in read-side section of
+ * list domain in this case, \see XEpochList.
+ * For sets that are scanned much more than changed, "List" may be
+ * XChunkList<XParam *>, \see XChunkList.
  */
-template<typename T, typename Key = int>
-class XListParam : public XISetParam<T, Key, XList<XParam *> >
+template<typename T, typename Key = int, 
+	 typename List = XList<XParam *> >
+class XListParam : public XISetParam<T, Key, List>
 {
 public:
-	typedef XISetParam<T, Key, XList<XParam *> >	_XSetParam;
-	typedef XISetParam<T, Key, XList<XParam *> >	_XISetParam;
+	typedef XISetParam<T, Key, List>		_XSetParam;
+	typedef XISetParam<T, Key, List>		_XISetParam;
 	typedef typename _XISetParam::XMixParam		XMixParam;
 	typedef typename _XISetParam::iterator 		iterator;
 	typedef typename _XISetParam::const_iterator 	const_iterator;
@@ -1095,6 +1359,7 @@ public:
 	typedef typename map::iterator 		smiterator;
 	typedef typename map::const_iterator 	const_smiterator;
 	typedef XParam::XmlNode			XmlNode;
+	typedef typename List::erase_batch	erase_batch;
 
 	using XMixParam::begin;
 	using XMixParam::end;
@@ -1107,14 +1372,19 @@ public:
 
 	/**
 	 * Clear all of child parameters.
+	 *
+	 * All parameters would be prepared at first, and then deleted in
+	 * one batch.
 	 */
 	virtual void clear()
 	{
-		iterator iter;
-		while ((iter = begin()) != end()) {
-			xdel_prepare(iter);
-			xdel(iter);
+		erase_batch batch;
+		for (iterator iter = begin(); iter != end(); ) {
+			iterator cur = iter;
+			++ iter;
+			xdel_prepare(cur, batch);
 		}
+		xdel(batch);
 	}
 	/**
 	 * Find parameter base on id.
@@ -1133,6 +1403,13 @@ public:
 		if (iter != smap.end()) return iter->second;
 		return end();
 	}
+	virtual bool findChildByKey(const string &_key, XParam *&child) const
+	{
+		if (!smapEnabled) return false;
+		const_smiterator iter = xsmapFind(smap, _key, (Key *)NULL);
+		child = (iter != smap.end()) ? *iter->second : NULL;
+		return true;
+	}
 	/**
 	 * Find parameter with highest key.
 	 *
@@ -1183,6 +1460,20 @@ public:
 		}
 		return params.xerase_prepare(iter);
 	}
+	/**
+	 * Prepare element at "iter" for deletion and add him to "batch".
+	 * \see xdel(erase_batch &)
+	 */
+	bool xdel_prepare(iterator &iter, erase_batch &batch)
+	{
+		if (smapEnabled) {
+			Key _key;
+			static_cast<T *>(*iter)->key(_key);
+			smiterator siter = smap.find(_key);
+			if (siter != smap.end()) smap.erase(siter);
+		}
+		return params.xerase_prepare(iter, batch);
+	}
 	/**
 	 * Delete prepared element, should be called after "xdel_prepare" call.
 	 *
@@ -1191,11 +1482,25 @@ public:
 	 */
 	void xdel(iterator &iter)
 	{
-		if (iter != end()) {
-			XParam *xparam = *iter;
-			params.xerase(iter);
-			delete xparam;
-		}
+		if (iter != end()) params.xerase(iter, _xdisposeParam);
+	}
+	/**
+	 * Use "reclaimer" to free deleted elements, so deletions wouldn't
+	 * wait for readers. \see XList::set_reclaimer
+	 */
+	void set_reclaimer(XReclaimer *reclaimer)
+	{
+		params.set_reclaimer(reclaimer);
+	}
+	/**
+	 * Delete all of prepared elements in "batch".
+	 *
+	 * Would block one time until concurrent accesses to the elements
+	 * finish. There shouldn't be any iterator on the elements.
+	 */
+	void xdel(erase_batch &batch)
+	{
+		params.xerase(batch, _xdisposeParam);
 	}
 	/**
 	 * Delete parameter with specified key.
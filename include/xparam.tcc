@@ -61,6 +61,58 @@ XParam* _XMixParam<List>::value(string name) const
 	return NULL;
 }
 
+template<typename List>
+XParam *_XMixParam<List>::findChild(const string &name, size_t &hint) const
+{
+	return _findChild(name, hint, typename 
+		std::iterator_traits<const_iterator>::iterator_category());
+}
+
+template<typename List>
+XParam *_XMixParam<List>::_findChild(const string &name, size_t &hint,
+				std::random_access_iterator_tag) const
+{
+	size_t size = params.size();
+	if (hint < size) {
+		XParam *param = *(params.begin() + hint);
+		if (param->get_pname() == name) return param;
+	}
+	for (size_t i = 0; i < size; ++i) {
+		XParam *param = *(params.begin() + i);
+		if (param->get_pname() == name) {
+			hint = i;
+			return param;
+		}
+	}
+	return NULL;
+}
+
+template<typename List>
+XParam *_XMixParam<List>::_findChild(const string &name, size_t &hint,
+				std::input_iterator_tag) const
+{
+	size_t i = 0;
+	for (const_iterator iter = params.begin(); 
+				iter != params.end(); ++iter, ++i) {
+		if ((*iter)->get_pname() == name) {
+			hint = i;
+			return *iter;
+		}
+	}
+	return NULL;
+}
+
+template<typename List>
+bool _XMixParam<List>::visitChildren(XParam::FT_childVisitor visit,
+						void *arg) const
+{
+	for (const_iterator iter = params.begin(); 
+				iter != params.end(); ++iter) {
+		if (!visit(*iter, arg)) return false;
+	}
+	return true;
+}
+
 template<typename List>
 XParam& _XMixParam<List>::operator =(const XmlNode* node) throw (Exception)
 {
@@ -166,6 +218,29 @@ string _XMixParam<List>::_xml(bool show_runtime,
 	return xstr;
 }
 
+template<typename List>
+void _XMixParam<List>::xmlStream(std::ostream &os, bool show_runtime,
+			const int& indent, const string& endl) const
+{
+	/* Output of classes that develope _xml(...) should be written. */
+	if (! stream_children()) {
+		os << _xml(show_runtime, indent, endl);
+		return;
+	}
+	/* we shouldn't write runtime parameters. */
+	if (dont_show(show_runtime))
+		return;
+
+	string ind(indent, ' ');
+	string ver = (version.empty()) ? "" : " ver=\"" + version + "\"";
+	os << ind << "<" << pname << ver << ">" << endl;
+	for (const_iterator iter = params.begin(); iter != params.end(); ++iter) {
+		(*iter)->xmlStream(os, show_runtime,
+			(indent) ? indent + 4 : indent, endl);
+	}
+	os << ind << "</" << pname << ">" << endl;
+}
+
 template<typename List>
 bool _XMixParam<List>::verify() throw (Exception)
 {
@@ -179,7 +254,7 @@ bool _XMixParam<List>::verify() throw (Exception)
 template<typename List>
 void _XMixParam<List>::dbSave(const XParam* parentNode) throw (Exception)
 {
-	if (params.size() == 0)
+	if (params.empty())
 		return;
 
 	stringList fields, values;
@@ -226,7 +301,7 @@ void _XMixParam<List>::dbSave(const XParam* parentNode) throw (Exception)
 template<typename List>
 void _XMixParam<List>::dbUpdate(const XParam* parentNode) throw (Exception)
 {
-	if (params.size() == 0)
+	if (params.empty())
 		return;
 
 	stringList fields, values;
@@ -303,7 +378,7 @@ template<typename List>
 void _XMixParam<List>::dbCreateStructure(const XParam* parentNode)
 	throw (Exception)
 {
-	if (params.size() == 0)
+	if (params.empty())
 		return;
 
 	stringList fields;
@@ -595,7 +670,7 @@ XParam &XSetParam<T, Key, List>::operator=(const XParam &xp) throw (Exception)
 template<typename T, typename Key, typename List>
 void XSetParam<T, Key, List>::dbSave(const XParam *parentNode) throw (Exception)
 {
-	if (params.size() == 0)
+	if (params.empty())
 		return;
 	if (parentNode == NULL)
 		dbengine->startTransaction();
@@ -632,7 +707,7 @@ void XSetParam<T, Key, List>::dbSave(const XParam *parentNode) throw (Exception)
 template<typename T, typename Key, typename List>
 void XSetParam<T, Key, List>::dbUpdate(const XParam *parentNode) throw (Exception)
 {
-	if (params.size() == 0)
+	if (params.empty())
 		return;
 	stringList fields, values;
 	if (parentNode == NULL)
@@ -691,7 +766,7 @@ template<typename T, typename Key, typename List>
 void XSetParam<T, Key, List>::dbCreateStructure(const XParam *parentNode) 
 							throw (Exception)
 {
-	if (params.size() == 0)
+	if (params.empty())
 		return;
 	stringList fields;
 	vector<DBFieldTypes> ftypes;
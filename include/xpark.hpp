@@ -0,0 +1,98 @@
+/**
+ * \file xpark.hpp
+ * Defines global hashed table to park/unpark waiting threads.
+ *
+ * Objects that need to block threads (like of XList nodes) don't embed
+ * any mutex or condition, they just keep an atomic word and threads
+ * would wait on bucket of object address in a shared table.
+ *
+ * Copyright 2014 PDNSoft Co. (www.pdnsoft.com)
+ * \author hamid jafarian (hamid.jafarian@pdnsoft.com)
+ *
+ * xpark is part of PParam.
+ *
+ * PParam is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PParam is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PParam.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _PDN_XPARK_HPP_
+#define _PDN_XPARK_HPP_
+
+#include <pthread.h>
+#include <time.h>
+
+#include <atomic>
+
+namespace pparam
+{
+
+/**
+ * \class XParkingLot
+ * Parking lot of threads, waiting on atomic words.
+ *
+ * Semantic is like of futex:
+ * \code
+ * 	// waiter:
+ * 	while ((val = word.load()) != desired)
+ * 		XParkingLot::park(obj, word, val);
+ * 	// waker:
+ * 	word.store(desired);
+ * 	XParkingLot::unpark(obj);
+ * \endcode
+ * "park" would block only if "word" is still equal to "expected" under
+ * the bucket lock, so wake ups wouldn't be lost. Many objects may share
+ * a bucket, so waiters should check their condition after wake up.
+ */
+class XParkingLot
+{
+public:
+	/**
+	 * Block calling thread on "addr" if "word" equals to "expected".
+	 * \param abstime give up waiting at this time (CLOCK_MONOTONIC),
+	 * 	NULL: wait without any timeout.
+	 * \return false: wait timed out.
+	 */
+	static bool park(const void *addr, const std::atomic<unsigned> &word,
+			unsigned expected,
+			const struct timespec *abstime = NULL);
+	/**
+	 * Wake up all of threads parked on "addr".
+	 */
+	static void unpark(const void *addr);
+
+private:
+	/**
+	 * Number of buckets, power of 2.
+	 */
+	static const unsigned BUCKETS = 256;
+
+	struct Bucket
+	{
+		pthread_mutex_t lock;
+		pthread_cond_t cond;
+		/**
+		 * Number of parked threads.
+		 */
+		unsigned waiters;
+		char pad[64];
+	};
+
+	static Bucket *bucket(const void *addr);
+	static void init();
+
+	static Bucket *table;
+	static pthread_once_t once;
+};
+
+} // namespace pparam
+
+#endif // _PDN_XPARK_HPP_
@@ -0,0 +1,161 @@
+/**
+ * \file xreclaimer.hpp
+ * Defines background thread to free erased elements.
+ *
+ * Erasers would give unlinked elements to the reclaimer and return
+ * immediately, the reclaimer thread would free elements when there
+ * isn't any access to them.
+ *
+ * Copyright 2014 PDNSoft Co. (www.pdnsoft.com)
+ * \author hamid jafarian (hamid.jafarian@pdnsoft.com)
+ *
+ * xreclaimer is part of PParam.
+ *
+ * PParam is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PParam is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PParam.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _PDN_XRECLAIMER_HPP_
+#define _PDN_XRECLAIMER_HPP_
+
+#include <pthread.h>
+#include <time.h>
+
+#include <atomic>
+#include <deque>
+
+#include "exception.hpp"
+
+namespace pparam
+{
+
+/**
+ * \class XReclaimer
+ * Deferred reclamation of erased elements by a background thread.
+ *
+ * Each erased element would be given to the reclaimer as a "Job", jobs
+ * would be checked by the reclaimer thread periodically and disposed
+ * when they are ready.
+ * \code
+ * 	XReclaimer reclaimer;
+ * 	XList<int> list;
+ * 	list.set_reclaimer(&reclaimer);
+ * 	// xerase wouldn't wait for iterators anymore.
+ * \endcode
+ */
+class XReclaimer
+{
+public:
+	/**
+	 * \class Job
+	 * One element to be disposed.
+	 */
+	class Job
+	{
+		friend class XReclaimer;
+	public:
+		/**
+		 * Could element be disposed now?
+		 */
+		virtual bool ready() = 0;
+		/**
+		 * Free the element.
+		 */
+		virtual void dispose() = 0;
+		virtual ~Job() {}
+	private:
+		/**
+		 * Time of enqueue, to measure latency of reclamation.
+		 */
+		struct timespec queued;
+	};
+
+	/**
+	 * Start reclaimer thread.
+	 * \param _interval wait between checks of not ready jobs, in
+	 * 	micro seconds.
+	 */
+	XReclaimer(unsigned _interval = 1000) throw (Exception);
+	/**
+	 * Give "job" to the reclaimer, job would be deleted after dispose.
+	 */
+	void enqueue(Job *job);
+	/**
+	 * Check queued jobs one time, and dispose ready ones.
+	 * Could be called by any thread to help the reclaimer.
+	 * \return number of disposed jobs.
+	 */
+	size_t reclaim();
+	/**
+	 * Wait until "pending" becomes zero, while helping the reclaimer.
+	 *
+	 * Owners of jobs would use this function to wait for their jobs
+	 * before destruction. It could be called by reclaimer thread too
+	 * (in dispose of a job).
+	 */
+	void wait(const std::atomic<unsigned> &pending);
+	/**
+	 * Number of jobs in queue.
+	 */
+	size_t get_queueDepth();
+	/**
+	 * Number of disposed jobs.
+	 */
+	unsigned long get_reclaimed() const
+	{
+		return reclaimed.load();
+	}
+	/**
+	 * Average time from enqueue to dispose of jobs, in micro seconds.
+	 */
+	unsigned long get_avgLatency() const;
+	/**
+	 * Maximum time from enqueue to dispose of jobs, in micro seconds.
+	 */
+	unsigned long get_maxLatency() const
+	{
+		return maxLatency.load();
+	}
+	/**
+	 * Process wide reclaimer.
+	 */
+	static XReclaimer *global();
+	/**
+	 * Wait to dispose all of jobs, and stop reclaimer thread.
+	 */
+	~XReclaimer();
+
+private:
+	XReclaimer(const XReclaimer &);
+	XReclaimer &operator=(const XReclaimer &);
+
+	static void *run(void *arg);
+	/**
+	 * Dispose "job" and update metrics.
+	 */
+	void finish(Job *job);
+
+	std::deque<Job *> queue;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	pthread_t thread;
+	bool stopping;
+	unsigned interval;
+
+	std::atomic<unsigned long> reclaimed;
+	std::atomic<unsigned long> totalLatency;
+	std::atomic<unsigned long> maxLatency;
+};
+
+} // namespace pparam
+
+#endif // _PDN_XRECLAIMER_HPP_
@@ -0,0 +1,168 @@
+/**
+ * \file xsaver.hpp
+ * Defines asynchronous document saver.
+ *
+ * Callers hand serialized documents to the saver and continue their work,
+ * a background writer thread would write them to the disk by XAtomicFile.
+ * Bursts of saves to the same document would be coalesced into one write.
+ *
+ * Copyright 2014 PDNSoft Co. (www.pdnsoft.com)
+ * \author hamid jafarian (hamid.jafarian@pdnsoft.com)
+ *
+ * xsaver is part of PParam.
+ *
+ * PParam is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PParam is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PParam.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _PDN_XSAVER_HPP_
+#define _PDN_XSAVER_HPP_
+
+#include <pthread.h>
+
+#include <deque>
+#include <future>
+#include <map>
+#include <string>
+#include <vector>
+using std::string;
+
+#include "exception.hpp"
+#include "xfile.hpp"
+
+namespace pparam
+{
+
+/**
+ * \class XDocSaver
+ * Background writer of xml documents.
+ *
+ * \code
+ * 	XDocSaver saver;
+ * 	XDocSaver::Result res = saver.save("repo.xml", repo.xml());
+ * 	...
+ * 	res.get(); // throws Exception if write failed.
+ * 	saver.flush();
+ * \endcode
+ * Each save request would be completed by its future and optional callback.
+ * If a newer request for the same path arrives before the writer starts
+ * writing the older one, only the newer data would be written and both
+ * requests would be completed by that single write.
+ */
+class XDocSaver
+{
+public:
+	/**
+	 * \typedef Result
+	 * Completion of a save request, "get()" rethrows write errors.
+	 */
+	typedef std::shared_future<void> Result;
+	/**
+	 * \typedef FT_saveDone
+	 * Type for completion callbacks.
+	 * \param path path of written document.
+	 * \param error NULL: write done, else: cause of failure.
+	 * \param arg user argument given to "save".
+	 *
+	 * Callbacks would be called in the writer thread.
+	 */
+	typedef void (*FT_saveDone)(const string &path, const Exception *error,
+								void *arg);
+
+	XDocSaver() throw (Exception);
+	/**
+	 * Queue "data" to be written in "path".
+	 * \param compression data would be compressed by writer thread.
+	 */
+	Result save(const string &path, const string &data,
+			FT_saveDone done = NULL, void *arg = NULL,
+			XCompression::Type compression = XCompression::NONE);
+	/**
+	 * Wait until all queued requests have been written.
+	 */
+	void flush();
+	/**
+	 * Number of requests that are waiting for the writer.
+	 */
+	size_t pending();
+	/**
+	 * Process wide saver, would be used by "saveXmlDocAsync" functions
+	 * when no saver specified.
+	 */
+	static XDocSaver *global();
+	/**
+	 * Flush pending requests and stop the writer.
+	 */
+	~XDocSaver();
+
+private:
+	XDocSaver(const XDocSaver &);
+	XDocSaver &operator=(const XDocSaver &);
+
+	/**
+	 * One waiter for completion of a write.
+	 */
+	struct Waiter
+	{
+		std::promise<void> *promise;
+		FT_saveDone done;
+		void *arg;
+	};
+	/**
+	 * Latest data of a document that waits to be written.
+	 */
+	struct Request
+	{
+		string data;
+		XCompression::Type compression;
+		std::vector<Waiter> waiters;
+	};
+	typedef std::map<string, Request *> RequestMap;
+
+	static void *writer(void *arg);
+	void run();
+	void complete(const string &path, Request *req, const Exception *err);
+
+	/**
+	 * Requests waiting to be written, one per path.
+	 */
+	RequestMap requests;
+	/**
+	 * Order of paths to be written.
+	 */
+	std::deque<string> queue;
+	/**
+	 * Is writer busy with a request?
+	 */
+	bool busy;
+	/**
+	 * Would writer stop?
+	 */
+	bool stopping;
+	pthread_t thread;
+	/**
+	 * Lock to manage "requests", "queue" and "busy".
+	 */
+	pthread_mutex_t lock;
+	/**
+	 * Condition to signal new requests to the writer.
+	 */
+	pthread_cond_t work_cond;
+	/**
+	 * Condition to signal end of writes to flushers.
+	 */
+	pthread_cond_t idle_cond;
+};
+
+} // namespace pparam
+
+#endif // _PDN_XSAVER_HPP_
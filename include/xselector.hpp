@@ -0,0 +1,179 @@
+/**
+ * \file xselector.hpp
+ * Defines compiled path selectors on XParam trees.
+ *
+ * A path would be compiled once to a selector object, and the selector
+ * could be evaluated on many trees, many times:
+ * \code
+ * 	XParamSelector sel("server[ip=192.168.0.1/24]/cpu_usage");
+ * 	XParam *cpu = sel.first(&servers);
+ * \endcode
+ *
+ * Copyright 2014 PDNSoft Co. (www.pdnsoft.com)
+ * \author hamid jafarian (hamid.jafarian@pdnsoft.com)
+ *
+ * xselector is part of PParam.
+ *
+ * PParam is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PParam is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PParam.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _PDN_XSELECTOR_HPP_
+#define _PDN_XSELECTOR_HPP_
+
+#include <atomic>
+#include <string>
+#include <vector>
+using std::string;
+
+#include "exception.hpp"
+#include "xparam.hpp"
+
+namespace pparam
+{
+
+/**
+ * \class XParamSelector
+ * Compiled path on XParam trees.
+ *
+ * Path is a list of steps separated by '/', each step selects children
+ * of the parameters that are selected by previous step. First step
+ * would be applied on children of the root parameter.
+ * \code
+ * 	name			children named "name".
+ * 	*			all children.
+ * 	name[value]		child of a set with key "value".
+ * 	name[field=value]	children named "name" whose "field" child
+ * 				has "value".
+ * \endcode
+ * "value" may be quoted by ' or " to contain ']' character.
+ *
+ * Names would be found by XParam::findChild, with a cached position
+ * of previous lookups. Key predicates would be found by search map of
+ * sets (XParam::findChildByKey). If a set has search map, "field=value"
+ * predicates would be examined by his search map first, other children
+ * are scanned just if "value" isn't found there (or found child doesn't
+ * match), because "field" may not be key of every set.
+ * So evaluation doesn't allocate memory, when path exist and all of
+ * predicates use keys.
+ *
+ * Selectors could be shared between threads, evaluation doesn't lock the
+ * tree, so caller should protect the tree against concurrent changes.
+ */
+class XParamSelector
+{
+public:
+	/**
+	 * Compile "path".
+	 * Throws Exception on bad paths.
+	 */
+	XParamSelector(const string &path) throw (Exception);
+	/**
+	 * Return first parameter that matches path, NULL if there isn't any.
+	 */
+	XParam *first(const XParam *root) const;
+	/**
+	 * Append all matched parameters to "result", in tree order.
+	 * \return number of matched parameters.
+	 */
+	size_t select(const XParam *root, std::vector<XParam *> &result) const;
+	/**
+	 * Return source path of selector.
+	 */
+	const string &get_path() const
+	{
+		return path;
+	}
+	/**
+	 * Number of steps of compiled path.
+	 */
+	size_t size() const
+	{
+		return steps.size();
+	}
+	~XParamSelector();
+
+private:
+	XParamSelector(const XParamSelector &);
+	XParamSelector &operator=(const XParamSelector &);
+
+	/**
+	 * One compiled step of path.
+	 */
+	struct Step
+	{
+		enum Predicate {
+			NONE,	/**< No predicate. */
+			KEY,	/**< name[value] */
+			FIELD,	/**< name[field=value] */
+		};
+		Step() : any(false), predicate(NONE),
+				nameHint(0), fieldHint(0)
+		{}
+
+		string name;
+		bool any;
+		Predicate predicate;
+		string field;
+		string value;
+		/**
+		 * Positions of previous lookups of "name" and "field".
+		 */
+		mutable std::atomic<size_t> nameHint;
+		mutable std::atomic<size_t> fieldHint;
+	};
+	/**
+	 * State of one evaluation.
+	 */
+	struct Context
+	{
+		XParam *first;
+		std::vector<XParam *> *result;
+		size_t count;
+	};
+	/**
+	 * Arguments of scan visitor.
+	 */
+	struct ScanArg
+	{
+		const XParamSelector *selector;
+		size_t index;
+		Context *ctx;
+		const XParam *skip;
+		bool stopped;
+	};
+
+	void compile() throw (Exception);
+	/**
+	 * Apply steps from "index" on children of "node".
+	 * \return true: evaluation finished (first match found).
+	 */
+	bool walk(const XParam *node, size_t index, Context &ctx) const;
+	/**
+	 * Check all children of "node" for step "index".
+	 */
+	bool scan(const XParam *node, size_t index, Context &ctx,
+					const XParam *skip) const;
+	static bool scanVisitor(XParam *child, void *arg);
+	/**
+	 * Does "param" match step "index"?
+	 */
+	bool match(const Step &step, const XParam *param) const;
+	bool fieldMatch(const Step &step, const XParam *param) const;
+
+	string path;
+	std::vector<Step *> steps;
+};
+
+} // namespace pparam
+
+#endif // _PDN_XSELECTOR_HPP_
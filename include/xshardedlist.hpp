@@ -0,0 +1,805 @@
+/**
+ * \file xshardedlist.hpp
+ * Defines object list that is partitioned to shards, so writers of
+ * unrelated objects would run concurrently.
+ *
+ * Copyright 2014 PDNSoft Co. (www.pdnsoft.com)
+ * \author hamid jafarian (hamid.jafarian@pdnsoft.com)
+ *
+ * xshardedlist is part of PParam.
+ *
+ * PParam is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PParam is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PParam.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _PDN_XSHARDEDLIST_HPP_
+#define _PDN_XSHARDEDLIST_HPP_
+
+#include <pthread.h>
+
+#include <functional>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+
+#include "xobject.hpp"
+#include "xfile.hpp"
+
+namespace pparam
+{
+
+/**
+ * \class XStripedIndex
+ * Multimap of strings that could be changed concurrently.
+ *
+ * Each key is protected by one of "STRIPES" locks based on key hash, so
+ * changes of different keys mostly run concurrently.
+ */
+class XStripedIndex
+{
+public:
+	/**
+	 * \typedef FT_conflict
+	 * Does value "other" of "key" conflict with new "value"?
+	 */
+	typedef bool (*FT_conflict)(const string &key, const string &value,
+					const string &other, void *arg);
+
+	XStripedIndex();
+	/**
+	 * Add "value" to "key" if no other value of "key" conflicts
+	 * with him.
+	 *
+	 * "conflict" would be called under lock of "key"; NULL: any other
+	 * value conflicts, so "key" would have just one value.
+	 * \return false: conflict found, true: value added or exists.
+	 */
+	bool reserve(const string &key, const string &value,
+			FT_conflict conflict = NULL, void *arg = NULL);
+	/**
+	 * Add "value" to "key" without any check, if he doesn't exist.
+	 */
+	void insert(const string &key, const string &value);
+	/**
+	 * Remove "value" of "key".
+	 */
+	void erase(const string &key, const string &value);
+	/**
+	 * Append values of "key" to "values".
+	 */
+	void find(const string &key, std::vector<string> &values);
+	void clear();
+	~XStripedIndex();
+
+private:
+	XStripedIndex(const XStripedIndex &);
+	XStripedIndex &operator=(const XStripedIndex &);
+
+	enum { STRIPES = 64 };
+	typedef std::unordered_multimap<string, string>	Map;
+	/**
+	 * Keys of one stripe. Stripes are padded, so locks of
+	 * different stripes never share a cache line.
+	 */
+	struct Stripe
+	{
+		pthread_mutex_t lock;
+		Map map;
+		char pad[64];
+	};
+
+	Stripe &stripe(const string &key);
+	/**
+	 * Does "map" have "value" for "key"? Stripe lock should be held.
+	 */
+	static bool exists(Map &map, const string &key, const string &value);
+
+	Stripe stripes[STRIPES];
+};
+
+/**
+ * \class XShardedObjectList
+ * List of XObject\<Type\> that is partitioned to shards by key hash.
+ *
+ * Each shard is an XObjectList with his own locks, so add/del/mod of
+ * objects in different shards run concurrently; XObjectList would
+ * serialize them on his "list_lock" and "dup_lock".
+ * Keys are unique in shards. Names and structures (\see
+ * XObject::has_structural_key) should be unique in whole list, so they are
+ * reserved in concurrent indexes (XStripedIndex) before shards change,
+ * and indexes would be settled with shards afterward. Operations on
+ * one key are serialized by a striped key lock.
+ *
+ * Iteration, xml() and save() walk shards in order, and objects of each
+ * shard in order of addition; xml() and save() hold read locks of all
+ * shards, so they see a consistent list.
+ * Shards shouldn't be changed directly.
+ */
+template <typename Type>
+class XShardedObjectList
+{
+public:
+	typedef XObject<Type>				_XObject;
+	typedef XObjectList<Type>			_XObjectList;
+	typedef XShardedObjectList<Type>		_XShardedObjectList;
+	typedef typename Type::Literal			TypeLiteral;
+	typedef std::vector<TypeLiteral>		Priority;
+	typedef typename _XObjectList::iterator		shard_iterator;
+	typedef XObjectStatus				ObjStatus;
+
+	/**
+	 * \class iterator
+	 * Iterates objects of all shards.
+	 */
+	class iterator
+	{
+	public:
+		iterator() : owner(NULL), shard(0) {}
+		iterator(_XShardedObjectList *_owner, unsigned _shard,
+				const shard_iterator &_iter) :
+			owner(_owner), shard(_shard), iter(_iter)
+		{
+			skip();
+		}
+		_XObject *operator*()
+		{
+			return (_XObject *)*iter;
+		}
+		iterator &operator++()
+		{
+			++ iter;
+			skip();
+			return *this;
+		}
+		bool operator==(const iterator &rvalue) const
+		{
+			bool end = is_end(), rend = rvalue.is_end();
+			if (end || rend) return end && rend;
+			return (shard == rvalue.shard) && (iter == rvalue.iter);
+		}
+		bool operator!=(const iterator &rvalue) const
+		{
+			return !(*this == rvalue);
+		}
+		/**
+		 * Iterator of object in his shard.
+		 */
+		shard_iterator &get_shard_iterator()
+		{
+			return iter;
+		}
+		unsigned get_shard() const
+		{
+			return shard;
+		}
+
+	private:
+		bool is_end() const
+		{
+			return !owner || (shard >= owner->shards.size());
+		}
+		/**
+		 * Go to the first object of next shards, at end of shard.
+		 */
+		void skip()
+		{
+			while (!is_end() && (iter == owner->shards[shard]->end()))
+				if (++ shard < owner->shards.size())
+					iter = owner->shards[shard]->begin();
+				else iter = shard_iterator();
+		}
+
+		_XShardedObjectList *owner;
+		unsigned shard;
+		shard_iterator iter;
+	};
+
+	/**
+	 * \param nshards number of shards.
+	 */
+	XShardedObjectList(const string &_name, const string &logName,
+						unsigned nshards = 16) :
+		name(_name), compression(XCompression::AUTO), snapshots(false)
+	{
+		if (nshards == 0) nshards = 1;
+		for (unsigned i = 0; i < nshards; ++i)
+			shards.push_back(new _XObjectList(name, logName));
+		for (int i = 0; i < STRIPES; ++i)
+			pthread_mutex_init(&keyLocks[i], NULL);
+	}
+	~XShardedObjectList()
+	{
+		for (unsigned i = 0; i < shards.size(); ++i) delete shards[i];
+		for (int i = 0; i < STRIPES; ++i)
+			pthread_mutex_destroy(&keyLocks[i]);
+	}
+	string get_name() const
+	{
+		return name;
+	}
+	unsigned shard_count() const
+	{
+		return shards.size();
+	}
+	/**
+	 * Shard of objects with "key".
+	 */
+	_XObjectList *get_shard(const string &key)
+	{
+		return shards[shardOf(key)];
+	}
+	/**
+	 * Load object to the list, without "add" call of object.
+	 * \see XObjectList::loadObj
+	 */
+	iterator loadObj(_XObject *xo, bool clone = true) throw (Exception)
+	{
+		try {
+			return insert(xo, clone, false);
+		} catch (Exception &e) {
+			e.addTracePoint(TracePoint("xobject"));
+			throw e;
+		}
+	}
+	/**
+	 * Load new object to the list and add.
+	 * \see XObjectList::add
+	 */
+	iterator add(_XObject *xo, bool clone = true) throw (Exception)
+	{
+		try {
+			return insert(xo, clone, true);
+		} catch (Exception &e) {
+			e.addTracePoint(TracePoint("xobject"));
+			throw e;
+		}
+	}
+	/**
+	 * Delete object with "key".
+	 */
+	void del(const string &key) throw (Exception)
+	{
+		pthread_mutex_t *lock = keyLock(key);
+		pthread_mutex_lock(lock);
+		try {
+			get_shard(key)->del(key);
+		} catch (Exception &e) {
+			settle(key);
+			pthread_mutex_unlock(lock);
+			e.addTracePoint(TracePoint("xobject"));
+			throw e;
+		}
+		settle(key);
+		pthread_mutex_unlock(lock);
+	}
+	/**
+	 * Modify object with key of "xo".
+	 * \see XObjectList::mod
+	 */
+	iterator mod(_XObject *xo, bool reload = false) throw (Exception)
+	{
+		string key = xo->get_key();
+		unsigned s = shardOf(key);
+		pthread_mutex_t *lock = keyLock(key);
+		shard_iterator iter;
+		pthread_mutex_lock(lock);
+		try {
+			reserve(xo, key);
+			iter = shards[s]->mod(xo, reload);
+		} catch (Exception &e) {
+			settle(key);
+			pthread_mutex_unlock(lock);
+			e.addTracePoint(TracePoint("xobject"));
+			throw e;
+		}
+		settle(key);
+		pthread_mutex_unlock(lock);
+		return iterator(this, s, iter);
+	}
+	/**
+	 * Lock shard of "objkey" and query specified object.
+	 */
+	iterator query_lock(const string &objkey)
+	{
+		unsigned s = shardOf(objkey);
+		shard_iterator iter = shards[s]->query_lock(objkey);
+		if (iter == shards[s]->end()) return end();
+		return iterator(this, s, iter);
+	}
+	/**
+	 * Query all objects of specified type, in order of shards.
+	 * \return false: can't query all objects, true: all objects queried.
+	 */
+	bool query_type_lock(TypeLiteral _type,
+				std::vector<shard_iterator> &out)
+	{
+		bool isOK = true;
+		for (unsigned i = 0; i < shards.size(); ++i)
+			isOK = shards[i]->query_type_lock(_type, out) && isOK;
+		return isOK;
+	}
+	/**
+	 * Delete all objects of specified type.
+	 */
+	bool delType(TypeLiteral type)
+	{
+		std::vector<string> keys;
+		bool isOK = true;
+		lockKeys();
+		collectKeys(&type, keys);
+		for (unsigned i = 0; i < shards.size(); ++i)
+			isOK = shards[i]->delType(type) && isOK;
+		for (unsigned i = 0; i < keys.size(); ++i) settle(keys[i]);
+		unlockKeys();
+		return isOK;
+	}
+	/**
+	 * Delete all objects, types would be deleted in reverse of priority.
+	 * \return true: all objects has been deleted,
+	 * 		false: some objects couldn't be deleted.
+	 */
+	bool delAll()
+	{
+		std::vector<string> keys;
+		bool isOK = true;
+		int size = priority.size();
+		lockKeys();
+		collectKeys(NULL, keys);
+		for (int i = 0; i < size; ++i)
+			for (unsigned s = 0; s < shards.size(); ++s)
+				isOK = shards[s]->delType(
+					priority.at(size - (1 + i))) && isOK;
+		for (unsigned s = 0; s < shards.size(); ++s)
+			isOK = shards[s]->delAllTypes() && isOK;
+		for (unsigned i = 0; i < keys.size(); ++i) settle(keys[i]);
+		unlockKeys();
+		return isOK;
+	}
+	/**
+	 * Load objects from xml document, objects would be loaded to their
+	 * shards and "addLoadedObjects" should be called to add them.
+	 */
+	bool loadXmlDoc(const string &xdoc, XParam::XmlParser *parser = NULL)
+						throw (Exception)
+	{
+		typename _XObjectList::List staging(name);
+		try {
+			staging.loadXmlDoc(xdoc, parser);
+			for (typename _XObjectList::iterator iter =
+						staging.begin();
+					iter != staging.end(); ++iter)
+				insert((_XObject *)*iter, true, false);
+		} catch (Exception &e) {
+			e.addTracePoint(TracePoint("xobject"));
+			throw e;
+		}
+		set_xmlDoc(xdoc);
+		return true;
+	}
+	/**
+	 * Add loaded objects, by priority of types in all shards.
+	 * \return true: All loaded objects added, false: some objects
+	 * 			couldn't be added.
+	 */
+	bool addLoadedObjects()
+	{
+		bool isOK = true;
+		int size = priority.size();
+		if (size) {
+			for (int i = 0; i < size; ++i)
+				for (unsigned s = 0; s < shards.size(); ++s)
+					isOK = shards[s]->addLoadedObjectsType(
+						priority.at(i)) && isOK;
+		} else {
+			for (unsigned s = 0; s < shards.size(); ++s)
+				isOK = shards[s]->addAllLoadedObjects() && isOK;
+		}
+		return isOK;
+	}
+	bool load()
+	{
+		try {
+			if (has_xmlDoc()) return loadXmlDoc(get_xmlDoc());
+		} catch (Exception &e) {
+			return false;
+		}
+		return true;
+	}
+	/**
+	 * Write xml of list to "os", caller should hold "rdlock".
+	 */
+	void xmlStream(std::ostream &os, bool show_runtime = false,
+			const int &indent = 0, const string &endl = "")
+	{
+		string ind(indent, ' ');
+		os << ind << "<" << name << ">" << endl;
+		for (iterator iter = begin(); iter != end(); ++iter)
+			(*iter)->xmlStream(os, show_runtime,
+				(indent) ? indent + 4 : indent, endl);
+		os << ind << "</" << name << ">" << endl;
+	}
+	string xml(bool show_runtime = false,
+			const int &indent = 0, bool with_endl = false)
+	{
+		if (snapshots)
+			return snapshot(show_runtime, indent, with_endl).xml();
+		std::ostringstream os;
+		rdlock();
+		try {
+			xmlStream(os, show_runtime, indent,
+						(with_endl) ? "\n" : "");
+		} catch (std::exception &e) {
+			unlock();
+			throw;
+		}
+		unlock();
+		return os.str();
+	}
+	/**
+	 * Save consistent image of list in "xdoc".
+	 */
+	void saveXmlDoc(const string &xdoc, bool show_runtime = false,
+			const int &indent = 0, bool with_endl = false)
+						throw (Exception)
+	{
+		string endl = (with_endl) ? "\n" : "";
+		if (snapshots) {
+			try {
+				snapshot(show_runtime, indent, with_endl).save(
+							xdoc, compression);
+			} catch (Exception &e) {
+				e.addTracePoint(TracePoint("xobject"));
+				throw e;
+			}
+			return;
+		}
+		try {
+			XAtomicFile file(xdoc);
+			XDeflateBuf buf(file,
+				XCompression::select(compression, xdoc));
+			std::ostream os(&buf);
+			rdlock();
+			try {
+				xmlStream(os, show_runtime, indent, endl);
+			} catch (std::exception &e) {
+				unlock();
+				throw Exception("Can't generate xml to save "
+						+ name + " !: " + e.what(),
+						TracePoint("xobject"));
+			}
+			unlock();
+			buf.finish();
+			file.commit();
+		} catch (Exception &e) {
+			e.addTracePoint(TracePoint("xobject"));
+			throw e;
+		}
+	}
+	void save() throw (Exception)
+	{
+		if (has_xmlDoc()) saveXmlDoc(get_xmlDoc());
+	}
+	/**
+	 * Point-in-time image of all shards.
+	 * \see XObjectList::snapshot
+	 */
+	XObjectSnapshot snapshot(bool show_runtime = false,
+			const int &indent = 0, bool with_endl = false)
+	{
+		string endl = (with_endl) ? "\n" : "";
+		int oindent = (indent) ? indent + 4 : indent;
+		XObjectSnapshot::Images images;
+		std::vector<typename _XObjectList::StaleImages> 
+						stale(shards.size());
+		for (unsigned i = 0; i < shards.size(); ++i)
+			shards[i]->refreshImages(show_runtime, oindent, endl);
+		rdlock();
+		for (unsigned i = 0; i < shards.size(); ++i)
+			shards[i]->collectImages(images, stale[i], 
+					show_runtime, oindent, endl);
+		unlock();
+		for (unsigned i = 0; i < shards.size(); ++i)
+			_XObjectList::fillImages(images, stale[i],
+					show_runtime, oindent, endl);
+		XObjectSnapshot ret(name, "", indent, endl);
+		for (size_t i = 0; i < images.size(); ++i)
+			ret.addImage(images[i]);
+		return ret;
+	}
+	/**
+	 * \see XObjectList::set_snapshots
+	 */
+	void set_snapshots(bool enable)
+	{
+		snapshots = enable;
+		for (unsigned i = 0; i < shards.size(); ++i)
+			shards[i]->set_snapshots(enable);
+	}
+	bool get_snapshots() const
+	{
+		return snapshots;
+	}
+	void set_xmlDoc(const string &xdoc)
+	{
+		xmlDoc = xdoc;
+	}
+	string get_xmlDoc()
+	{
+		return xmlDoc;
+	}
+	bool has_xmlDoc()
+	{
+		return !xmlDoc.empty();
+	}
+	void set_compression(XCompression::Type c)
+	{
+		compression = c;
+	}
+	XCompression::Type get_compression()
+	{
+		return compression;
+	}
+	void set_priority(const Priority &p)
+	{
+		priority = p;
+	}
+	Priority get_priority()
+	{
+		return priority;
+	}
+	void pushPriority(TypeLiteral type)
+	{
+		priority.push_back(type);
+	}
+	/**
+	 * \see XObjectList::set_reclaimer
+	 */
+	void set_reclaimer(XReclaimer *reclaimer)
+	{
+		for (unsigned i = 0; i < shards.size(); ++i)
+			shards[i]->set_reclaimer(reclaimer);
+	}
+	/**
+	 * \see XObjectList::set_notifier
+	 */
+	void set_notifier(XNotifyExecutor *executor)
+	{
+		for (unsigned i = 0; i < shards.size(); ++i)
+			shards[i]->set_notifier(executor);
+	}
+	/**
+	 * \see XObjectList::set_dependencyIndex
+	 */
+	void set_dependencyIndex(XDependencyIndex *index)
+	{
+		for (unsigned i = 0; i < shards.size(); ++i)
+			shards[i]->set_dependencyIndex(index);
+	}
+	/**
+	 * \see XObjectList::set_addThreads
+	 */
+	void set_addThreads(int threads)
+	{
+		for (unsigned i = 0; i < shards.size(); ++i)
+			shards[i]->set_addThreads(threads);
+	}
+	void set_repo(XObjectRepository<Type> *repo)
+	{
+		for (unsigned i = 0; i < shards.size(); ++i)
+			shards[i]->set_repo(repo);
+	}
+	/**
+	 * Read lock of all shards, in order of shards.
+	 */
+	void rdlock()
+	{
+		for (unsigned i = 0; i < shards.size(); ++i)
+			shards[i]->rdlock();
+	}
+	void unlock()
+	{
+		for (unsigned i = shards.size(); i > 0; --i)
+			shards[i - 1]->unlock();
+	}
+	iterator begin()
+	{
+		return iterator(this, 0, shards[0]->begin());
+	}
+	iterator end()
+	{
+		return iterator(this, shards.size(), shard_iterator());
+	}
+
+private:
+	XShardedObjectList(const XShardedObjectList &);
+	XShardedObjectList &operator=(const XShardedObjectList &);
+
+	enum { STRIPES = 64 };
+
+	/**
+	 * Argument of "sameStructure".
+	 */
+	struct StructArg
+	{
+		_XShardedObjectList *list;
+		_XObject *xo;
+	};
+
+	unsigned shardOf(const string &key)
+	{
+		return std::hash<string>()(key) % shards.size();
+	}
+	pthread_mutex_t *keyLock(const string &key)
+	{
+		return &keyLocks[std::hash<string>()(key) % STRIPES];
+	}
+	void lockKeys()
+	{
+		for (int i = 0; i < STRIPES; ++i)
+			pthread_mutex_lock(&keyLocks[i]);
+	}
+	void unlockKeys()
+	{
+		for (int i = STRIPES - 1; i >= 0; --i)
+			pthread_mutex_unlock(&keyLocks[i]);
+	}
+	/**
+	 * Load (and add) "xo" to his shard.
+	 */
+	iterator insert(_XObject *xo, bool clone, bool add) throw (Exception)
+	{
+		string key = xo->get_key();
+		unsigned s = shardOf(key);
+		pthread_mutex_t *lock = keyLock(key);
+		shard_iterator iter;
+		pthread_mutex_lock(lock);
+		try {
+			reserve(xo, key);
+			if (add) iter = shards[s]->add(xo, clone);
+			else iter = shards[s]->loadObj(xo, clone);
+		} catch (Exception &e) {
+			settle(key);
+			pthread_mutex_unlock(lock);
+			throw e;
+		}
+		pthread_mutex_unlock(lock);
+		return iterator(this, s, iter);
+	}
+	/**
+	 * Reserve name and structure of "xo" for "key" in indexes.
+	 *
+	 * Should be called under lock of "key", "settle" should be called
+	 * after change of shard.
+	 */
+	void reserve(_XObject *xo, const string &key) throw (Exception)
+	{
+		string oname = xo->get_name(), skey = xo->structural_key();
+		bool dup = !names.reserve(oname, key);
+		if (!dup) {
+			keyNames.insert(key, oname);
+			/* Objects without structural equivalency aren't
+			 * reserved, they would all be in one stripe.
+			 */
+			if (xo->has_structural_key()) {
+				StructArg arg = { this, xo };
+				dup = !structs.reserve(skey, key,
+						sameStructure, &arg);
+				if (!dup) keyStructs.insert(key, skey);
+			}
+		}
+		if (dup)
+			throw Exception("Duplicated Object !"
+					" Object name: " + oname,
+					TracePoint("xobject"));
+	}
+	/**
+	 * Make indexes of "key" same as object with "key" in his shard;
+	 * remove reservations that haven't been used.
+	 *
+	 * Should be called under lock of "key".
+	 */
+	void settle(const string &key)
+	{
+		_XObjectList *shard = get_shard(key);
+		string oname, skey;
+		bool exists = false;
+		{
+			shard->rdlock();
+			shard_iterator iter = shard->query(key);
+			if (iter != shard->end()) {
+				_XObject *xobj = (_XObject *)*iter;
+				exists = true;
+				oname = xobj->get_name();
+				skey = xobj->structural_key();
+			}
+			shard->unlock();
+		}
+		std::vector<string> values;
+		keyNames.find(key, values);
+		for (unsigned i = 0; i < values.size(); ++i)
+			if (!exists || (values[i] != oname)) {
+				names.erase(values[i], key);
+				keyNames.erase(key, values[i]);
+			}
+		values.clear();
+		keyStructs.find(key, values);
+		for (unsigned i = 0; i < values.size(); ++i)
+			if (!exists || (values[i] != skey)) {
+				structs.erase(values[i], key);
+				keyStructs.erase(key, values[i]);
+			}
+	}
+	/**
+	 * Conflict of structures, is object with key "other" equivalent
+	 * with new object?
+	 */
+	static bool sameStructure(const string &skey, const string &key,
+					const string &other, void *arg)
+	{
+		StructArg *sarg = (StructArg *)arg;
+		if (other == key) return false;
+		_XObjectList *shard = sarg->list->get_shard(other);
+		shard->rdlock();
+		shard_iterator iter = shard->query(other);
+		bool found = iter != shard->end();
+		shard->unlock();
+		if (!found) return false;
+
+		bool same = false;
+		_XObject *xobj = (_XObject *)*iter;
+		if (xobj->chStatus(ObjStatus::QUERYING)) {
+			same = (*xobj == *sarg->xo);
+			xobj->bkStatus();
+		}
+		return same;
+	}
+	/**
+	 * Keys of objects of "type" (all objects if NULL).
+	 */
+	void collectKeys(TypeLiteral *type, std::vector<string> &keys)
+	{
+		for (iterator iter = begin(); iter != end(); ++iter)
+			if (!type || ((*iter)->get_type() == *type))
+				keys.push_back((*iter)->get_key());
+	}
+
+	string name;
+	/**
+	 * Shards of list.
+	 */
+	std::vector<_XObjectList *> shards;
+	/**
+	 * Locks of keys, each key is protected by "hash % STRIPES" lock.
+	 */
+	pthread_mutex_t keyLocks[STRIPES];
+	/**
+	 * Indexes: name -> key, structural key -> keys, and reverse of
+	 * them: key -> names, key -> structural keys. Reverse indexes
+	 * keep reservations to be settled.
+	 */
+	XStripedIndex names;
+	XStripedIndex structs;
+	XStripedIndex keyNames;
+	XStripedIndex keyStructs;
+
+	Priority priority;
+	string xmlDoc;
+	XCompression::Type compression;
+	/**
+	 * Print and save by snapshots?
+	 */
+	bool snapshots;
+};
+
+} // namespace pparam
+
+#endif // _PDN_XSHARDEDLIST_HPP_
@@ -0,0 +1,108 @@
+/**
+ * \file xsnapshot.hpp
+ * Defines point-in-time image of XObject lists.
+ *
+ * Objects keep xml image of their last version, snapshot of a list is
+ * just references to images of his objects, so it could be taken in a
+ * short critical area and printed/saved without any lock.
+ *
+ * Copyright 2014 PDNSoft Co. (www.pdnsoft.com)
+ * \author hamid jafarian (hamid.jafarian@pdnsoft.com)
+ *
+ * xsnapshot is part of PParam.
+ *
+ * PParam is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PParam is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PParam.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _PDN_XSNAPSHOT_HPP_
+#define _PDN_XSNAPSHOT_HPP_
+
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "exception.hpp"
+#include "xfile.hpp"
+
+namespace pparam
+{
+
+using std::string;
+
+/**
+ * \class XObjectSnapshot
+ * Xml images of objects of a list (and snapshots of sub-lists), in
+ * order of list.
+ *
+ * Images are immutable and shared with objects, so snapshot would be
+ * valid after any change or deletion of objects.
+ * \code
+ * 	XObjectSnapshot snap = list.snapshot();
+ * 	// list could be changed here ...
+ * 	snap.save("objects.xml");
+ * \endcode
+ */
+class XObjectSnapshot
+{
+public:
+	typedef std::shared_ptr<const string> Image;
+	typedef std::vector<Image> Images;
+
+	/**
+	 * \param pname name of list element.
+	 * \param ver version attribute of list element, "": no version.
+	 * \param indent indention of list element.
+	 * \param endl end-line of list element.
+	 */
+	XObjectSnapshot(const string &pname = "", const string &ver = "",
+			const int &indent = 0, const string &endl = "");
+	/**
+	 * Append image of one object, NULL images are ignored.
+	 */
+	void addImage(const Image &image)
+	{
+		if (image) images.push_back(image);
+	}
+	/**
+	 * Append snapshot of a sub-list.
+	 */
+	void addSnapshot(const XObjectSnapshot &snapshot)
+	{
+		children.push_back(snapshot);
+	}
+	/**
+	 * Number of objects in snapshot and his sub-lists.
+	 */
+	size_t size() const;
+	void xmlStream(std::ostream &os) const;
+	string xml() const;
+	/**
+	 * Save snapshot in "xdoc" atomically.
+	 */
+	void save(const string &xdoc, 
+			XCompression::Type compression = XCompression::AUTO)
+							throw (Exception);
+
+private:
+	string pname;
+	string version;
+	int indent;
+	string endl;
+	Images images;
+	std::vector<XObjectSnapshot> children;
+};
+
+} // namespace pparam
+
+#endif // _PDN_XSNAPSHOT_HPP_
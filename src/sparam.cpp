@@ -42,11 +42,21 @@ XParam &UUIDParam::operator = (const XParam &xp) throw (Exception)
 
 string UUIDParam::value() const
 {
-	char uuid_str[36];
+	char uuid_str[37];
 	uuid_unparse(uuid, uuid_str);
 	return uuid_str;
 }
 
+/** Implementation of "UUIDKey" struct */
+
+bool UUIDKey::parse(const string &str)
+{
+	uuid_t uuid;
+	if (uuid_parse(str.c_str(), uuid) == -1) return false;
+	*this = UUIDKey(uuid);
+	return true;
+}
+
 /** Implementation of "CryptoParam" class */
 
 string CryptoParam::md5(const string &text)
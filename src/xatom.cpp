@@ -0,0 +1,80 @@
+#include "xatom.hpp"
+
+namespace pparam
+{
+
+/* Implementation of "XAtom" class.
+ */
+XAtom::Atoms *XAtom::atoms = NULL;
+XAtom::Atom *XAtom::emptyAtom = NULL;
+pthread_rwlock_t XAtom::lock = PTHREAD_RWLOCK_INITIALIZER;
+pthread_once_t XAtom::once = PTHREAD_ONCE_INIT;
+
+void XAtom::init()
+{
+	/* Atoms may be created by static constructors, so the table
+	 * would be created at first use.
+	 */
+	atoms = new Atoms;
+	emptyAtom = &*(atoms->emplace(string(), 0).first);
+}
+
+XAtom::Atom *XAtom::none()
+{
+	pthread_once(&once, init);
+	return emptyAtom;
+}
+
+XAtom::Atom *XAtom::intern(const string &str)
+{
+	pthread_once(&once, init);
+	if (str.empty()) return emptyAtom;
+	/* Most of strings are interned before, so look them up
+	 * under the read lock at first; atoms are removed just under
+	 * the write lock, so the found atom would be alive.
+	 */
+	pthread_rwlock_rdlock(&lock);
+	Atoms::iterator iter = atoms->find(str);
+	if (iter != atoms->end()) {
+		Atom *ret = &*iter;
+		++ ret->second;
+		pthread_rwlock_unlock(&lock);
+		return ret;
+	}
+	pthread_rwlock_unlock(&lock);
+
+	pthread_rwlock_wrlock(&lock);
+	Atom *ret = &*(atoms->emplace(str, 0).first);
+	++ ret->second;
+	pthread_rwlock_unlock(&lock);
+	return ret;
+}
+
+void XAtom::release(Atom *a)
+{
+	if (a == emptyAtom) return;
+	unsigned long refs = a->second.load();
+	/* Other XAtoms hold the atom, just uncount him.
+	 */
+	while (refs > 1)
+		if (a->second.compare_exchange_weak(refs, refs - 1))
+			return;
+	/* May be the last one, intern() could count him again till we
+	 * get the write lock.
+	 */
+	pthread_rwlock_wrlock(&lock);
+	if (a->second.fetch_sub(1) == 1)
+		atoms->erase(atoms->find(a->first));
+	pthread_rwlock_unlock(&lock);
+}
+
+size_t XAtom::count()
+{
+	pthread_once(&once, init);
+	pthread_rwlock_rdlock(&lock);
+	size_t ret = atoms->size();
+	pthread_rwlock_unlock(&lock);
+	return ret;
+}
+
+} // namespace pparam
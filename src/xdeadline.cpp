@@ -0,0 +1,72 @@
+#include "xdeadline.hpp"
+
+namespace pparam
+{
+
+/* Implementation of "XDeadline" class.
+ */
+pthread_key_t XDeadline::key;
+pthread_once_t XDeadline::once = PTHREAD_ONCE_INIT;
+
+void XDeadline::init()
+{
+	pthread_key_create(&key, NULL);
+}
+
+XDeadline *XDeadline::current()
+{
+	pthread_once(&once, init);
+	return (XDeadline *)pthread_getspecific(key);
+}
+
+static bool before(const struct timespec &a, const struct timespec &b)
+{
+	return (a.tv_sec < b.tv_sec) ||
+		((a.tv_sec == b.tv_sec) && (a.tv_nsec < b.tv_nsec));
+}
+
+XDeadline::XDeadline(unsigned int msec) : fired(false)
+{
+	clock_gettime(CLOCK_MONOTONIC, &when);
+	when.tv_sec += msec / 1000;
+	when.tv_nsec += (msec % 1000) * 1000000L;
+	if (when.tv_nsec >= 1000000000L) {
+		++ when.tv_sec;
+		when.tv_nsec -= 1000000000L;
+	}
+	outer = current();
+	if (outer && before(outer->when, when)) when = outer->when;
+	pthread_setspecific(key, this);
+}
+
+const struct timespec *XDeadline::abstime()
+{
+	XDeadline *d = current();
+	return d ? &d->when : NULL;
+}
+
+void XDeadline::fire()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	XDeadline *d = current();
+	if (d) d->fired = true;
+	/* Outer deadlines are fired, if they are passed too.
+	 */
+	for (d = d ? d->outer : NULL; d && !before(now, d->when);
+							d = d->outer)
+		d->fired = true;
+}
+
+bool XDeadline::timedout()
+{
+	XDeadline *d = current();
+	return d && d->fired;
+}
+
+XDeadline::~XDeadline()
+{
+	pthread_setspecific(key, outer);
+}
+
+} // namespace pparam
@@ -0,0 +1,147 @@
+#include "xdepindex.hpp"
+
+#include <deque>
+
+namespace pparam
+{
+
+/* Implementation of "XDependencyIndex" class.
+ */
+XDependencyIndex::XDependencyIndex() :
+	edges(0),
+	cacheHits(0),
+	cacheMisses(0)
+{
+	pthread_mutex_init(&lock, NULL);
+}
+
+void XDependencyIndex::addEdge(const string &obj, const string &dependent)
+{
+	pthread_mutex_lock(&lock);
+	if (++ graph[obj][dependent] == 1) {
+		++ edges;
+		invalidate(obj);
+	}
+	pthread_mutex_unlock(&lock);
+}
+
+void XDependencyIndex::delEdge(const string &obj, const string &dependent)
+{
+	pthread_mutex_lock(&lock);
+	Graph::iterator g = graph.find(obj);
+	if (g != graph.end()) {
+		Edges::iterator e = g->second.find(dependent);
+		if ((e != g->second.end()) && (-- e->second == 0)) {
+			g->second.erase(e);
+			if (g->second.empty()) graph.erase(g);
+			-- edges;
+			invalidate(obj);
+		}
+	}
+	pthread_mutex_unlock(&lock);
+}
+
+void XDependencyIndex::invalidate(const string &obj)
+{
+	Members::iterator m = members.find(obj);
+	if (m == members.end()) return;
+	std::unordered_set<string> roots;
+	roots.swap(m->second);
+	members.erase(m);
+	for (std::unordered_set<string>::iterator root = roots.begin();
+					root != roots.end(); ++root) {
+		Closures::iterator c = closures.find(*root);
+		if (c == closures.end()) continue;
+		/* Root is member of his closure too.
+		 */
+		unmember(*root, *root);
+		for (Keys::iterator k = c->second.begin();
+					k != c->second.end(); ++k)
+			unmember(*k, *root);
+		closures.erase(c);
+	}
+}
+
+void XDependencyIndex::unmember(const string &obj, const string &root)
+{
+	Members::iterator m = members.find(obj);
+	if (m == members.end()) return;
+	m->second.erase(root);
+	if (m->second.empty()) members.erase(m);
+}
+
+bool XDependencyIndex::has_dependents(const string &obj)
+{
+	pthread_mutex_lock(&lock);
+	bool ret = graph.find(obj) != graph.end();
+	pthread_mutex_unlock(&lock);
+	return ret;
+}
+
+XDependencyIndex::Keys XDependencyIndex::dependents(const string &obj)
+{
+	Keys ret;
+	pthread_mutex_lock(&lock);
+	Graph::iterator g = graph.find(obj);
+	if (g != graph.end())
+		for (Edges::iterator e = g->second.begin();
+					e != g->second.end(); ++e)
+			ret.push_back(e->first);
+	pthread_mutex_unlock(&lock);
+	return ret;
+}
+
+XDependencyIndex::Keys XDependencyIndex::closure(const string &obj)
+{
+	pthread_mutex_lock(&lock);
+	Closures::iterator c = closures.find(obj);
+	if (c != closures.end()) {
+		Keys ret = c->second;
+		pthread_mutex_unlock(&lock);
+		++ cacheHits;
+		return ret;
+	}
+	++ cacheMisses;
+	/* BFS on dependents, there may be loops.
+	 */
+	Keys ret;
+	std::unordered_set<string> visited;
+	std::deque<const string *> queue;
+	visited.insert(obj);
+	queue.push_back(&obj);
+	while (!queue.empty()) {
+		Graph::iterator g = graph.find(*queue.front());
+		queue.pop_front();
+		if (g == graph.end()) continue;
+		for (Edges::iterator e = g->second.begin();
+					e != g->second.end(); ++e) {
+			if (! visited.insert(e->first).second) continue;
+			ret.push_back(e->first);
+			queue.push_back(&(e->first));
+		}
+	}
+	/* Closure would be invalid when dependents of any of his
+	 * members (or root) change.
+	 */
+	members[obj].insert(obj);
+	for (Keys::iterator k = ret.begin(); k != ret.end(); ++k)
+		members[*k].insert(obj);
+	closures[obj] = ret;
+	pthread_mutex_unlock(&lock);
+	return ret;
+}
+
+size_t XDependencyIndex::size()
+{
+	pthread_mutex_lock(&lock);
+	size_t ret = edges;
+	pthread_mutex_unlock(&lock);
+	return ret;
+}
+
+XDependencyIndex::~XDependencyIndex()
+{
+	pthread_mutex_destroy(&lock);
+}
+
+} // namespace pparam
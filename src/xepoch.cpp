@@ -0,0 +1,165 @@
+#include "xepoch.hpp"
+
+#include <sched.h>
+
+namespace pparam
+{
+
+/* Implementation of "XEpochDomain" class.
+ */
+XEpochDomain::XEpochDomain() : epoch(1), records(NULL), limboSize(0)
+{
+	pthread_key_create(&recordKey, releaseRecord);
+	pthread_mutex_init(&lock, NULL);
+}
+
+XEpochDomain::Record *XEpochDomain::record()
+{
+	Record *rec = (Record *)pthread_getspecific(recordKey);
+	if (rec) return rec;
+
+	/* Reuse record of an exited thread, if there is any.
+	 */
+	for (rec = records.load(std::memory_order_acquire); rec;
+							rec = rec->next) {
+		bool used = false;
+		if (rec->used.compare_exchange_strong(used, true)) break;
+	}
+	if (!rec) {
+		rec = new Record;
+		rec->epoch.store(0);
+		rec->used.store(true);
+		rec->next = records.load(std::memory_order_relaxed);
+		while (!records.compare_exchange_weak(rec->next, rec,
+						std::memory_order_release,
+						std::memory_order_relaxed));
+	}
+	rec->nest = 0;
+	pthread_setspecific(recordKey, rec);
+	return rec;
+}
+
+void XEpochDomain::releaseRecord(void *_rec)
+{
+	Record *rec = (Record *)_rec;
+	rec->nest = 0;
+	rec->epoch.store(0, std::memory_order_release);
+	rec->used.store(false, std::memory_order_release);
+}
+
+void XEpochDomain::enter()
+{
+	Record *rec = record();
+	if (rec->nest++ == 0)
+		rec->epoch.store(epoch.load(std::memory_order_seq_cst),
+					std::memory_order_seq_cst);
+}
+
+void XEpochDomain::leave()
+{
+	Record *rec = record();
+	if (--rec->nest == 0)
+		rec->epoch.store(0, std::memory_order_release);
+}
+
+bool XEpochDomain::in_section()
+{
+	return record()->nest > 0;
+}
+
+bool XEpochDomain::tryAdvance()
+{
+	unsigned long e = epoch.load(std::memory_order_seq_cst);
+	for (Record *rec = records.load(std::memory_order_acquire); rec;
+							rec = rec->next) {
+		unsigned long re = rec->epoch.load(std::memory_order_seq_cst);
+		if (re && (re != e)) return false;
+	}
+	epoch.store(e + 1, std::memory_order_seq_cst);
+	return true;
+}
+
+void XEpochDomain::retire(void *obj, FT_dispose _dispose, void *arg)
+{
+	Retired r = { obj, _dispose, arg };
+	RetiredList freed;
+
+	pthread_mutex_lock(&lock);
+	limbo[epoch.load() % 3].push_back(r);
+	++ limboSize;
+	if (tryAdvance()) {
+		/* Objects retired two epochs ago can't be seen anymore.
+		 */
+		freed.swap(limbo[(epoch.load() + 1) % 3]);
+		limboSize -= freed.size();
+	}
+	pthread_mutex_unlock(&lock);
+	dispose(freed);
+}
+
+void XEpochDomain::synchronize()
+{
+	unsigned long target = epoch.load() + 2;
+	while (1) {
+		RetiredList freed;
+		bool advanced;
+
+		pthread_mutex_lock(&lock);
+		if (epoch.load() >= target) {
+			pthread_mutex_unlock(&lock);
+			break;
+		}
+		advanced = tryAdvance();
+		if (advanced) {
+			freed.swap(limbo[(epoch.load() + 1) % 3]);
+			limboSize -= freed.size();
+		}
+		pthread_mutex_unlock(&lock);
+		dispose(freed);
+		if (!advanced) sched_yield();
+	}
+}
+
+size_t XEpochDomain::pending()
+{
+	pthread_mutex_lock(&lock);
+	size_t ret = limboSize;
+	pthread_mutex_unlock(&lock);
+	return ret;
+}
+
+void XEpochDomain::dispose(RetiredList &list)
+{
+	for (RetiredList::iterator iter = list.begin();
+					iter != list.end(); ++iter)
+		iter->dispose(iter->obj, iter->arg);
+}
+
+static XEpochDomain *globalDomain = NULL;
+static pthread_once_t globalDomainOnce = PTHREAD_ONCE_INIT;
+
+static void createGlobalDomain()
+{
+	globalDomain = new XEpochDomain;
+}
+
+XEpochDomain *XEpochDomain::global()
+{
+	pthread_once(&globalDomainOnce, createGlobalDomain);
+	return globalDomain;
+}
+
+XEpochDomain::~XEpochDomain()
+{
+	for (int i = 0; i < 3; ++i) dispose(limbo[i]);
+	pthread_key_delete(recordKey);
+	Record *rec = records.load();
+	while (rec) {
+		Record *next = rec->next;
+		delete rec;
+		rec = next;
+	}
+	pthread_mutex_destroy(&lock);
+}
+
+} // namespace pparam
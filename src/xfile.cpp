@@ -0,0 +1,307 @@
+#include "xfile.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <vector>
+
+namespace pparam
+{
+
+/* Implementation of "XAtomicFile" class.
+ */
+XAtomicFile::XAtomicFile(const string &_path) throw (Exception) :
+	path(_path), fd(-1)
+{
+	std::vector<char> tmpl(path.begin(), path.end());
+	const char suffix[] = ".XXXXXX";
+	tmpl.insert(tmpl.end(), suffix, suffix + sizeof(suffix));
+
+	fd = mkstemp(&tmpl[0]);
+	if (fd < 0)
+		throw Exception("Can't create temporary file for " + path +
+				" !: " + strerror(errno),
+				TracePoint("pparam"));
+	tmpPath = &tmpl[0];
+
+	/* Keep permissions of the old document, if there is any.
+	 */
+	struct stat st;
+	mode_t mode = (::stat(path.c_str(), &st) == 0) ?
+			(st.st_mode & 07777) : 0644;
+	fchmod(fd, mode);
+}
+
+void XAtomicFile::write(const char *data, size_t len) throw (Exception)
+{
+	if (fd < 0)
+		throw Exception("File " + path + " isn't open !",
+						TracePoint("pparam"));
+	while (len > 0) {
+		ssize_t ret = ::write(fd, data, len);
+		if (ret < 0) {
+			if (errno == EINTR) continue;
+			throw Exception("Can't write to " + path + " !: " +
+					strerror(errno), TracePoint("pparam"));
+		}
+		data += ret;
+		len -= ret;
+	}
+}
+
+void XAtomicFile::commit() throw (Exception)
+{
+	if (fd < 0)
+		throw Exception("File " + path + " isn't open !",
+						TracePoint("pparam"));
+	if (fsync(fd) < 0) {
+		string err = strerror(errno);
+		abort();
+		throw Exception("Can't sync " + path + " !: " + err,
+						TracePoint("pparam"));
+	}
+	if (close(fd) < 0) {
+		fd = -1;
+		string err = strerror(errno);
+		unlink(tmpPath.c_str());
+		throw Exception("Can't close " + path + " !: " + err,
+						TracePoint("pparam"));
+	}
+	fd = -1;
+	if (rename(tmpPath.c_str(), path.c_str()) < 0) {
+		string err = strerror(errno);
+		unlink(tmpPath.c_str());
+		throw Exception("Can't replace " + path + " !: " + err,
+						TracePoint("pparam"));
+	}
+	/* Sync directory entry, so rename survives a crash.
+	 */
+	size_t slash = path.rfind('/');
+	string dir = (slash == string::npos) ? "." :
+			(slash == 0) ? "/" : path.substr(0, slash);
+	int dfd = open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+	if (dfd >= 0) {
+		fsync(dfd);
+		close(dfd);
+	}
+}
+
+void XAtomicFile::abort()
+{
+	if (fd < 0) return;
+	close(fd);
+	fd = -1;
+	unlink(tmpPath.c_str());
+}
+
+void XAtomicFile::save(const string &path, const string &data)
+							throw (Exception)
+{
+	XAtomicFile file(path);
+	try {
+		file.write(data);
+		file.commit();
+	} catch (Exception &e) {
+		e.addTracePoint(TracePoint("pparam"));
+		throw e;
+	}
+}
+
+XAtomicFile::~XAtomicFile()
+{
+	abort();
+}
+
+/* Implementation of "XCompression" class.
+ */
+const string XCompression::typeString[XCompression::MAX] = {
+	"none",
+	"gzip",
+	"zlib",
+	"auto",
+	};
+
+static bool hasSuffix(const string &str, const string &suffix)
+{
+	return (str.size() >= suffix.size()) &&
+		(str.compare(str.size() - suffix.size(), suffix.size(),
+							suffix) == 0);
+}
+
+XCompression::Type XCompression::select(Type policy, const string &path)
+{
+	if (policy != AUTO) return policy;
+	if (hasSuffix(path, ".gz")) return GZIP;
+	if (hasSuffix(path, ".zz") || hasSuffix(path, ".z")) return ZLIB;
+	return NONE;
+}
+
+XCompression::Type XCompression::detect(const unsigned char *magic,
+								size_t len)
+{
+	if (len < 2) return NONE;
+	if ((magic[0] == 0x1f) && (magic[1] == 0x8b)) return GZIP;
+	/* zlib header: deflate method and valid header checksum.
+	 * Plain xml always starts with '<', blank or BOM.
+	 */
+	if (((magic[0] & 0x0f) == Z_DEFLATED) &&
+			((((unsigned)magic[0] << 8) | magic[1]) % 31 == 0))
+		return ZLIB;
+	return NONE;
+}
+
+/* Implementation of "XDeflateBuf" class.
+ */
+XDeflateBuf::XDeflateBuf(XAtomicFile &_file, XCompression::Type _type)
+							throw (Exception) :
+	file(_file), type(_type), finished(false)
+{
+	if ((type == XCompression::AUTO) || (type == XCompression::MAX))
+		type = XCompression::select(XCompression::AUTO,
+							file.get_path());
+	if (type != XCompression::NONE) {
+		zs.zalloc = Z_NULL;
+		zs.zfree = Z_NULL;
+		zs.opaque = Z_NULL;
+		int wbits = (type == XCompression::GZIP) ? 15 + 16 : 15;
+		if (deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 
+				wbits, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+			throw Exception("Can't initialize compression for " +
+						file.get_path() + " !",
+						TracePoint("pparam"));
+	}
+	setp(in, in + sizeof(in));
+}
+
+bool XDeflateBuf::drain(int flush)
+{
+	size_t len = pptr() - pbase();
+	setp(in, in + sizeof(in));
+	if (!error.empty()) return false;
+	try {
+		if (type == XCompression::NONE) {
+			file.write(in, len);
+			return true;
+		}
+		zs.next_in = (Bytef *)in;
+		zs.avail_in = len;
+		int ret;
+		do {
+			zs.next_out = (Bytef *)out;
+			zs.avail_out = sizeof(out);
+			ret = deflate(&zs, flush);
+			if (ret == Z_STREAM_ERROR) {
+				error = "Can't compress " + file.get_path();
+				return false;
+			}
+			file.write(out, sizeof(out) - zs.avail_out);
+		} while (zs.avail_out == 0);
+	} catch (Exception &e) {
+		error = e.what();
+		return false;
+	}
+	return true;
+}
+
+XDeflateBuf::int_type XDeflateBuf::overflow(int_type c)
+{
+	if (!drain(Z_NO_FLUSH)) return traits_type::eof();
+	if (!traits_type::eq_int_type(c, traits_type::eof())) {
+		*pptr() = traits_type::to_char_type(c);
+		pbump(1);
+	}
+	return traits_type::not_eof(c);
+}
+
+int XDeflateBuf::sync()
+{
+	/* Don't flush compressor, it would reduce compression ratio.
+	 */
+	return drain(Z_NO_FLUSH) ? 0 : -1;
+}
+
+void XDeflateBuf::finish() throw (Exception)
+{
+	if (!finished) {
+		drain(Z_FINISH);
+		finished = true;
+	}
+	if (!error.empty())
+		throw Exception(error + " !", TracePoint("pparam"));
+}
+
+XDeflateBuf::~XDeflateBuf()
+{
+	if (type != XCompression::NONE) deflateEnd(&zs);
+}
+
+/* Implementation of "XInflateBuf" class.
+ */
+XInflateBuf::XInflateBuf(int _fd) throw (Exception) :
+	fd(_fd), eof(false), streamEnd(false)
+{
+	zs.zalloc = Z_NULL;
+	zs.zfree = Z_NULL;
+	zs.opaque = Z_NULL;
+	zs.next_in = Z_NULL;
+	zs.avail_in = 0;
+	/* 15 + 32: detect gzip or zlib header automatically.
+	 */
+	if (inflateInit2(&zs, 15 + 32) != Z_OK)
+		throw Exception("Can't initialize decompression !",
+						TracePoint("pparam"));
+	setg(out, out, out);
+}
+
+XInflateBuf::int_type XInflateBuf::underflow()
+{
+	if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+	if (!error.empty()) return traits_type::eof();
+
+	while (1) {
+		if ((zs.avail_in == 0) && !eof) {
+			ssize_t ret = ::read(fd, in, sizeof(in));
+			if (ret < 0) {
+				if (errno == EINTR) continue;
+				error = strerror(errno);
+				return traits_type::eof();
+			}
+			if (ret == 0) eof = true;
+			zs.next_in = (Bytef *)in;
+			zs.avail_in = ret;
+		}
+		if ((zs.avail_in == 0) && eof) {
+			if (!streamEnd)
+				error = "Compressed document is truncated";
+			return traits_type::eof();
+		}
+		zs.next_out = (Bytef *)out;
+		zs.avail_out = sizeof(out);
+		int ret = inflate(&zs, Z_NO_FLUSH);
+		if (ret == Z_STREAM_END) {
+			/* There may be another concatenated member.
+			 */
+			streamEnd = true;
+			inflateReset(&zs);
+		} else if ((ret != Z_OK) && (ret != Z_BUF_ERROR)) {
+			error = (zs.msg) ? zs.msg : "Bad compressed document";
+			return traits_type::eof();
+		} else streamEnd = false;
+		size_t len = sizeof(out) - zs.avail_out;
+		if (len) {
+			setg(out, out, out + len);
+			return traits_type::to_int_type(*gptr());
+		}
+	}
+}
+
+XInflateBuf::~XInflateBuf()
+{
+	inflateEnd(&zs);
+}
+
+} // namespace pparam
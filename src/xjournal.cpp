@@ -0,0 +1,258 @@
+#include "xjournal.hpp"
+#include "xfile.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <vector>
+
+namespace pparam
+{
+
+/* Implementation of "XJournal" class.
+ */
+XJournal::XJournal(const string &_path, bool _sync) throw (Exception) :
+	path(_path),
+	sync(_sync),
+	fd(-1),
+	appended(0),
+	written(0),
+	writing(false),
+	end(0),
+	records(0),
+	syncs(0)
+{
+	pthread_mutex_init(&lock, NULL);
+	pthread_cond_init(&cond, NULL);
+	try {
+		open();
+	} catch (Exception &e) {
+		pthread_cond_destroy(&cond);
+		pthread_mutex_destroy(&lock);
+		e.addTracePoint(TracePoint("pparam"));
+		throw e;
+	}
+}
+
+void XJournal::open() throw (Exception)
+{
+	fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+	if (fd < 0)
+		throw Exception("Can't open journal " + path + " !: " +
+				strerror(errno), TracePoint("pparam"));
+	end = lseek(fd, 0, SEEK_END);
+}
+
+void XJournal::write(const string &data) throw (Exception)
+{
+	const char *buf = data.data();
+	size_t len = data.size();
+	while (len > 0) {
+		ssize_t ret = ::write(fd, buf, len);
+		if (ret < 0) {
+			if (errno == EINTR) continue;
+			throw Exception("Can't write to journal " + path +
+					" !: " + strerror(errno),
+					TracePoint("pparam"));
+		}
+		buf += ret;
+		len -= ret;
+	}
+	if (! sync) return;
+	if (fdatasync(fd) < 0)
+		throw Exception("Can't sync journal " + path + " !: " +
+				strerror(errno), TracePoint("pparam"));
+	++ syncs;
+}
+
+void XJournal::append(Op op, const string &key, const string &data)
+							throw (Exception)
+{
+	uint32_t klen = key.size();
+	string body;
+	body.reserve(1 + sizeof(klen) + key.size() + data.size());
+	body += (char)op;
+	body.append((const char *)&klen, sizeof(klen));
+	body += key;
+	body += data;
+	uint32_t len = body.size();
+	uint32_t crc = crc32(0, (const Bytef *)body.data(), body.size());
+
+	pthread_mutex_lock(&lock);
+	pending.append((const char *)&len, sizeof(len));
+	pending.append((const char *)&crc, sizeof(crc));
+	pending += body;
+	unsigned long seq = ++ appended;
+	while (written < seq) {
+		if (! error.empty()) {
+			string err = error;
+			pthread_mutex_unlock(&lock);
+			throw Exception("Journal " + path + " is broken !: " +
+					err, TracePoint("pparam"));
+		}
+		if (writing) {
+			/* Current writer may write our record too.
+			 */
+			pthread_cond_wait(&cond, &lock);
+			continue;
+		}
+		/* Write all of pending records by one write.
+		 */
+		writing = true;
+		string batch;
+		batch.swap(pending);
+		unsigned long last = appended;
+		pthread_mutex_unlock(&lock);
+		string err;
+		try {
+			write(batch);
+		} catch (Exception &e) {
+			err = e.what();
+		}
+		pthread_mutex_lock(&lock);
+		writing = false;
+		if (err.empty()) {
+			written = last;
+			end += batch.size();
+		} else
+			error = err;
+		pthread_cond_broadcast(&cond);
+	}
+	pthread_mutex_unlock(&lock);
+	++ records;
+}
+
+size_t XJournal::replay(Replayer &replayer) throw (Exception)
+{
+	struct Record
+	{
+		Op op;
+		string key;
+		string data;
+	};
+	std::vector<Record> recs;
+
+	pthread_mutex_lock(&lock);
+	while (writing) pthread_cond_wait(&cond, &lock);
+	string buf(end, '\0');
+	size_t done = 0;
+	while (done < buf.size()) {
+		ssize_t ret = pread(fd, &buf[done], buf.size() - done, done);
+		if (ret < 0 && errno == EINTR) continue;
+		if (ret <= 0) {
+			string err = (ret < 0) ? strerror(errno) :
+							"unexpected end";
+			pthread_mutex_unlock(&lock);
+			throw Exception("Can't read journal " + path + " !: " +
+					err, TracePoint("pparam"));
+		}
+		done += ret;
+	}
+	size_t pos = 0;
+	const size_t head = 2 * sizeof(uint32_t);
+	while (pos + head <= buf.size()) {
+		uint32_t len, crc, klen;
+		memcpy(&len, &buf[pos], sizeof(len));
+		memcpy(&crc, &buf[pos + sizeof(len)], sizeof(crc));
+		if ((len < 1 + sizeof(klen)) ||
+					(len > buf.size() - pos - head))
+			break;
+		const char *body = &buf[pos + head];
+		if (crc != crc32(0, (const Bytef *)body, len)) break;
+		memcpy(&klen, body + 1, sizeof(klen));
+		if (klen > len - 1 - sizeof(klen)) break;
+		Record r;
+		r.op = (Op)body[0];
+		r.key.assign(body + 1 + sizeof(klen), klen);
+		r.data.assign(body + 1 + sizeof(klen) + klen,
+					len - 1 - sizeof(klen) - klen);
+		recs.push_back(r);
+		pos += head + len;
+	}
+	if (pos < buf.size()) {
+		/* Cut torn records, so new records wouldn't be appended
+		 * after garbage.
+		 */
+		if (ftruncate(fd, pos) == 0) end = pos;
+	}
+	pthread_mutex_unlock(&lock);
+
+	for (size_t i = 0; i < recs.size(); ++i)
+		replayer.replay(recs[i].op, recs[i].key, recs[i].data);
+	return recs.size();
+}
+
+off_t XJournal::mark()
+{
+	pthread_mutex_lock(&lock);
+	off_t ret = end;
+	pthread_mutex_unlock(&lock);
+	return ret;
+}
+
+void XJournal::truncate(off_t offset) throw (Exception)
+{
+	pthread_mutex_lock(&lock);
+	while (writing) pthread_cond_wait(&cond, &lock);
+	if (offset > end) offset = end;
+	/* Keep records after "offset" in new journal.
+	 */
+	string rest(end - offset, '\0');
+	size_t done = 0;
+	while (done < rest.size()) {
+		ssize_t ret = pread(fd, &rest[done], rest.size() - done,
+							offset + done);
+		if (ret < 0 && errno == EINTR) continue;
+		if (ret <= 0) {
+			string err = (ret < 0) ? strerror(errno) :
+							"unexpected end";
+			pthread_mutex_unlock(&lock);
+			throw Exception("Can't read journal " + path + " !: " +
+					err, TracePoint("pparam"));
+		}
+		done += ret;
+	}
+	try {
+		XAtomicFile::save(path, rest);
+	} catch (Exception &e) {
+		pthread_mutex_unlock(&lock);
+		e.addTracePoint(TracePoint("pparam"));
+		throw e;
+	}
+	close(fd);
+	try {
+		open();
+	} catch (Exception &e) {
+		fd = -1;
+		error = e.what();
+		pthread_mutex_unlock(&lock);
+		e.addTracePoint(TracePoint("pparam"));
+		throw e;
+	}
+	/* Document has been saved, so failed records are in him.
+	 */
+	error.clear();
+	pthread_mutex_unlock(&lock);
+}
+
+off_t XJournal::size()
+{
+	pthread_mutex_lock(&lock);
+	off_t ret = end + pending.size();
+	pthread_mutex_unlock(&lock);
+	return ret;
+}
+
+XJournal::~XJournal()
+{
+	if (fd >= 0) close(fd);
+	pthread_cond_destroy(&cond);
+	pthread_mutex_destroy(&lock);
+}
+
+} // namespace pparam
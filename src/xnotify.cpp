@@ -0,0 +1,142 @@
+#include "xnotify.hpp"
+
+namespace pparam
+{
+
+/* Implementation of "XNotifyExecutor" class.
+ */
+XNotifyExecutor::XNotifyExecutor(int threads) throw (Exception) :
+	running(0),
+	stopping(false),
+	submitted(0),
+	coalesced(0),
+	delivered(0),
+	failed(0)
+{
+	pthread_mutex_init(&lock, NULL);
+	pthread_cond_init(&cond, NULL);
+	pthread_cond_init(&idle_cond, NULL);
+	if (threads < 1) threads = 1;
+	workers.resize(threads);
+	/* Executor would work with the started workers, the destructor
+	 * would join only them.
+	 */
+	int started = 0;
+	for (int i = 0; i < threads; ++i)
+		if (pthread_create(&workers[started], NULL, run, this) == 0)
+			++ started;
+	workers.resize(started);
+	if (started == 0) {
+		pthread_cond_destroy(&idle_cond);
+		pthread_cond_destroy(&cond);
+		pthread_mutex_destroy(&lock);
+		throw Exception("Can't create notification worker thread !",
+						TracePoint("pparam"));
+	}
+}
+
+bool XNotifyExecutor::submit(const void *key, Task *task)
+{
+	++ submitted;
+	pthread_mutex_lock(&lock);
+	Target &t = targets[key];
+	if (t.task) {
+		/* There is a pending notification, it would be enough.
+		 */
+		pthread_mutex_unlock(&lock);
+		++ coalesced;
+		delete task;
+		return false;
+	}
+	t.task = task;
+	/* Running target would be queued by his worker.
+	 */
+	if (!t.running && !t.queued) {
+		t.queued = true;
+		queue.push_back(key);
+		pthread_cond_signal(&cond);
+	}
+	pthread_mutex_unlock(&lock);
+	return true;
+}
+
+void XNotifyExecutor::flush()
+{
+	pthread_mutex_lock(&lock);
+	while (!queue.empty() || running)
+		pthread_cond_wait(&idle_cond, &lock);
+	pthread_mutex_unlock(&lock);
+}
+
+size_t XNotifyExecutor::get_queueDepth()
+{
+	pthread_mutex_lock(&lock);
+	size_t ret = queue.size();
+	pthread_mutex_unlock(&lock);
+	return ret;
+}
+
+void *XNotifyExecutor::run(void *arg)
+{
+	XNotifyExecutor *executor = (XNotifyExecutor *)arg;
+	pthread_mutex_lock(&executor->lock);
+	while (1) {
+		while (executor->queue.empty() && !executor->stopping)
+			pthread_cond_wait(&executor->cond, &executor->lock);
+		/* Stop just when all of tasks have been run.
+		 */
+		if (executor->queue.empty()) break;
+		const void *key = executor->queue.front();
+		executor->queue.pop_front();
+		Target &t = executor->targets[key];
+		Task *task = t.task;
+		t.task = NULL;
+		t.queued = false;
+		t.running = true;
+		++ executor->running;
+		pthread_mutex_unlock(&executor->lock);
+
+		/* Exceptions of a task shouldn't stop the worker, tasks
+		 * should report their errors themselves.
+		 */
+		try {
+			task->run();
+		} catch (...) {
+			++ executor->failed;
+		}
+		delete task;
+		++ executor->delivered;
+
+		pthread_mutex_lock(&executor->lock);
+		-- executor->running;
+		Target &r = executor->targets[key];
+		r.running = false;
+		if (r.task) {
+			/* Submitted while running.
+			 */
+			r.queued = true;
+			executor->queue.push_back(key);
+			pthread_cond_signal(&executor->cond);
+		} else
+			executor->targets.erase(key);
+		if (executor->queue.empty() && !executor->running)
+			pthread_cond_broadcast(&executor->idle_cond);
+	}
+	pthread_mutex_unlock(&executor->lock);
+	return NULL;
+}
+
+XNotifyExecutor::~XNotifyExecutor()
+{
+	pthread_mutex_lock(&lock);
+	stopping = true;
+	pthread_cond_broadcast(&cond);
+	pthread_mutex_unlock(&lock);
+	for (size_t i = 0; i < workers.size(); ++i)
+		pthread_join(workers[i], NULL);
+	pthread_cond_destroy(&idle_cond);
+	pthread_cond_destroy(&cond);
+	pthread_mutex_destroy(&lock);
+}
+
+} // namespace pparam
@@ -33,4 +33,48 @@ const XObjectStatus::StatusTransition
 		{  D, W, D, W, W, D, W, W, W, W},	/* 9 - PRINTING */
 	};
 
+// XTraversalEpoch Implementation
+
+std::atomic<unsigned> XTraversalEpoch::next(0);
+std::atomic<unsigned> XTraversalEpoch::slots[XTraversalEpoch::SLOTS];
+std::atomic<int> XTraversalEpoch::used(0);
+
+unsigned XTraversalEpoch::begin(bool &registered)
+{
+	unsigned epoch;
+	/* Zero stamp means not visited.
+	 */
+	while ((epoch = ++ next) == 0);
+	registered = false;
+	for (int i = 0; i < SLOTS; ++i) {
+		unsigned free = 0;
+		if (!slots[i].compare_exchange_strong(free, epoch)) continue;
+		int u = used.load();
+		while ((u < i + 1) && !used.compare_exchange_weak(u, i + 1));
+		registered = true;
+		break;
+	}
+	return epoch;
+}
+
+void XTraversalEpoch::end(unsigned epoch, bool registered)
+{
+	if (!registered) return;
+	int u = used.load();
+	for (int i = 0; i < u; ++i) {
+		if (slots[i].load() == epoch) {
+			slots[i].store(0);
+			break;
+		}
+	}
+}
+
+bool XTraversalEpoch::active(unsigned epoch)
+{
+	int u = used.load();
+	for (int i = 0; i < u; ++i)
+		if (slots[i].load() == epoch) return true;
+	return false;
+}
+
 } // namespace pparam
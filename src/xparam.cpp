@@ -1,6 +1,8 @@
 #include "xparam.hpp"
-#include <fstream>
+#include "xfile.hpp"
 #include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
 
 namespace pparam
 {
@@ -50,10 +52,36 @@ void XParam::loadXmlStr(string xstr, XParam::XmlParser *parser)
 
 void XParam::loadXmlDoc(string xdoc, XmlParser *parser) throw (Exception)
 {
+	/* Detect compressed documents by their first bytes.
+	 */
+	unsigned char magic[2];
+	XCompression::Type compression = XCompression::NONE;
+	int fd = open(xdoc.c_str(), O_RDONLY);
+	if (fd >= 0) {
+		ssize_t len = pread(fd, magic, sizeof(magic), 0);
+		if (len > 0)
+			compression = XCompression::detect(magic, len);
+		if (compression == XCompression::NONE) {
+			close(fd);
+			fd = -1;
+		}
+	}
+
 	XmlParser *_parser = (parser == NULL) ? new XmlParser : parser;
 	try {
 		_parser->set_substitute_entities();
-		_parser->parse_file(xdoc);
+		if (fd < 0) _parser->parse_file(xdoc);
+		else {
+			XInflateBuf buf(fd);
+			std::istream is(&buf);
+			_parser->parse_stream(is);
+			if (!buf.get_error().empty())
+				throw Exception("Can't read " + xdoc + " !: " +
+						buf.get_error(),
+						TracePoint("pparam"));
+			close(fd);
+			fd = -1;
+		}
 		if ((*_parser)) {
 			XmlNode *node =
 				_parser->get_document()->get_root_node();
@@ -62,10 +90,12 @@ void XParam::loadXmlDoc(string xdoc, XmlParser *parser) throw (Exception)
 			return;
 		}
 	} catch (std::exception &e) {
+		if (fd >= 0) close(fd);
 		throw Exception(
 			string("Can't parse xml document: ") + e.what(),
 			TracePoint("xpram"));
 	} catch (Exception &e) {
+		if (fd >= 0) close(fd);
 		e.addTracePoint(TracePoint("pparam"));
 		throw e;
 	}
@@ -78,7 +108,34 @@ void XParam::loadXmlDoc(string xdoc, XmlParser *parser) throw (Exception)
 }
 
 void XParam::saveXmlDoc(string xdoc, bool show_runtime, const int &indent,
-	bool with_endl) throw (Exception)
+	bool with_endl, XCompression::Type compression) throw (Exception)
+{
+	string endl = (with_endl) ? "\n" : "";
+	try {
+		XAtomicFile file(xdoc);
+		XDeflateBuf buf(file, 
+				XCompression::select(compression, xdoc));
+		std::ostream os(&buf);
+		try {
+			xmlStream(os, show_runtime, indent, endl);
+		} catch (std::exception &e) {
+			throw Exception("Can't generate xml to save " 
+					+ get_pname() + " !: " + e.what(), 
+					TracePoint("pparam"));
+		}
+		buf.finish();
+		file.commit();
+	} catch (Exception &e) {
+		e.addTracePoint(TracePoint("pparam"));
+		throw e;
+	}
+}
+
+XDocSaver::Result XParam::saveXmlDocAsync(string xdoc, bool show_runtime,
+				const int &indent, bool with_endl,
+				XDocSaver *saver, XDocSaver::FT_saveDone done,
+				void *arg, XCompression::Type compression)
+							throw (Exception)
 {
 	string sxml;
 	try {
@@ -88,21 +145,9 @@ void XParam::saveXmlDoc(string xdoc, bool show_runtime, const int &indent,
 				+ get_pname() + " !: " + e.what(), 
 				TracePoint("pparam"));
 	}
-	std::fstream xfile;
-	try {
-		xfile.open(xdoc.c_str(),
-			std::ios_base::trunc | std::ios_base::out);
-	} catch (std::exception &e) {
-		throw Exception("Can't open file to save " 
-				+ get_pname() + " !: " + e.what(),
-				TracePoint("pparam"));
-	}
-	if (xfile.fail())
-		throw Exception("Can't open file to save " 
-				+ get_pname() + " !",
-				TracePoint("pparam"));
-	xfile << sxml;
-	xfile.close();
+	if (saver == NULL) saver = XDocSaver::global();
+	return saver->save(xdoc, sxml, done, arg, 
+				XCompression::select(compression, xdoc));
 }
 
 string XParam::xml(bool show_runtime, const int &indent, bool with_endl) const
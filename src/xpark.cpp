@@ -0,0 +1,68 @@
+#include "xpark.hpp"
+
+#include <errno.h>
+#include <stdint.h>
+
+namespace pparam
+{
+
+/* Implementation of "XParkingLot" class.
+ */
+XParkingLot::Bucket *XParkingLot::table = NULL;
+pthread_once_t XParkingLot::once = PTHREAD_ONCE_INIT;
+
+void XParkingLot::init()
+{
+	pthread_condattr_t attr;
+	pthread_condattr_init(&attr);
+	/* Deadlines are monotonic.
+	 */
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	table = new Bucket[BUCKETS];
+	for (unsigned i = 0; i < BUCKETS; ++i) {
+		pthread_mutex_init(&table[i].lock, NULL);
+		pthread_cond_init(&table[i].cond, &attr);
+		table[i].waiters = 0;
+	}
+	pthread_condattr_destroy(&attr);
+}
+
+XParkingLot::Bucket *XParkingLot::bucket(const void *addr)
+{
+	pthread_once(&once, init);
+	uintptr_t h = (uintptr_t)addr;
+	/* Low bits are equal for aligned objects.
+	 */
+	h ^= h >> 4;
+	h *= 0x9e3779b1;
+	return &table[(h >> 8) & (BUCKETS - 1)];
+}
+
+bool XParkingLot::park(const void *addr, const std::atomic<unsigned> &word,
+			unsigned expected, const struct timespec *abstime)
+{
+	bool ret = true;
+	Bucket *b = bucket(addr);
+	pthread_mutex_lock(&b->lock);
+	if (word.load(std::memory_order_seq_cst) == expected) {
+		++ b->waiters;
+		if (!abstime)
+			pthread_cond_wait(&b->cond, &b->lock);
+		else if (pthread_cond_timedwait(&b->cond, &b->lock,
+						abstime) == ETIMEDOUT)
+			ret = false;
+		-- b->waiters;
+	}
+	pthread_mutex_unlock(&b->lock);
+	return ret;
+}
+
+void XParkingLot::unpark(const void *addr)
+{
+	Bucket *b = bucket(addr);
+	pthread_mutex_lock(&b->lock);
+	if (b->waiters) pthread_cond_broadcast(&b->cond);
+	pthread_mutex_unlock(&b->lock);
+}
+
+} // namespace pparam
@@ -0,0 +1,146 @@
+#include "xreclaimer.hpp"
+
+#include <unistd.h>
+
+namespace pparam
+{
+
+/* Implementation of "XReclaimer" class.
+ */
+XReclaimer::XReclaimer(unsigned _interval) throw (Exception) : 
+	stopping(false), 
+	interval(_interval),
+	reclaimed(0),
+	totalLatency(0),
+	maxLatency(0)
+{
+	pthread_mutex_init(&lock, NULL);
+	pthread_cond_init(&cond, NULL);
+	if (pthread_create(&thread, NULL, run, this) != 0) {
+		pthread_cond_destroy(&cond);
+		pthread_mutex_destroy(&lock);
+		throw Exception("Can't create reclaimer thread !",
+						TracePoint("pparam"));
+	}
+}
+
+void XReclaimer::enqueue(Job *job)
+{
+	clock_gettime(CLOCK_MONOTONIC, &job->queued);
+	pthread_mutex_lock(&lock);
+	queue.push_back(job);
+	if (queue.size() == 1) pthread_cond_signal(&cond);
+	pthread_mutex_unlock(&lock);
+}
+
+size_t XReclaimer::reclaim()
+{
+	size_t done = 0;
+	pthread_mutex_lock(&lock);
+	size_t n = queue.size();
+	pthread_mutex_unlock(&lock);
+	/* Jobs would be taken one by one, so many threads could reclaim
+	 * at the same time, and jobs of a nested wait would be found in
+	 * the queue.
+	 */
+	while (n--) {
+		pthread_mutex_lock(&lock);
+		if (queue.empty()) {
+			pthread_mutex_unlock(&lock);
+			break;
+		}
+		Job *job = queue.front();
+		queue.pop_front();
+		pthread_mutex_unlock(&lock);
+		if (job->ready()) {
+			finish(job);
+			++ done;
+		} else {
+			pthread_mutex_lock(&lock);
+			queue.push_back(job);
+			pthread_mutex_unlock(&lock);
+		}
+	}
+	return done;
+}
+
+void XReclaimer::wait(const std::atomic<unsigned> &pending)
+{
+	while (pending.load()) {
+		if (reclaim() == 0) usleep(interval);
+	}
+}
+
+void XReclaimer::finish(Job *job)
+{
+	struct timespec now;
+	job->dispose();
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	unsigned long latency = (now.tv_sec - job->queued.tv_sec) * 1000000 +
+			(now.tv_nsec - job->queued.tv_nsec) / 1000;
+	delete job;
+
+	++ reclaimed;
+	totalLatency += latency;
+	unsigned long max = maxLatency.load();
+	while ((latency > max) && 
+		!maxLatency.compare_exchange_weak(max, latency));
+}
+
+size_t XReclaimer::get_queueDepth()
+{
+	pthread_mutex_lock(&lock);
+	size_t ret = queue.size();
+	pthread_mutex_unlock(&lock);
+	return ret;
+}
+
+unsigned long XReclaimer::get_avgLatency() const
+{
+	unsigned long n = reclaimed.load();
+	return n ? totalLatency.load() / n : 0;
+}
+
+void *XReclaimer::run(void *arg)
+{
+	XReclaimer *reclaimer = (XReclaimer *)arg;
+	while (1) {
+		pthread_mutex_lock(&reclaimer->lock);
+		while (reclaimer->queue.empty() && !reclaimer->stopping)
+			pthread_cond_wait(&reclaimer->cond, &reclaimer->lock);
+		bool done = reclaimer->queue.empty();
+		pthread_mutex_unlock(&reclaimer->lock);
+		/* Stop just when all of jobs have been disposed.
+		 */
+		if (done) break;
+		if (reclaimer->reclaim() == 0) usleep(reclaimer->interval);
+	}
+	return NULL;
+}
+
+static XReclaimer *globalReclaimer = NULL;
+static pthread_once_t globalReclaimerOnce = PTHREAD_ONCE_INIT;
+
+static void createGlobalReclaimer()
+{
+	globalReclaimer = new XReclaimer;
+}
+
+XReclaimer *XReclaimer::global()
+{
+	pthread_once(&globalReclaimerOnce, createGlobalReclaimer);
+	return globalReclaimer;
+}
+
+XReclaimer::~XReclaimer()
+{
+	pthread_mutex_lock(&lock);
+	stopping = true;
+	pthread_cond_signal(&cond);
+	pthread_mutex_unlock(&lock);
+	pthread_join(thread, NULL);
+	pthread_cond_destroy(&cond);
+	pthread_mutex_destroy(&lock);
+}
+
+} // namespace pparam
@@ -0,0 +1,166 @@
+#include "xsaver.hpp"
+#include "xfile.hpp"
+
+#include <exception>
+
+namespace pparam
+{
+
+/* Implementation of "XDocSaver" class.
+ */
+XDocSaver::XDocSaver() throw (Exception) : busy(false), stopping(false)
+{
+	pthread_mutex_init(&lock, NULL);
+	pthread_cond_init(&work_cond, NULL);
+	pthread_cond_init(&idle_cond, NULL);
+	if (pthread_create(&thread, NULL, writer, this) != 0)
+		throw Exception("Can't create document writer thread !",
+						TracePoint("pparam"));
+}
+
+XDocSaver::Result XDocSaver::save(const string &path, const string &data,
+					FT_saveDone done, void *arg,
+					XCompression::Type compression)
+{
+	Waiter waiter;
+	waiter.promise = new std::promise<void>;
+	waiter.done = done;
+	waiter.arg = arg;
+	Result res = waiter.promise->get_future().share();
+
+	pthread_mutex_lock(&lock);
+	RequestMap::iterator iter = requests.find(path);
+	if (iter != requests.end()) {
+		/* Writer hasn't reached the older request yet, so replace
+		 * his data with the newer snapshot.
+		 */
+		iter->second->data = data;
+		iter->second->compression = compression;
+		iter->second->waiters.push_back(waiter);
+	} else {
+		Request *req = new Request;
+		req->data = data;
+		req->compression = compression;
+		req->waiters.push_back(waiter);
+		requests[path] = req;
+		queue.push_back(path);
+		pthread_cond_signal(&work_cond);
+	}
+	pthread_mutex_unlock(&lock);
+	return res;
+}
+
+void XDocSaver::flush()
+{
+	pthread_mutex_lock(&lock);
+	while (!queue.empty() || busy)
+		pthread_cond_wait(&idle_cond, &lock);
+	pthread_mutex_unlock(&lock);
+}
+
+size_t XDocSaver::pending()
+{
+	pthread_mutex_lock(&lock);
+	size_t ret = queue.size();
+	pthread_mutex_unlock(&lock);
+	return ret;
+}
+
+static XDocSaver *globalSaver = NULL;
+static pthread_once_t globalSaverOnce = PTHREAD_ONCE_INIT;
+
+static void createGlobalSaver()
+{
+	globalSaver = new XDocSaver;
+}
+
+XDocSaver *XDocSaver::global()
+{
+	pthread_once(&globalSaverOnce, createGlobalSaver);
+	return globalSaver;
+}
+
+void *XDocSaver::writer(void *arg)
+{
+	((XDocSaver *)arg)->run();
+	return NULL;
+}
+
+void XDocSaver::run()
+{
+	pthread_mutex_lock(&lock);
+	while (1) {
+		while (queue.empty() && !stopping)
+			pthread_cond_wait(&work_cond, &lock);
+		if (queue.empty()) break;
+
+		string path = queue.front();
+		queue.pop_front();
+		RequestMap::iterator iter = requests.find(path);
+		Request *req = iter->second;
+		/* From now, new requests for this path would be queued
+		 * as a new write.
+		 */
+		requests.erase(iter);
+		busy = true;
+		pthread_mutex_unlock(&lock);
+
+		/* Errors of write would be given to all of waiters, so
+		 * waiters of this batch would be completed once.
+		 */
+		Exception err("", TracePoint("pparam"));
+		bool failed = false;
+		try {
+			XAtomicFile file(path);
+			XDeflateBuf buf(file, req->compression);
+			buf.sputn(req->data.data(), req->data.size());
+			buf.finish();
+			file.commit();
+		} catch (Exception &e) {
+			e.addTracePoint(TracePoint("pparam"));
+			err = e;
+			failed = true;
+		} catch (std::exception &e) {
+			err = Exception("Can't write " + path + " !: " +
+					e.what(), TracePoint("pparam"));
+			failed = true;
+		}
+		complete(path, req, failed ? &err : NULL);
+		delete req;
+
+		pthread_mutex_lock(&lock);
+		busy = false;
+		if (queue.empty())
+			pthread_cond_broadcast(&idle_cond);
+	}
+	pthread_mutex_unlock(&lock);
+}
+
+void XDocSaver::complete(const string &path, Request *req,
+						const Exception *err)
+{
+	for (std::vector<Waiter>::iterator iter = req->waiters.begin();
+				iter != req->waiters.end(); ++iter) {
+		if (iter->done) iter->done(path, err, iter->arg);
+		if (err) iter->promise->set_exception(
+					std::make_exception_ptr(*err));
+		else iter->promise->set_value();
+		delete iter->promise;
+	}
+}
+
+XDocSaver::~XDocSaver()
+{
+	pthread_mutex_lock(&lock);
+	stopping = true;
+	pthread_cond_signal(&work_cond);
+	pthread_mutex_unlock(&lock);
+	/* Writer would finish queued requests before exit.
+	 */
+	pthread_join(thread, NULL);
+	pthread_cond_destroy(&idle_cond);
+	pthread_cond_destroy(&work_cond);
+	pthread_mutex_destroy(&lock);
+}
+
+} // namespace pparam
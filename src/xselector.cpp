@@ -0,0 +1,217 @@
+#include "xselector.hpp"
+
+namespace pparam
+{
+
+/* Implementation of "XParamSelector" class.
+ */
+XParamSelector::XParamSelector(const string &_path) throw (Exception) :
+	path(_path)
+{
+	try {
+		compile();
+	} catch (Exception &e) {
+		for (size_t i = 0; i < steps.size(); ++i) delete steps[i];
+		steps.clear();
+		e.addTracePoint(TracePoint("pparam"));
+		throw e;
+	}
+}
+
+/**
+ * Read one token of path from "pos" until one of "stops" characters.
+ * Token may be quoted by ' or ".
+ */
+static bool readToken(const string &path, size_t &pos, const char *stops,
+								string &token)
+{
+	size_t len = path.size();
+	if ((pos < len) && ((path[pos] == '\'') || (path[pos] == '"'))) {
+		char quote = path[pos];
+		size_t end = path.find(quote, pos + 1);
+		if (end == string::npos) return false;
+		token = path.substr(pos + 1, end - pos - 1);
+		pos = end + 1;
+		return true;
+	}
+	size_t end = path.find_first_of(stops, pos);
+	if (end == string::npos) end = len;
+	token = path.substr(pos, end - pos);
+	pos = end;
+	return true;
+}
+
+void XParamSelector::compile() throw (Exception)
+{
+	size_t pos = 0, len = path.size();
+	/* Leading '/' means nothing, root is always the start point.
+	 */
+	while ((pos < len) && (path[pos] == '/')) ++pos;
+	while (pos < len) {
+		Step *step = new Step;
+		steps.push_back(step);
+
+		size_t end = path.find_first_of("/[", pos);
+		if (end == string::npos) end = len;
+		step->name = path.substr(pos, end - pos);
+		pos = end;
+		if (step->name.empty())
+			throw Exception("Empty step in path \"" + path + "\" !",
+							TracePoint("pparam"));
+		step->any = (step->name == "*");
+
+		if ((pos < len) && (path[pos] == '[')) {
+			string token;
+			++pos;
+			if (!readToken(path, pos, "=]", token))
+				throw Exception("Unterminated quote in path \"" +
+						path + "\" !",
+						TracePoint("pparam"));
+			if ((pos < len) && (path[pos] == '=')) {
+				if (token.empty())
+					throw Exception("Empty field in path \""
+						+ path + "\" !",
+						TracePoint("pparam"));
+				step->field = token;
+				step->predicate = Step::FIELD;
+				++pos;
+				if (!readToken(path, pos, "]", token))
+					throw Exception("Unterminated quote in "
+						"path \"" + path + "\" !",
+						TracePoint("pparam"));
+			} else step->predicate = Step::KEY;
+			step->value = token;
+			if ((pos >= len) || (path[pos] != ']'))
+				throw Exception("Missing ']' in path \"" +
+						path + "\" !",
+						TracePoint("pparam"));
+			++pos;
+		}
+		if (pos < len) {
+			if (path[pos] != '/')
+				throw Exception("Bad character after ']' in "
+						"path \"" + path + "\" !",
+						TracePoint("pparam"));
+			if (++pos == len)
+				throw Exception("Empty step in path \"" +
+						path + "\" !",
+						TracePoint("pparam"));
+		}
+	}
+	if (steps.empty())
+		throw Exception("Empty path !", TracePoint("pparam"));
+}
+
+XParam *XParamSelector::first(const XParam *root) const
+{
+	Context ctx = { NULL, NULL, 0 };
+	if (root) walk(root, 0, ctx);
+	return ctx.first;
+}
+
+size_t XParamSelector::select(const XParam *root,
+				std::vector<XParam *> &result) const
+{
+	Context ctx = { NULL, &result, 0 };
+	if (root) walk(root, 0, ctx);
+	return ctx.count;
+}
+
+bool XParamSelector::walk(const XParam *node, size_t index,
+						Context &ctx) const
+{
+	if (index == steps.size()) {
+		XParam *param = const_cast<XParam *>(node);
+		++ ctx.count;
+		if (ctx.result) {
+			ctx.result->push_back(param);
+			return false;
+		}
+		ctx.first = param;
+		return true;
+	}
+
+	const Step &step = *steps[index];
+	const XParam *skip = NULL;
+	if (step.predicate != Step::NONE) {
+		XParam *child;
+		if (node->findChildByKey(step.value, child)) {
+			bool nameOK = child &&
+				(step.any || (child->get_pname() == step.name));
+			/* Key lookup is the final answer for key predicates.
+			 */
+			if (step.predicate == Step::KEY)
+				return nameOK && walk(child, index + 1, ctx);
+			/* "field" may not be key of the set, so other children
+			 * would be scanned too.
+			 */
+			if (nameOK && fieldMatch(step, child) &&
+					walk(child, index + 1, ctx))
+				return true;
+			skip = child;
+		}
+	} else if (!step.any && !ctx.result) {
+		size_t hint = step.nameHint.load(std::memory_order_relaxed);
+		XParam *child = node->findChild(step.name, hint);
+		if (!child) return false;
+		step.nameHint.store(hint, std::memory_order_relaxed);
+		if (walk(child, index + 1, ctx)) return true;
+		/* There may be other children with the same name.
+		 */
+		skip = child;
+	}
+	return scan(node, index, ctx, skip);
+}
+
+bool XParamSelector::scan(const XParam *node, size_t index, Context &ctx,
+						const XParam *skip) const
+{
+	ScanArg arg = { this, index, &ctx, skip, false };
+	node->visitChildren(scanVisitor, &arg);
+	return arg.stopped;
+}
+
+bool XParamSelector::scanVisitor(XParam *child, void *_arg)
+{
+	ScanArg *arg = (ScanArg *)_arg;
+	if (child == arg->skip) return true;
+	const XParamSelector *selector = arg->selector;
+	if (!selector->match(*selector->steps[arg->index], child)) return true;
+	if (selector->walk(child, arg->index + 1, *arg->ctx)) {
+		arg->stopped = true;
+		return false;
+	}
+	return true;
+}
+
+bool XParamSelector::match(const Step &step, const XParam *param) const
+{
+	if (!step.any && (param->get_pname() != step.name)) return false;
+	switch (step.predicate) {
+	case Step::NONE:
+		return true;
+	case Step::KEY:
+		/* Set doesn't have search map.
+		 */
+		return param->get_key() == step.value;
+	case Step::FIELD:
+		return fieldMatch(step, param);
+	}
+	return false;
+}
+
+bool XParamSelector::fieldMatch(const Step &step, const XParam *param) const
+{
+	size_t hint = step.fieldHint.load(std::memory_order_relaxed);
+	XParam *field = param->findChild(step.field, hint);
+	if (!field) return false;
+	step.fieldHint.store(hint, std::memory_order_relaxed);
+	return field->value_equals(step.value);
+}
+
+XParamSelector::~XParamSelector()
+{
+	for (size_t i = 0; i < steps.size(); ++i) delete steps[i];
+}
+
+} // namespace pparam
@@ -0,0 +1,96 @@
+#include "xshardedlist.hpp"
+
+namespace pparam
+{
+
+/* Implementation of "XStripedIndex" class.
+ */
+XStripedIndex::XStripedIndex()
+{
+	for (int i = 0; i < STRIPES; ++i)
+		pthread_mutex_init(&stripes[i].lock, NULL);
+}
+
+XStripedIndex::Stripe &XStripedIndex::stripe(const string &key)
+{
+	return stripes[std::hash<string>()(key) % STRIPES];
+}
+
+bool XStripedIndex::exists(Map &map, const string &key, const string &value)
+{
+	std::pair<Map::iterator, Map::iterator> range = map.equal_range(key);
+	for (Map::iterator iter = range.first; iter != range.second; ++iter)
+		if (iter->second == value) return true;
+	return false;
+}
+
+bool XStripedIndex::reserve(const string &key, const string &value,
+					FT_conflict conflict, void *arg)
+{
+	Stripe &s = stripe(key);
+	pthread_mutex_lock(&s.lock);
+	bool found = false;
+	std::pair<Map::iterator, Map::iterator> range = s.map.equal_range(key);
+	for (Map::iterator iter = range.first; iter != range.second; ++iter) {
+		if (iter->second == value) {
+			found = true;
+			continue;
+		}
+		if (!conflict || conflict(key, value, iter->second, arg)) {
+			pthread_mutex_unlock(&s.lock);
+			return false;
+		}
+	}
+	if (!found) s.map.insert(std::make_pair(key, value));
+	pthread_mutex_unlock(&s.lock);
+	return true;
+}
+
+void XStripedIndex::insert(const string &key, const string &value)
+{
+	Stripe &s = stripe(key);
+	pthread_mutex_lock(&s.lock);
+	if (!exists(s.map, key, value))
+		s.map.insert(std::make_pair(key, value));
+	pthread_mutex_unlock(&s.lock);
+}
+
+void XStripedIndex::erase(const string &key, const string &value)
+{
+	Stripe &s = stripe(key);
+	pthread_mutex_lock(&s.lock);
+	std::pair<Map::iterator, Map::iterator> range = s.map.equal_range(key);
+	for (Map::iterator iter = range.first; iter != range.second; ++iter)
+		if (iter->second == value) {
+			s.map.erase(iter);
+			break;
+		}
+	pthread_mutex_unlock(&s.lock);
+}
+
+void XStripedIndex::find(const string &key, std::vector<string> &values)
+{
+	Stripe &s = stripe(key);
+	pthread_mutex_lock(&s.lock);
+	std::pair<Map::iterator, Map::iterator> range = s.map.equal_range(key);
+	for (Map::iterator iter = range.first; iter != range.second; ++iter)
+		values.push_back(iter->second);
+	pthread_mutex_unlock(&s.lock);
+}
+
+void XStripedIndex::clear()
+{
+	for (int i = 0; i < STRIPES; ++i) {
+		pthread_mutex_lock(&stripes[i].lock);
+		stripes[i].map.clear();
+		pthread_mutex_unlock(&stripes[i].lock);
+	}
+}
+
+XStripedIndex::~XStripedIndex()
+{
+	for (int i = 0; i < STRIPES; ++i)
+		pthread_mutex_destroy(&stripes[i].lock);
+}
+
+} // namespace pparam
@@ -0,0 +1,67 @@
+#include "xsnapshot.hpp"
+
+#include <sstream>
+
+namespace pparam
+{
+
+/* Implementation of "XObjectSnapshot" class.
+ */
+XObjectSnapshot::XObjectSnapshot(const string &_pname, const string &ver,
+				const int &_indent, const string &_endl) :
+	pname(_pname),
+	version(ver),
+	indent(_indent),
+	endl(_endl)
+{
+}
+
+size_t XObjectSnapshot::size() const
+{
+	size_t ret = images.size();
+	for (size_t i = 0; i < children.size(); ++i)
+		ret += children[i].size();
+	return ret;
+}
+
+void XObjectSnapshot::xmlStream(std::ostream &os) const
+{
+	string ind(indent, ' ');
+	string ver = (version.empty()) ? "" : " ver=\"" + version + "\"";
+	os << ind << "<" << pname << ver << ">" << endl;
+	for (size_t i = 0; i < images.size(); ++i)
+		os << *images[i];
+	for (size_t i = 0; i < children.size(); ++i)
+		children[i].xmlStream(os);
+	os << ind << "</" << pname << ">" << endl;
+}
+
+string XObjectSnapshot::xml() const
+{
+	std::ostringstream os;
+	xmlStream(os);
+	return os.str();
+}
+
+void XObjectSnapshot::save(const string &xdoc, 
+			XCompression::Type compression) throw (Exception)
+{
+	try {
+		XAtomicFile file(xdoc);
+		XDeflateBuf buf(file, XCompression::select(compression, xdoc));
+		std::ostream os(&buf);
+		try {
+			xmlStream(os);
+		} catch (std::exception &e) {
+			throw Exception("Can't write snapshot of " + pname + 
+					" !: " + e.what(), TracePoint("pparam"));
+		}
+		buf.finish();
+		file.commit();
+	} catch (Exception &e) {
+		e.addTracePoint(TracePoint("pparam"));
+		throw e;
+	}
+}
+
+} // namespace pparam